@@ -0,0 +1,82 @@
+#include "BenchmarkReporter.hpp"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+
+#include <algorithm>
+#include <numeric>
+
+BenchmarkReporter& BenchmarkReporter::instance() {
+  static BenchmarkReporter reporter;
+  return reporter;
+}
+
+void BenchmarkReporter::setOutputPath(const QString& path) {
+  _outputPath = path;
+}
+
+const QString& BenchmarkReporter::outputPath() const {
+  return _outputPath;
+}
+
+void BenchmarkReporter::addSample(qint64 nsecs, qint64 bytes) {
+  auto name = QString(QTest::currentTestFunction());
+  if (const auto* dataTag = QTest::currentDataTag()) {
+    name += ':' + QString(dataTag);
+  }
+  auto& samples = _samples[name];
+  samples.durations.append(nsecs);
+  samples.bytes = bytes;
+}
+
+bool BenchmarkReporter::write() const {
+  if (_outputPath.isEmpty()) {
+    return true;
+  }
+
+  QJsonArray benchmarks;
+  for (auto it = _samples.cbegin(); it != _samples.cend(); ++it) {
+    auto durations = it.value().durations;
+    if (durations.isEmpty()) {
+      continue;
+    }
+    std::sort(durations.begin(), durations.end());
+    const auto total = std::accumulate(durations.cbegin(), durations.cend(), qint64{ 0 });
+    const auto median = durations.at(durations.size() / 2);
+    const auto bytes = it.value().bytes;
+
+    QJsonObject benchmark{
+      { "name", it.key() },
+      { "iterations", durations.size() },
+      { "minNs", durations.first() },
+      { "medianNs", median },
+      { "meanNs", static_cast<double>(total) / durations.size() },
+      { "maxNs", durations.last() },
+    };
+    if (bytes > 0 && median > 0) {
+      benchmark.insert("bytes", bytes);
+      benchmark.insert("bytesPerSecond", bytes * 1e9 / median);
+    }
+    benchmarks.append(benchmark);
+  }
+
+  QFile file(_outputPath);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  const QJsonObject root{ { "benchmarks", benchmarks } };
+  file.write(QJsonDocument(root).toJson());
+  return true;
+}
+
+ScopedSample::ScopedSample(qint64 bytes)
+  : _bytes(bytes) {
+  _timer.start();
+}
+
+ScopedSample::~ScopedSample() {
+  BenchmarkReporter::instance().addSample(_timer.nsecsElapsed(), _bytes);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QString>
+#include <QMap>
+#include <QVector>
+#include <QElapsedTimer>
+
+/**
+ * @brief Collects benchmark samples and writes them as JSON, to track regressions.
+ */
+class BenchmarkReporter {
+public:
+  static BenchmarkReporter& instance();
+
+  void setOutputPath(const QString& path);
+  const QString& outputPath() const;
+
+  // Adds a sample for the current test function (and data tag, if any).
+  void addSample(qint64 nsecs, qint64 bytes = 0);
+
+  bool write() const;
+
+private:
+  struct Samples {
+    QVector<qint64> durations;
+    qint64 bytes{ 0 };
+  };
+
+  QString _outputPath;
+  QMap<QString, Samples> _samples;
+};
+
+/**
+ * @brief Measures the duration of its scope and adds it as a sample.
+ */
+class ScopedSample {
+public:
+  explicit ScopedSample(qint64 bytes = 0);
+  ~ScopedSample();
+
+private:
+  QElapsedTimer _timer;
+  qint64 _bytes{ 0 };
+};
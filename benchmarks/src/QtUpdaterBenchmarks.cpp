@@ -0,0 +1,334 @@
+#include "QtUpdaterBenchmarks.hpp"
+#include "BenchmarkReporter.hpp"
+
+#include <httplib.h>
+#include <oclero/QtDownloader.hpp>
+#include <oclero/QtUpdater.hpp>
+#include <oclero/UpdateJSON.hpp>
+
+#include <QCryptographicHash>
+#include <QCoreApplication>
+#include <QDate>
+#include <QFile>
+#include <QFileInfo>
+#include <QTest>
+
+#include <thread>
+
+using namespace oclero;
+
+namespace {
+constexpr auto CURRENT_VERSION = "1.0.0";
+constexpr auto LATEST_VERSION = "2.0.0";
+constexpr auto SERVER_PORT = 8081;
+constexpr auto SERVER_HOST = "0.0.0.0";
+constexpr auto SERVER_URL = "localhost";
+
+constexpr auto APPCAST_QUERY_REGEX = R"(\/appcast-(\d+))";
+constexpr auto DATA_QUERY_REGEX = R"(\/data-(\d+))";
+constexpr auto INSTALLER_QUERY_REGEX = R"(\/installer-(\d+)\.exe)";
+
+constexpr auto CONTENT_TYPE_JSON = "application/json";
+constexpr auto CONTENT_TYPE_BINARY = "application/octet-stream";
+
+constexpr qint64 KB = 1024;
+constexpr qint64 MB = 1024 * KB;
+constexpr qint64 GB = 1024 * MB;
+constexpr qint64 PATTERN_SIZE = 64 * KB;
+constexpr qint64 CHECKSUM_FILE_SIZE = 256 * MB;
+constexpr qint64 END_TO_END_SIZE = 16 * MB;
+constexpr int DOWNLOAD_TIMEOUT = 120000;
+
+// Set this environment variable to also run the 1 GB benchmarks.
+constexpr auto ENV_LARGE_BENCHMARKS = "QTUPDATER_BENCHMARK_LARGE";
+
+constexpr auto APPCAST_TEMPLATE = R"({
+  "version": "%1",
+  "date": "%2",
+  "checksum": "%3",
+  "checksumType": "md5",
+  "installerUrl": "%4/installer-%5.exe"
+})";
+
+static const QString SERVER_URL_FOR_CLIENT = "http://" + QString(SERVER_URL) + ':' + QString::number(SERVER_PORT);
+
+// Deterministic content, generated on the fly so that large files are never held in memory.
+const QByteArray& getPattern() {
+  static const auto pattern = []() {
+    QByteArray result(PATTERN_SIZE, Qt::Uninitialized);
+    for (auto i = 0; i < result.size(); ++i) {
+      result[i] = static_cast<char>((i * 31 + i / 251) & 0xff);
+    }
+    return result;
+  }();
+  return pattern;
+}
+
+QString getPatternChecksum(qint64 size) {
+  const auto& pattern = getPattern();
+  QCryptographicHash hash(QCryptographicHash::Algorithm::Md5);
+  for (qint64 offset = 0; offset < size; offset += pattern.size()) {
+    hash.addData(pattern.constData(), static_cast<int>(std::min<qint64>(pattern.size(), size - offset)));
+  }
+  return hash.result().toHex();
+}
+
+QString getAppCast(qint64 installerSize) {
+  const auto todayDate = QDate::currentDate().toString("dd/MM/yyyy");
+  return QString(APPCAST_TEMPLATE)
+    .arg(LATEST_VERSION)
+    .arg(todayDate)
+    .arg(getPatternChecksum(installerSize))
+    .arg(SERVER_URL_FOR_CLIENT)
+    .arg(installerSize);
+}
+
+void setPatternContent(httplib::Response& response, qint64 size) {
+  response.set_content_provider(static_cast<size_t>(size), CONTENT_TYPE_BINARY,
+    [](size_t offset, size_t length, httplib::DataSink& sink) {
+      const auto& pattern = getPattern();
+      const auto patternOffset = offset % pattern.size();
+      const auto chunkLength = std::min<size_t>(length, pattern.size() - patternOffset);
+      return sink.write(pattern.constData() + patternOffset, chunkLength);
+    });
+}
+
+bool writePatternFile(const QString& path, qint64 size) {
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  const auto& pattern = getPattern();
+  for (qint64 offset = 0; offset < size; offset += pattern.size()) {
+    file.write(pattern.constData(), std::min<qint64>(pattern.size(), size - offset));
+  }
+  return true;
+}
+
+template<typename Predicate>
+bool waitFor(Predicate&& predicate) {
+  return QTest::qWaitFor(std::forward<Predicate>(predicate), DOWNLOAD_TIMEOUT);
+}
+} // namespace
+
+struct Benchmarks::Server {
+  httplib::Server server;
+  std::thread thread;
+
+  Server() {
+    server.Get(APPCAST_QUERY_REGEX, [](const httplib::Request& request, httplib::Response& response) {
+      const auto installerSize = std::stoll(request.matches[1]);
+      response.set_content(getAppCast(installerSize).toStdString(), CONTENT_TYPE_JSON);
+    });
+    server.Get(DATA_QUERY_REGEX, [](const httplib::Request& request, httplib::Response& response) {
+      setPatternContent(response, std::stoll(request.matches[1]));
+    });
+    server.Get(INSTALLER_QUERY_REGEX, [](const httplib::Request& request, httplib::Response& response) {
+      setPatternContent(response, std::stoll(request.matches[1]));
+    });
+
+    thread = std::thread([this]() {
+      server.listen(SERVER_HOST, SERVER_PORT);
+    });
+    server.wait_until_ready();
+  }
+
+  ~Server() {
+    server.stop();
+    thread.join();
+  }
+};
+
+Benchmarks::Benchmarks(QObject* parent)
+  : QObject(parent) {}
+
+Benchmarks::~Benchmarks() = default;
+
+void Benchmarks::initTestCase() {
+  QVERIFY(_tempDir.isValid());
+  _server = std::make_unique<Server>();
+  QVERIFY(_server->server.is_running());
+}
+
+void Benchmarks::cleanupTestCase() {
+  _server.reset();
+}
+
+QString Benchmarks::getChecksumFilePath() {
+  const auto filePath = _tempDir.filePath("checksum.bin");
+  if (!QFile::exists(filePath) && !writePatternFile(filePath, CHECKSUM_FILE_SIZE)) {
+    return {};
+  }
+  return filePath;
+}
+
+void Benchmarks::benchmark_checkForUpdate() {
+  const auto url = SERVER_URL_FOR_CLIENT + "/appcast-" + QString::number(MB);
+  QtUpdater updater(url);
+  updater.setTemporaryDirectoryPath(_tempDir.filePath("check"));
+
+  QBENCHMARK {
+    ScopedSample sample;
+    auto done = false;
+    const auto connection = QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+      done = true;
+    });
+    updater.forceCheckForUpdate();
+    QVERIFY(waitFor([&done]() {
+      return done;
+    }));
+    QObject::disconnect(connection);
+  }
+  QVERIFY(updater.latestVersion() == LATEST_VERSION);
+}
+
+void Benchmarks::benchmark_downloadData() {
+  const auto size = MB;
+  const auto url = QUrl(SERVER_URL_FOR_CLIENT + "/data-" + QString::number(size));
+  QtDownloader downloader;
+
+  QBENCHMARK {
+    ScopedSample sample(size);
+    auto done = false;
+    auto receivedSize = qint64{ 0 };
+    downloader.downloadData(url, [&done, &receivedSize](QtDownloader::ErrorCode const, const QByteArray& data) {
+      receivedSize = data.size();
+      done = true;
+    });
+    QVERIFY(waitFor([&done]() {
+      return done;
+    }));
+    QCOMPARE(receivedSize, size);
+  }
+}
+
+void Benchmarks::benchmark_downloadFile_data() {
+  QTest::addColumn<qint64>("size");
+  QTest::newRow("1MB") << MB;
+  QTest::newRow("100MB") << 100 * MB;
+  if (qEnvironmentVariableIsSet(ENV_LARGE_BENCHMARKS)) {
+    QTest::newRow("1GB") << GB;
+  }
+}
+
+void Benchmarks::benchmark_downloadFile() {
+  QFETCH(qint64, size);
+  const auto url = QUrl(SERVER_URL_FOR_CLIENT + "/data-" + QString::number(size));
+  const auto dir = _tempDir.filePath("download");
+  QtDownloader downloader;
+
+  QBENCHMARK {
+    ScopedSample sample(size);
+    auto done = false;
+    auto filePath = QString{};
+    downloader.downloadFile(
+      url, dir,
+      [&done, &filePath](QtDownloader::ErrorCode const, const QString& path) {
+        filePath = path;
+        done = true;
+      },
+      nullptr, DOWNLOAD_TIMEOUT);
+    QVERIFY(waitFor([&done]() {
+      return done;
+    }));
+    QCOMPARE(QFileInfo(filePath).size(), size);
+  }
+}
+
+void Benchmarks::benchmark_verifyFileChecksum_data() {
+  QTest::addColumn<QtDownloader::ChecksumType>("checksumType");
+  QTest::newRow("md5") << QtDownloader::ChecksumType::MD5;
+  QTest::newRow("sha1") << QtDownloader::ChecksumType::SHA1;
+  QTest::newRow("sha256") << QtDownloader::ChecksumType::SHA256;
+  QTest::newRow("sha256_tree") << QtDownloader::ChecksumType::SHA256_TREE;
+}
+
+void Benchmarks::benchmark_verifyFileChecksum() {
+  QFETCH(QtDownloader::ChecksumType, checksumType);
+  const auto filePath = getChecksumFilePath();
+  QVERIFY(!filePath.isEmpty());
+
+  // The checksum is wrong on purpose: the whole file is hashed anyway.
+  const auto checksum = QString(2 * QCryptographicHash::hashLength(QCryptographicHash::Sha256), '0');
+  QBENCHMARK {
+    ScopedSample sample(CHECKSUM_FILE_SIZE);
+    QtDownloader::verifyFileChecksum(
+      filePath, checksum, checksumType, QtDownloader::InvalidChecksumBehavior::KeepFile);
+  }
+  QVERIFY(QFile::exists(filePath));
+}
+
+void Benchmarks::benchmark_hashFileWithQIODevice_data() {
+  QTest::addColumn<QCryptographicHash::Algorithm>("algorithm");
+  QTest::newRow("md5") << QCryptographicHash::Md5;
+  QTest::newRow("sha1") << QCryptographicHash::Sha1;
+  QTest::newRow("sha256") << QCryptographicHash::Sha256;
+}
+
+// Baseline for benchmark_verifyFileChecksum(): the file is read through QIODevice's small buffers.
+void Benchmarks::benchmark_hashFileWithQIODevice() {
+  QFETCH(QCryptographicHash::Algorithm, algorithm);
+  const auto filePath = getChecksumFilePath();
+  QVERIFY(!filePath.isEmpty());
+
+  QBENCHMARK {
+    ScopedSample sample(CHECKSUM_FILE_SIZE);
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCryptographicHash hash(algorithm);
+    QVERIFY(hash.addData(&file));
+  }
+}
+
+void Benchmarks::benchmark_parseUpdateJSON() {
+  const auto data = getAppCast(MB).toUtf8();
+
+  QBENCHMARK {
+    ScopedSample sample(data.size());
+    const auto json = UpdateJSON{ data };
+    QVERIFY(json.isValid());
+  }
+}
+
+void Benchmarks::benchmark_checkDownloadVerify() {
+  const auto url = SERVER_URL_FOR_CLIENT + "/appcast-" + QString::number(END_TO_END_SIZE);
+  auto iteration = 0;
+
+  QBENCHMARK {
+    ScopedSample sample(END_TO_END_SIZE);
+    QtUpdater updater(url);
+    updater.setTemporaryDirectoryPath(_tempDir.filePath("e2e-" + QString::number(iteration++)));
+    // Always hash the installer, to measure the verification too.
+    updater.setParanoidVerification(true);
+
+    auto done = false;
+    auto failed = false;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+      done = true;
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+      done = true;
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFailed, this, [&done, &failed]() {
+      failed = true;
+      done = true;
+    });
+    QObject::connect(&updater, &QtUpdater::installationFailed, this, [&failed]() {
+      failed = true;
+    });
+
+    updater.forceCheckForUpdate();
+    QVERIFY(waitFor([&done]() {
+      return done;
+    }));
+    QVERIFY(updater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+
+    done = false;
+    updater.downloadInstaller();
+    QVERIFY(waitFor([&done]() {
+      return done;
+    }));
+    updater.installUpdate(/*dry*/ true);
+    QVERIFY(!failed);
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <memory>
+
+class Benchmarks : public QObject {
+  Q_OBJECT
+
+public:
+  explicit Benchmarks(QObject* parent = nullptr);
+  ~Benchmarks();
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  void benchmark_checkForUpdate();
+  void benchmark_downloadData();
+  void benchmark_downloadFile_data();
+  void benchmark_downloadFile();
+  void benchmark_verifyFileChecksum_data();
+  void benchmark_verifyFileChecksum();
+  void benchmark_hashFileWithQIODevice_data();
+  void benchmark_hashFileWithQIODevice();
+  void benchmark_parseUpdateJSON();
+  void benchmark_checkDownloadVerify();
+
+private:
+  QString getChecksumFilePath();
+
+  struct Server;
+  std::unique_ptr<Server> _server;
+  QTemporaryDir _tempDir;
+};
@@ -0,0 +1,30 @@
+#include <QTest>
+#include <QCoreApplication>
+
+#include "BenchmarkReporter.hpp"
+#include "QtUpdaterBenchmarks.hpp"
+
+int main(int argc, char* argv[]) {
+  QTEST_SET_MAIN_SOURCE_PATH;
+
+  // Necessary to get a socket name and to have an event loop running.
+  QCoreApplication::setApplicationName("QtUpdaterBenchmarks");
+  QCoreApplication::setApplicationVersion("1.0.0");
+  QCoreApplication::setOrganizationName("oclero");
+  QCoreApplication app(argc, argv);
+
+  // '-json <file>' is handled here, the other arguments are forwarded to QTest.
+  auto& reporter = BenchmarkReporter::instance();
+  reporter.setOutputPath("QtUpdaterBenchmarks.json");
+  auto arguments = app.arguments();
+  const auto jsonArgIndex = arguments.indexOf("-json");
+  if (jsonArgIndex >= 0 && jsonArgIndex + 1 < arguments.size()) {
+    reporter.setOutputPath(arguments.at(jsonArgIndex + 1));
+    arguments.erase(arguments.begin() + jsonArgIndex, arguments.begin() + jsonArgIndex + 2);
+  }
+
+  Benchmarks benchmarks;
+  const auto success = QTest::qExec(&benchmarks, arguments) == 0;
+  const auto written = reporter.write();
+  return success && written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,81 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include <oclero/QtUpdateAgent.hpp>
+#include <oclero/QtUpdateAgentServer.hpp>
+
+int main(int argc, char* argv[]) {
+  QCoreApplication::setApplicationName("UpdateAgentExample");
+  QCoreApplication::setApplicationVersion("1.0.0");
+  QCoreApplication::setOrganizationName("example");
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  parser.addPositionalArgument("config", "JSON file describing the targets (see agent.json).");
+  const QCommandLineOption queryOption(
+    "query", "Asks the running agent for the status of <target> (* for all targets).", "target");
+  parser.addOption(queryOption);
+  parser.process(app);
+
+  // Client mode: what an application would do, instead of checking by itself.
+  if (parser.isSet(queryOption)) {
+    const auto target = parser.value(queryOption);
+    const auto request = target == "*" ? QJsonObject{} : QJsonObject{ { "target", target } };
+    const auto answer = oclero::QtUpdateAgentServer::query(QJsonDocument(request).toJson(QJsonDocument::Compact));
+    if (answer.isEmpty()) {
+      qWarning() << "The agent is not running";
+      return 1;
+    }
+    QTextStream(stdout) << answer << '\n';
+    return 0;
+  }
+
+  if (parser.positionalArguments().isEmpty()) {
+    parser.showHelp(1);
+  }
+
+  QFile configFile(parser.positionalArguments().first());
+  if (!configFile.open(QIODevice::ReadOnly)) {
+    qWarning() << "Cannot read" << configFile.fileName();
+    return 1;
+  }
+  const auto config = QJsonDocument::fromJson(configFile.readAll()).object();
+
+  auto storage = config.value("storage").toString();
+  if (storage.isEmpty()) {
+    storage = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+  }
+  oclero::QtUpdateAgent agent(storage);
+  agent.setMaxConcurrentDownloads(config.value("maxConcurrentDownloads").toInt(agent.maxConcurrentDownloads()));
+  agent.setBandwidthLimit(static_cast<qint64>(config.value("bandwidthLimit").toDouble(0.)));
+  for (const auto& value : config.value("targets").toArray()) {
+    const auto target = value.toObject();
+    agent.addTarget({
+      target.value("id").toString(),
+      target.value("serverUrl").toString(),
+      target.value("currentVersion").toString(),
+    });
+  }
+
+  QObject::connect(&agent, &oclero::QtUpdateAgent::targetStatusChanged, &agent, [&agent](const QString& id) {
+    qDebug().noquote() << QJsonDocument(agent.targetStatus(id)).toJson(QJsonDocument::Compact);
+  });
+
+  oclero::QtUpdateAgentServer server(agent);
+  if (!server.listen()) {
+    qWarning() << "Cannot start the IPC server:" << server.errorString();
+    return 1;
+  }
+
+  agent.checkForUpdates();
+
+  return app.exec();
+}
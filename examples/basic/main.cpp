@@ -27,14 +27,22 @@ int main(int argc, char* argv[]) {
 
   QObject::connect(&updater, &oclero::QtUpdater::changelogAvailableChanged, &updater, [&updater]() {
     if (updater.changelogAvailable()) {
-      qDebug() << "Changelog downloaded!\nHere's what's new:";
-      qDebug() << updater.latestChangelog();
+      qDebug() << "Changelog downloaded!";
+      // Starts decoding the changelog in background. It will be ready when latestChangelogChanged is emitted.
+      updater.latestChangelog();
 
       qDebug() << "Downloading installer...";
       updater.downloadInstaller();
     }
   });
 
+  QObject::connect(&updater, &oclero::QtUpdater::latestChangelogChanged, &updater, [&updater]() {
+    if (!updater.latestChangelog().isEmpty()) {
+      qDebug() << "Here's what's new:";
+      qDebug() << updater.latestChangelog();
+    }
+  });
+
   QObject::connect(&updater, &oclero::QtUpdater::installerAvailableChanged, &updater, [&updater]() {
     if (updater.installerAvailable()) {
       qDebug() << "Installer downloaded!";
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+
+import argparse
+import hashlib
+import json
+import os
+import sys
+
+# Must be the same as QtDownloader::TreeHashBlockSize.
+TREE_HASH_BLOCK_SIZE = 4 * 1024 * 1024
+CHECKSUM_TYPES = ['md5', 'sha1', 'sha256', 'sha256_tree']
+
+def compute_checksum(filepath, checksum_type) -> str:
+  if checksum_type == 'sha256_tree':
+    # SHA-256 of the concatenated SHA-256 digests of each block.
+    root = hashlib.sha256()
+    with open(filepath, 'rb') as f:
+      while True:
+        block = f.read(TREE_HASH_BLOCK_SIZE)
+        if len(block) == 0:
+          break
+        root.update(hashlib.sha256(block).digest())
+    return root.hexdigest()
+
+  file_hash = hashlib.new(checksum_type)
+  with open(filepath, 'rb') as f:
+    while True:
+      block = f.read(TREE_HASH_BLOCK_SIZE)
+      if len(block) == 0:
+        break
+      file_hash.update(block)
+  return file_hash.hexdigest()
+
+def compute_block_manifest(filepath, block_size) -> str:
+  # SHA-256 digest of each block, to be referenced by the 'blockManifestUrl' field of the appcast.
+  blocks = []
+  with open(filepath, 'rb') as f:
+    while True:
+      block = f.read(block_size)
+      if len(block) == 0:
+        break
+      blocks.append(hashlib.sha256(block).hexdigest())
+  return json.dumps({ 'size': os.path.getsize(filepath), 'blockSize': block_size, 'blocks': blocks })
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser(description='Compute the checksum of an installer, to put in the appcast')
+  parser.add_argument('file', type=str, help='Installer file.')
+  parser.add_argument('--type', type=str, choices=CHECKSUM_TYPES, default='md5', help='Checksum type.')
+  parser.add_argument('--manifest', action='store_true', help='Print the block manifest instead of the checksum.')
+  args = parser.parse_args()
+
+  try:
+    if args.manifest:
+      print(compute_block_manifest(args.file, TREE_HASH_BLOCK_SIZE))
+    else:
+      print(compute_checksum(args.file, args.type))
+  except OSError as e:
+    print(e, file=sys.stderr)
+    sys.exit(1)
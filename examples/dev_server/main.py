@@ -30,6 +30,10 @@ if __name__ == '__main__':
   parser.add_argument('--dir', type=str, help='Directory where the update files are.')
   parser.add_argument('--port', type=int, help='Port number.')
   parser.add_argument('--address', type=str, help='Address.')
+  parser.add_argument('--latency', type=float, help='Delay before answering, in seconds.')
+  parser.add_argument('--bandwidth', type=int, help='Maximum throughput when sending files, in bytes per second.')
+  parser.add_argument('--drop-at', type=int, help='Close the connection when a file reaches this byte offset.')
+  parser.add_argument('--error', type=int, help='HTTP status to answer to every request (e.g. 503).')
   args = parser.parse_args()
 
   if args.dir is not None and len(args.dir) > 0 and not os.path.isdir(args.dir):
@@ -48,6 +52,14 @@ if __name__ == '__main__':
 
   # Start server.
   Server.root_dir = root_dir
+  if args.latency is not None:
+    Server.latency = args.latency
+  if args.bandwidth is not None:
+    Server.bytes_per_second = args.bandwidth
+  if args.drop_at is not None:
+    Server.drop_at_offset = args.drop_at
+  if args.error is not None:
+    Server.error_status = args.error
   httpd = HTTPServer((host_name, port_number), Server)
   logging.debug('Server started @ \'%s:%s\' \'%s\'' % (host_name, port_number, Server.root_dir))
 
@@ -7,6 +7,8 @@ from typing import Dict, List
 from pathlib import Path
 from http.server import BaseHTTPRequestHandler
 import logging
+import re
+import time
 
 ###################################################################################################
 # Constants.
@@ -15,11 +17,18 @@ ALIAS_VERSION_LATEST = 'latest'
 ALIAS_BRANCH_MAIN = 'release'
 PACKAGE_FILE_EXTENSION = 'exe'
 CHANGELOG_FILE_EXTENSION = 'md'
+CHANGELOG_QUERY_SINCE = 'since'
+# A Markdown heading that contains a version number, e.g. "## MyApp v1.2.0".
+CHANGELOG_VERSION_HEADING = re.compile(r'^(#{1,6})\s+.*?v?(\d+(?:\.\d+)+)')
 MIMETYPES = {
   '.exe': 'application/vnd.microsoft.portable-executable',
   '.dmg': 'application/vnd.apple.diskimage',
   '.md': 'text/markdown',
 }
+# Files are sent by chunks of this size, instead of being loaded in memory.
+STREAM_CHUNK_SIZE = 64 * 1024
+# A single byte range, e.g. "bytes=100-" or "bytes=100-199".
+RANGE_HEADER = re.compile(r'^bytes=(\d*)-(\d*)$')
 
 ###################################################################################################
 # Classes.
@@ -48,14 +57,16 @@ class RequestResult(object):
   content = bytes(0) # Request data.
   size = 0 # Data size.
   content_type = '' # MIME type.
+  stream = False # If True, the content is read from filepath when sending it.
 
-  def __init__(self, success, message, filepath = '', content = bytes(0), size = 0, content_type = ''):
+  def __init__(self, success, message, filepath = '', content = bytes(0), size = 0, content_type = '', stream = False):
     self.success = success
     self.message = message
     self.filepath = filepath
     self.content = content
     self.size = size
     self.content_type = content_type
+    self.stream = stream
 
   def __repr__(self):
     return str(self.__dict__)
@@ -87,6 +98,8 @@ def get_available_versions(root_dir, server_address) -> List[VersionInformation]
         changelog_url = f'http://{server_address}/{file_name}.{CHANGELOG_FILE_EXTENSION}'
         if os.path.isfile(os.path.abspath(f'{root_dir}/{file_name}.{CHANGELOG_FILE_EXTENSION}')):
           data['changelogUrl'] = changelog_url
+          # The server can send only the changelog sections newer than a version.
+          data['changelogDelta'] = True
         else:
           raise Exception()
 
@@ -139,6 +152,37 @@ def get_version(query_params, latest_version) -> version.StrictVersion:
 
   return query_version
 
+def parse_version(version_str):
+  try:
+    return version.LooseVersion(version_str)
+  except:
+    return None
+
+def filter_changelog_since(content, since_version) -> bytes:
+  # Keep only the sections (delimited by version headings) newer than the version.
+  # Text before the first section (e.g. the title) is kept.
+  result = []
+  section_level = 0
+  keep_section = True
+  for line in content.decode('utf-8').split('\n'):
+    match = CHANGELOG_VERSION_HEADING.match(line)
+    if match is not None:
+      level = len(match.group(1))
+      if section_level == 0:
+        section_level = level
+      if level == section_level:
+        section_version = parse_version(match.group(2))
+        keep_section = section_version is not None and section_version > since_version
+    elif section_level > 0 and line.startswith('#'):
+      level = len(line) - len(line.lstrip('#'))
+      if level < section_level:
+        keep_section = True
+
+    if keep_section:
+      result.append(line)
+
+  return '\n'.join(result).encode('utf-8')
+
 def handle_appcast_request(request_url, root_dir, server_address) -> RequestResult:
   # Check path validity.
   request_path_elements = request_url.path.split('/')
@@ -188,30 +232,61 @@ def handle_file_request(request_url, root_dir) -> RequestResult:
   if not os.path.isfile(result_filepath):
     return RequestResult(False, 'File does not exist')
 
-  # Get file content.
-  result_content = bytes(0)
-  result_size = 0
-  result_content_type = ''
+  # Get file content-type.
+  file_extension = get_extension(request_file)
+  result_content_type = MIMETYPES[file_extension]
+
+  # Changelog delta: only send the sections newer than the version.
+  since_str = get_params(request_url.query).get(CHANGELOG_QUERY_SINCE, '')
+  if file_extension == f'.{CHANGELOG_FILE_EXTENSION}' and len(since_str) > 0:
+    since_version = parse_version(since_str)
+    if since_version is None:
+      return RequestResult(False, 'Invalid version: %s' % (since_str))
+    try:
+      with open(result_filepath, 'rb') as f:
+        result_content = filter_changelog_since(f.read(), since_version)
+    except:
+      return RequestResult(False, 'Cannot read file content')
+    return RequestResult(True, '', result_filepath, result_content, len(result_content), result_content_type)
 
+  # Other files are streamed from the disk.
   try:
     result_size = os.path.getsize(result_filepath)
-    with open(result_filepath, 'rb') as f:
-      result_content = f.read()
-      result_size = len(result_content)
   except:
     return RequestResult(False, 'Cannot read file content')
 
-  # Get file content-type.
-  file_extension = get_extension(request_file)
-  result_content_type = MIMETYPES[file_extension]
+  return RequestResult(True, '', result_filepath, bytes(0), result_size, result_content_type, True)
 
-  return RequestResult(True, '', result_filepath, result_content, result_size, result_content_type)
+def parse_range(range_header, size):
+  # Returns the (first, last) byte positions, or None if the range is invalid or unsatisfiable.
+  match = RANGE_HEADER.match(range_header.strip())
+  if match is None or (match.group(1) == '' and match.group(2) == ''):
+    return None
+
+  if match.group(1) == '':
+    # Suffix range: the last N bytes.
+    first = max(0, size - int(match.group(2)))
+    last = size - 1
+  else:
+    first = int(match.group(1))
+    last = int(match.group(2)) if match.group(2) != '' else size - 1
+    last = min(last, size - 1)
+
+  if first > last or first >= size:
+    return None
+  return (first, last)
 
 ###################################################################################################
 
 class Server(BaseHTTPRequestHandler):
   root_dir = '.'
 
+  # Fault injection, to test clients against slow or unreliable networks.
+  latency = 0.0 # Delay before answering, in seconds.
+  bytes_per_second = 0 # Maximum throughput when streaming files (0 means unlimited).
+  drop_at_offset = -1 # Close the connection when a streamed file reaches this offset (-1 means never).
+  error_status = 0 # HTTP status to answer instead of the content (0 means none).
+
   def handle_request(self, url, root_dir, server_address) -> RequestResult:
     request_url = parse.urlsplit(url)
     request_extension = get_extension(request_url.path)
@@ -230,8 +305,44 @@ class Server(BaseHTTPRequestHandler):
     else:
       return RequestResult(False, 'Invalid URL')
 
+  def stream_file(self, filepath, first, length):
+    with open(filepath, 'rb') as f:
+      f.seek(first)
+      offset = first
+      remaining = length
+      while remaining > 0:
+        chunk_size = min(remaining, STREAM_CHUNK_SIZE)
+        if self.bytes_per_second > 0:
+          chunk_size = min(chunk_size, max(1, self.bytes_per_second // 10))
+        if self.drop_at_offset >= 0:
+          if offset >= self.drop_at_offset:
+            logging.debug('Connection dropped at offset %d' % (offset))
+            self.close_connection = True
+            return
+          chunk_size = min(chunk_size, self.drop_at_offset - offset)
+
+        chunk = f.read(chunk_size)
+        if len(chunk) == 0:
+          return
+        self.wfile.write(chunk)
+        offset += len(chunk)
+        remaining -= len(chunk)
+
+        if self.bytes_per_second > 0:
+          time.sleep(len(chunk) / self.bytes_per_second)
+
   def do_GET(self):
     logging.debug('Request received: \'%s\'' % (self.path))
+    if self.latency > 0:
+      time.sleep(self.latency)
+
+    if self.error_status > 0:
+      logging.debug('Request failed (injected error %d)' % (self.error_status))
+      self.send_response(self.error_status)
+      self.send_header('Content-Length', '0')
+      self.end_headers()
+      return
+
     request_result = self.handle_request(self.path, self.root_dir, "%s:%s" % self.server.server_address)
 
     if request_result.success:
@@ -239,15 +350,43 @@ class Server(BaseHTTPRequestHandler):
     else:
       logging.debug('Request failed (%s)' % (request_result.message))
 
-    if request_result.success:
+    if not request_result.success:
+      self.send_response(404)
+      self.send_header('Content-type', 'text/html')
+      self.end_headers()
+      return
+
+    if not request_result.stream:
       self.send_response(200)
       self.send_header('Accept', request_result.content_type)
       self.send_header('Content-Type', request_result.content_type)
       self.send_header('Content-Length', str(request_result.size))
       self.end_headers()
       self.wfile.write(request_result.content)
-
+      return
+
+    # Streamed file, that may be requested partially.
+    first = 0
+    last = request_result.size - 1
+    range_header = self.headers.get('Range')
+    if range_header is not None:
+      byte_range = parse_range(range_header, request_result.size)
+      if byte_range is None:
+        self.send_response(416)
+        self.send_header('Content-Range', 'bytes */%d' % (request_result.size))
+        self.send_header('Content-Length', '0')
+        self.end_headers()
+        return
+      first, last = byte_range
+      self.send_response(206)
+      self.send_header('Content-Range', 'bytes %d-%d/%d' % (first, last, request_result.size))
     else:
-      self.send_response(404)
-      self.send_header('Content-type', 'text/html')
-      self.end_headers()
+      self.send_response(200)
+
+    length = last - first + 1
+    self.send_header('Accept', request_result.content_type)
+    self.send_header('Accept-Ranges', 'bytes')
+    self.send_header('Content-Type', request_result.content_type)
+    self.send_header('Content-Length', str(length))
+    self.end_headers()
+    self.stream_file(request_result.filepath, first, length)
@@ -391,6 +391,17 @@ public:
         progressBar->setValue(value);
         progressLabel->setText(QString("%1%").arg(value));
       });
+    QObject::connect(
+      &controller, &QtUpdateController::downloadDetailsChanged, this, [&controller, progressLabel]() {
+        QLocale locale;
+        auto text = QString("%1% (%2/s)")
+                      .arg(controller.downloadProgress())
+                      .arg(locale.formattedDataSize(static_cast<qint64>(controller.downloadSpeed())));
+        if (controller.remainingTime() >= 0) {
+          text += ' ' + tr("- %n second(s) left", nullptr, static_cast<int>(controller.remainingTime() / 1000));
+        }
+        progressLabel->setText(text);
+      });
   }
 };
 
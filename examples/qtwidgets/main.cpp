@@ -21,6 +21,9 @@ int main(int argc, char* argv[]) {
   oclero::QtUpdater updater;
   updater.setServerUrl("http://localhost:8000/");
   updater.setFrequency(oclero::QtUpdater::Frequency::Never);
+  // Only display what changed since the current version, and never read more than 1 MB of changelog.
+  updater.setChangelogSinceCurrentVersion(true);
+  updater.setChangelogSizeLimit(1024 * 1024);
 
   // 2. Create update dialog controller.
   oclero::QtUpdateController updateCtrl(updater);
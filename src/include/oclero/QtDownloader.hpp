@@ -4,15 +4,20 @@
 #include <QString>
 #include <QUrl>
 #include <QByteArray>
+#include <QHash>
+#include <QVector>
 
 #include <functional>
 #include <memory>
 
+class QNetworkAccessManager;
+
 namespace oclero {
 /**
  * @brief Utility class to download a file or a data buffer.
+ * May be moved to another thread: callbacks are called in the thread it lives in.
  */
-class QtDownloader : QObject {
+class QtDownloader : public QObject {
   Q_OBJECT
 
 public:
@@ -29,6 +34,8 @@ public:
     FileDoesNotEndWithSuffix,
     CannotRenameFile,
     Cancelled,
+    BlockVerificationFailed,
+    ExtractionFailed,
   };
   Q_ENUM(ErrorCode)
 
@@ -36,6 +43,8 @@ public:
     NoChecksum,
     MD5,
     SHA1,
+    SHA256,
+    SHA256_TREE, // SHA-256 of the concatenated SHA-256 digests of each block of TreeHashBlockSize bytes.
   };
   Q_ENUM(ChecksumType)
 
@@ -45,31 +54,192 @@ public:
   };
   Q_ENUM(InvalidChecksumBehavior)
 
+  /**
+   * @brief Details about the progress of the current (or last) download.
+   */
+  struct Progress {
+    qint64 bytesReceived{ 0 };
+    qint64 bytesTotal{ -1 }; // -1 if unknown.
+    int percentage{ 0 };
+    double bytesPerSecond{ 0. }; // Smoothed transfer rate.
+    qint64 remainingTime{ -1 }; // Estimated, in milliseconds. -1 if unknown.
+  };
+
+  /**
+   * @brief Controls how often the progress callback is called.
+   * The callback is called when both the minimum interval has elapsed and the percentage changed by at least
+   * the minimum delta. 100% is always reported when the download is finished.
+   */
+  struct ProgressPolicy {
+    int minInterval{ 100 }; // Milliseconds.
+    int minDelta{ 1 }; // Percentage points.
+  };
+
+  /**
+   * @brief Deadlines that adapt to the host, in addition to the transfer timeout (the maximum duration without
+   * receiving data). The response deadline includes the name lookup, the connection and the TLS handshake: it is
+   * a multiple of the usual time to first byte of the host, and is shorter when the host didn't answer the
+   * previous requests, so that a server that is down is detected quickly. Once the response is received, the
+   * download fails if the throughput over the stall window is below the minimum.
+   */
+  struct TimeoutPolicy {
+    bool enabled{ false };
+    double responseTimeoutFactor{ 4. };
+    int minResponseTimeout{ 2000 }; // Milliseconds.
+    int maxResponseTimeout{ 15000 }; // Milliseconds. Also used when the host is unknown.
+    int stallWindow{ 15000 }; // Milliseconds.
+    qint64 minBytesPerSecond{ 1024 };
+  };
+
+  /**
+   * @brief What was observed of a host, to adapt the timeouts of the next downloads.
+   */
+  struct HostStatistics {
+    double timeToFirstByte{ -1. }; // Smoothed, in milliseconds. -1 if unknown.
+    int consecutiveFailures{ 0 }; // Requests without any response.
+  };
+  using HostStatisticsMap = QHash<QString, HostStatistics>;
+
+  /**
+   * @brief Measurements about a download, complete when the finished callback is called.
+   * Durations are in milliseconds since the request was sent, or -1 if unknown.
+   */
+  struct TransferMetrics {
+    QUrl url; // The mirror that sent the end of the file, if the download failed over.
+    qint64 timeToFirstByte{ -1 }; // Response headers received.
+    qint64 secureConnectionTime{ -1 }; // TLS handshake done (includes name lookup and TCP connection).
+    qint64 totalTime{ -1 };
+    qint64 bytesOnWire{ 0 }; // As reported by the network stack, before decompression.
+    qint64 bytesDecoded{ 0 }; // As written to the file or the buffer.
+    double averageBytesPerSecond{ 0. };
+    double peakBytesPerSecond{ 0. };
+    int retries{ 0 };
+    int failovers{ 0 }; // Number of times the download continued on another mirror.
+    int httpStatusCode{ 0 };
+    ErrorCode error{ ErrorCode::NoError };
+    int networkError{ 0 }; // QNetworkReply::NetworkError.
+    QString errorString;
+  };
+
+  /**
+   * @brief SHA-256 digests of each block of a file, to verify the blocks while the file is downloaded.
+   * Corrupted blocks are downloaded again with Range requests, and the download is aborted if most blocks
+   * are corrupted (i.e. the manifest doesn't match the file).
+   */
+  struct BlockManifest {
+    qint64 size{ -1 };
+    qint64 blockSize{ TreeHashBlockSize };
+    QVector<QByteArray> blockHashes; // Raw digests.
+
+    bool isValid() const;
+    // Same as the SHA256_TREE checksum of the file, if the block size is TreeHashBlockSize.
+    QByteArray rootHash() const;
+    // JSON object with fields "size", "blockSize" and "blocks" (hexadecimal digests).
+    static BlockManifest fromJSON(const QByteArray& data);
+  };
+
+  /**
+   * @brief Extracts the downloaded archive while it is received, instead of writing it to the disk.
+   * The data goes through the hash function and tar's standard input as it arrives. The compression is deduced
+   * from the file name in the URL (.tar, .tar.gz, .tar.zst, and .zip if the system tar is bsdtar).
+   * The content is extracted in "<localDir>.staging", which replaces localDir once the archive is fully
+   * extracted and its checksum is valid, and is removed otherwise. The finished callback gives localDir.
+   */
+  struct ExtractionOptions {
+    bool enabled{ false };
+    QString checksum; // Hexadecimal.
+    ChecksumType checksumType{ ChecksumType::NoChecksum };
+  };
+
   using FileFinishedCallback = std::function<void(ErrorCode const, const QString&)>;
   using DataFinishedCallback = std::function<void(ErrorCode const, const QByteArray&)>;
   using ProgressCallback = std::function<void(int const)>;
+  // bytesPerSecond is the average hashing throughput since the verification started.
+  using ChecksumProgressCallback =
+    std::function<void(qint64 const bytesProcessed, qint64 const bytesTotal, double const bytesPerSecond)>;
+  // Called from the hashing thread between blocks. Returns true to stop the verification.
+  using ChecksumCancellationCallback = std::function<bool()>;
 
   static inline const int DefaultTimeout = 30000;
+  // Size of the blocks hashed independently (and in parallel) for ChecksumType::SHA256_TREE.
+  static inline const qint64 TreeHashBlockSize = 4 * 1024 * 1024;
 
 public:
   QtDownloader(QObject* parent = nullptr);
   ~QtDownloader();
 
-  void downloadFile(const QUrl& url, const QString& localDir, const FileFinishedCallback&& onFinished,
-    const ProgressCallback&& onProgress = nullptr, const int timeout = DefaultTimeout);
+  // Local files (file: URLs) don't go through the network stack. A local file is hard-linked in the directory
+  // (or cloned or copied, on another volume), in a worker thread, and the block manifest is not used.
+  void downloadFile(const QUrl& url, const QString& localDir, FileFinishedCallback onFinished,
+    ProgressCallback onProgress = nullptr, const int timeout = DefaultTimeout);
 
-  void downloadData(const QUrl& url, const DataFinishedCallback&& onFinished,
-    const ProgressCallback&& onProgress = nullptr, const int timeout = DefaultTimeout);
+  void downloadData(const QUrl& url, DataFinishedCallback onFinished,
+    ProgressCallback onProgress = nullptr, const int timeout = DefaultTimeout);
 
   void cancel();
 
   bool isDownloading() const;
 
+  // Closes the connection of the current file download, and keeps the partial file.
+  // Not possible while extracting or repairing blocks.
+  void pause();
+  // Continues the paused download from the end of the partial file, with a Range request (or from the start,
+  // if the server doesn't support it).
+  void resume();
+  bool isPaused() const;
+
+  // Other URLs of the same file, used by the next call to downloadFile() only, in order of preference.
+  // If the connection fails, the download continues from the end of the partial file on the next mirror,
+  // with a Range request (or from the start, if the mirror doesn't support it).
+  const QVector<QUrl>& mirrorUrls() const;
+  void setMirrorUrls(const QVector<QUrl>& urls);
+
+  // Maximum transfer rate of file downloads, in bytes per second (0 means no limit).
+  // May be changed during a download.
+  qint64 bandwidthLimit() const;
+  void setBandwidthLimit(qint64 const bytesPerSecond);
+
+  // Manager used for the next downloads instead of the downloader's own one (nullptr to use it again),
+  // e.g. to share its connections with other downloaders. Must live in the same thread, and keep the replies.
+  QNetworkAccessManager* networkAccessManager() const;
+  void setNetworkAccessManager(QNetworkAccessManager* manager);
+
+  const ProgressPolicy& progressPolicy() const;
+  void setProgressPolicy(const ProgressPolicy& policy);
+
+  // Used for the next downloads.
+  const TimeoutPolicy& timeoutPolicy() const;
+  void setTimeoutPolicy(const TimeoutPolicy& policy);
+
+  // Statistics of the hosts, by host name, updated after each download when the timeout policy is enabled.
+  // May be shared between downloaders of the same thread, and persisted by the caller.
+  const std::shared_ptr<HostStatisticsMap>& hostStatistics() const;
+  void setHostStatistics(const std::shared_ptr<HostStatisticsMap>& statistics);
+
+  // Details of the current download. Meant to be read from the progress callback.
+  const Progress& progress() const;
+
+  // Used to verify the next call to downloadFile() only.
+  const BlockManifest& blockManifest() const;
+  void setBlockManifest(const BlockManifest& manifest);
+
+  // Used for the next file downloads, until extraction is disabled.
+  const ExtractionOptions& extractionOptions() const;
+  void setExtractionOptions(const ExtractionOptions& options);
+
+  // Metrics of the current (or last) download. Complete when the finished callback is called.
+  const TransferMetrics& transferMetrics() const;
+
+  // The file is memory-mapped when possible, and read by large blocks otherwise.
+  // A cancelled verification fails, and the file is kept whatever the behavior.
   static bool verifyFileChecksum(const QString& filePath, const QString& checksum, ChecksumType const checksumType,
-    InvalidChecksumBehavior const behavior = InvalidChecksumBehavior::RemoveFile);
+    InvalidChecksumBehavior const behavior = InvalidChecksumBehavior::RemoveFile,
+    const ChecksumProgressCallback& onProgress = nullptr, const ChecksumCancellationCallback& isCancelled = nullptr);
 
 private:
   struct Impl;
   std::unique_ptr<Impl> _impl;
 };
 } // namespace oclero
+
+Q_DECLARE_METATYPE(oclero::QtDownloader::TransferMetrics)
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVersionNumber>
+
+#include <functional>
+
+namespace oclero {
+/**
+ * @brief Installs a downloaded and verified installer.
+ * Set one with QtUpdater::setInstallStrategy() to replace the behavior of the install mode.
+ */
+class QtInstallStrategy {
+public:
+  struct Context {
+    QString installerPath;
+    QVersionNumber version;
+  };
+
+  enum class Result {
+    Success,
+    // The installer could not be run or extracted.
+    Failure,
+    // The files could not be moved or written (e.g. no space left, no permission).
+    DiskError,
+    // The installer runs in another process: the application must quit to let it replace the files.
+    QuitApplication,
+  };
+
+  using ProgressCallback = std::function<void(int const percentage)>;
+
+public:
+  virtual ~QtInstallStrategy() = default;
+
+  virtual Result install(const Context& context, const ProgressCallback& onProgress) = 0;
+};
+
+/**
+ * @brief Starts the installer in a separate process (InstallMode::ExecuteFile).
+ * On Windows and Linux, the installer is executed (on Linux, it is made executable first).
+ * On macOS, it is opened (e.g. a .dmg or a .pkg).
+ */
+class QtExecuteFileInstallStrategy : public QtInstallStrategy {
+public:
+  Result install(const Context& context, const ProgressCallback& onProgress) override;
+};
+
+/**
+ * @brief Moves the installer to a directory (InstallMode::MoveFileToDir).
+ */
+class QtMoveFileInstallStrategy : public QtInstallStrategy {
+public:
+  explicit QtMoveFileInstallStrategy(const QString& destinationDir);
+
+  Result install(const Context& context, const ProgressCallback& onProgress) override;
+
+private:
+  QString _destinationDir;
+};
+
+/**
+ * @brief Replaces an AppImage with the downloaded one (Linux).
+ * The running application keeps working, and the new version is used on next start.
+ */
+class QtAppImageInstallStrategy : public QtInstallStrategy {
+public:
+  // By default, the AppImage currently running (given by the APPIMAGE environment variable) is replaced.
+  explicit QtAppImageInstallStrategy(const QString& appImagePath = {});
+
+  Result install(const Context& context, const ProgressCallback& onProgress) override;
+
+private:
+  QString _appImagePath;
+};
+
+/**
+ * @brief Extracts a .tar.gz, .tar.zst or .tar archive in a versioned directory, then atomically
+ * points a symbolic link to it (Linux, macOS).
+ *
+ * The archive is extracted in "<installDir>/<version>.staging", which is renamed to "<installDir>/<version>"
+ * once complete. Then the link "<installDir>/<linkName>" is replaced to point to this directory.
+ * If "<installDir>/<version>" already exists (e.g. the same version is installed again), the archive is
+ * extracted next to it, in "<installDir>/<version>-<n>": the directory the link points to is never modified.
+ * The running application keeps working, and the new version is used on next start.
+ * Once the link is swapped, the versions older than the previous one are removed.
+ */
+class QtArchiveInstallStrategy : public QtInstallStrategy {
+public:
+  explicit QtArchiveInstallStrategy(const QString& installDir, const QString& linkName = QStringLiteral("current"));
+
+  Result install(const Context& context, const ProgressCallback& onProgress) override;
+
+  // Arguments to give to tar to extract the archive, according to its extension.
+  static QStringList extractionArguments(const QString& archivePath, const QString& destinationDir);
+  // Same, but the archive is read from tar's standard input. Its name is only used to deduce the compression.
+  static QStringList streamExtractionArguments(const QString& archiveName, const QString& destinationDir);
+  // Makes <installDir>/<linkName> point to <installDir>/<targetName>, with a rename.
+  static bool swapLink(const QString& installDir, const QString& linkName, const QString& targetName);
+  // Removes the version directories in <installDir>, except the given ones. Returns false if one can't be removed.
+  static bool removeVersions(const QString& installDir, const QStringList& keptNames);
+
+private:
+  QString _installDir;
+  QString _linkName;
+};
+} // namespace oclero
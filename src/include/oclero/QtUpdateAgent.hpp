@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+
+#include <memory>
+
+namespace oclero {
+/**
+ * @brief Headless agent that keeps the updates of several applications ready, from a single process.
+ * Each target is an application, given by its server URL and its current version.
+ * The updaters share one connection pool and one installer cache ("<storageDir>/shared"), so that an installer
+ * used by several targets is downloaded once. Their changelogs and installers are prefetched by a scheduler
+ * that limits the number of concurrent downloads and the total bandwidth.
+ */
+class QtUpdateAgent : public QObject {
+  Q_OBJECT
+
+public:
+  struct Target {
+    QString id;
+    QString serverUrl;
+    QString currentVersion;
+  };
+
+  static inline const int DefaultMaxConcurrentDownloads = 2;
+
+public:
+  explicit QtUpdateAgent(const QString& storageDir, QObject* parent = nullptr);
+  ~QtUpdateAgent();
+
+  QString storageDir() const;
+
+  // Targets with the same server and current version share the same updater and the same files.
+  // Returns false if the id is empty or already used.
+  bool addTarget(const Target& target);
+  QStringList targetIds() const;
+  // Snapshot of the target's update, without any network access. Empty if the target is unknown.
+  QJsonObject targetStatus(const QString& id) const;
+
+  int maxConcurrentDownloads() const;
+  void setMaxConcurrentDownloads(int count);
+  // Shared by the running downloads, in bytes per second (0 means no limit).
+  qint64 bandwidthLimit() const;
+  void setBandwidthLimit(qint64 bytesPerSecond);
+
+public slots:
+  // Checks the targets according to their check frequency, or all of them if forced.
+  void checkForUpdates(bool const force = false);
+
+signals:
+  void targetStatusChanged(const QString& id);
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> _impl;
+};
+} // namespace oclero
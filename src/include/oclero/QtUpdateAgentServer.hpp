@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+
+#include <memory>
+
+namespace oclero {
+class QtUpdateAgent;
+
+/**
+ * @brief Local IPC interface of QtUpdateAgent, so that applications query their update without network access.
+ * Protocol: one JSON object per line. The request `{"target":"<id>"}` is answered with the status of the target,
+ * and an empty object `{}` is answered with `{"targets":[...]}`, the status of all targets.
+ * Only the current user may connect.
+ */
+class QtUpdateAgentServer : public QObject {
+  Q_OBJECT
+
+public:
+  static inline const QString DefaultName = QStringLiteral("qtupdater-agent");
+  static inline const int DefaultTimeout = 3000;
+
+public:
+  explicit QtUpdateAgentServer(QtUpdateAgent& agent, QObject* parent = nullptr);
+  ~QtUpdateAgentServer();
+
+  // Fails if another agent already listens with this name.
+  bool listen(const QString& name = DefaultName);
+  QString errorString() const;
+
+  // Answer to a request, as sent to the clients (without the line break).
+  QByteArray answer(const QByteArray& request) const;
+
+  // Sends the request to a running agent, and returns its answer (empty on error). Blocking: must not be called
+  // from the thread of the server.
+  static QByteArray query(const QByteArray& request, const QString& name = DefaultName, int timeout = DefaultTimeout);
+  // Whether an agent answers with this name. Blocking, like query().
+  static bool isListening(const QString& name = DefaultName, int timeout = DefaultTimeout);
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> _impl;
+};
+} // namespace oclero
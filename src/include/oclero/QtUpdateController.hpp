@@ -8,6 +8,7 @@
 namespace oclero {
 /**
  * @brief Controller for the Update dialog. Might be used with a QtWidgets-based or QtQuick-based dialog.
+ * The updater may live in a worker thread, while the controller lives in the GUI thread.
  */
 class QtUpdateController : public QObject {
   Q_OBJECT
@@ -18,6 +19,10 @@ class QtUpdateController : public QObject {
   Q_PROPERTY(QString latestVersion READ latestVersion NOTIFY latestVersionChanged)
   Q_PROPERTY(QDateTime latestVersionDate READ latestVersionDate NOTIFY latestVersionDateChanged)
   Q_PROPERTY(int downloadProgress READ downloadProgress NOTIFY downloadProgressChanged)
+  Q_PROPERTY(qint64 downloadedBytes READ downloadedBytes NOTIFY downloadDetailsChanged)
+  Q_PROPERTY(qint64 totalBytes READ totalBytes NOTIFY downloadDetailsChanged)
+  Q_PROPERTY(double downloadSpeed READ downloadSpeed NOTIFY downloadDetailsChanged)
+  Q_PROPERTY(qint64 remainingTime READ remainingTime NOTIFY downloadDetailsChanged)
   Q_PROPERTY(QString latestVersionChangelog READ latestVersionChangelog NOTIFY latestVersionChangelogChanged)
 
 public:
@@ -47,10 +52,18 @@ public:
   QDateTime latestVersionDate() const;
   QString latestVersionChangelog() const;
   int downloadProgress() const;
+  qint64 downloadedBytes() const;
+  qint64 totalBytes() const;
+  // In bytes per second.
+  double downloadSpeed() const;
+  // In milliseconds, or -1 if unknown.
+  qint64 remainingTime() const;
 
 private:
   void setState(State state);
+  void setStatus(const QtUpdater::Status& status);
   void setDownloadProgress(int);
+  void setDownloadDetails(qint64 downloadedBytes, qint64 totalBytes, double downloadSpeed, qint64 remainingTime);
 
 public slots:
   void cancel();
@@ -67,6 +80,7 @@ signals:
   void latestVersionDateChanged();
   void latestVersionChangelogChanged();
   void downloadProgressChanged(int);
+  void downloadDetailsChanged();
   void manualCheckingRequested();
   void closeDialogRequested();
   void checkForUpdateErrorChanged(QtUpdater::ErrorCode code);
@@ -74,11 +88,19 @@ signals:
   void updateDownloadErrorChanged(QtUpdater::ErrorCode code);
   void updateInstallationErrorChanged(QtUpdater::ErrorCode code);
 
+  // Deprecated: no longer emitted, Linux uses the same download path as other platforms.
   void linuxDownloadUpdateRequested();
 
 private:
   oclero::QtUpdater& _updater;
+  // Last status received from the updater.
+  QtUpdater::Status _status;
+  bool _statusReceived{ false };
   State _state{ State::None };
   int _downloadProgress{ 0 };
+  qint64 _downloadedBytes{ 0 };
+  qint64 _totalBytes{ -1 };
+  double _downloadSpeed{ 0. };
+  qint64 _remainingTime{ -1 };
 };
 } // namespace oclero
@@ -2,14 +2,19 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QDateTime>
 #include <QSettings>
+#include <QFuture>
+
+#include <oclero/QtDownloader.hpp>
+#include <oclero/QtInstallStrategy.hpp>
 
 #include <memory>
 
 namespace oclero {
 /**
- * @brief Updater that checks for updates and download installer (Windows-only feature).
+ * @brief Updater that checks for updates, downloads and installs the installer.
  * The Updater expects a JSON response like this from the server.
  * {
  *   "version": "x.y.z",
@@ -19,6 +24,10 @@ namespace oclero {
  *   "installerUrl": "http://server/endpoint/package-name.exe",
  *   "changelogUrl": "http://server/endpoint/changelog-name.md"
  * }
+ *
+ * The updater may live in a worker thread (moveToThread()), so that network, disk and checksum work never
+ * happen on the GUI thread. Then, only call its slots with queued connections or QMetaObject::invokeMethod(),
+ * and read its properties from statusChanged(). QtUpdateController does it for you.
  */
 class QtUpdater : public QObject {
   Q_OBJECT
@@ -27,7 +36,7 @@ class QtUpdater : public QObject {
       temporaryDirectoryPathChanged)
   Q_PROPERTY(UpdateAvailability updateAvailability READ updateAvailability NOTIFY updateAvailabilityChanged)
   Q_PROPERTY(bool installerAvailable READ installerAvailable NOTIFY installerAvailableChanged)
-  Q_PROPERTY(QString currentVersion READ currentVersion CONSTANT)
+  Q_PROPERTY(QString currentVersion READ currentVersion WRITE setCurrentVersion NOTIFY currentVersionChanged)
   Q_PROPERTY(QDateTime currentVersionDate READ currentVersionDate CONSTANT)
   Q_PROPERTY(QString latestVersion READ latestVersion NOTIFY latestVersionChanged)
   Q_PROPERTY(QDateTime latestVersionDate READ latestVersionDate NOTIFY latestVersionDateChanged)
@@ -38,6 +47,16 @@ class QtUpdater : public QObject {
   Q_PROPERTY(QDateTime lastCheckTime READ lastCheckTime NOTIFY lastCheckTimeChanged)
   Q_PROPERTY(InstallMode installMode READ installMode WRITE setInstallMode NOTIFY installModeChanged)
   Q_PROPERTY(QString installerDestinationDir READ installerDestinationDir WRITE setInstallerDestinationDir NOTIFY installerDestinationDirChanged)
+  Q_PROPERTY(bool binaryCacheEnabled READ binaryCacheEnabled WRITE setBinaryCacheEnabled NOTIFY binaryCacheEnabledChanged)
+  Q_PROPERTY(bool paranoidVerification READ paranoidVerification WRITE setParanoidVerification NOTIFY paranoidVerificationChanged)
+  Q_PROPERTY(qint64 changelogSizeLimit READ changelogSizeLimit WRITE setChangelogSizeLimit NOTIFY changelogSizeLimitChanged)
+  Q_PROPERTY(bool changelogSinceCurrentVersion READ changelogSinceCurrentVersion WRITE setChangelogSinceCurrentVersion NOTIFY changelogSinceCurrentVersionChanged)
+  Q_PROPERTY(bool prefetchEnabled READ prefetchEnabled WRITE setPrefetchEnabled NOTIFY prefetchEnabledChanged)
+  Q_PROPERTY(qint64 prefetchBandwidthLimit READ prefetchBandwidthLimit WRITE setPrefetchBandwidthLimit NOTIFY prefetchBandwidthLimitChanged)
+  Q_PROPERTY(bool prefetchPaused READ prefetchPaused WRITE setPrefetchPaused NOTIFY prefetchPausedChanged)
+  Q_PROPERTY(bool prefetching READ prefetching NOTIFY prefetchingChanged)
+  Q_PROPERTY(QString sharedCacheDirectory READ sharedCacheDirectory WRITE setSharedCacheDirectory NOTIFY sharedCacheDirectoryChanged)
+  Q_PROPERTY(qint64 sharedCacheSizeLimit READ sharedCacheSizeLimit WRITE setSharedCacheSizeLimit NOTIFY sharedCacheSizeLimitChanged)
 
 public:
   enum class State {
@@ -46,6 +65,8 @@ public:
     DownloadingChangelog,
     DownloadingInstaller,
     InstallingUpdate,
+    // verifyInstallerAsync() is hashing the installer in a worker thread.
+    VerifyingInstaller,
   };
   Q_ENUM(State)
 
@@ -91,6 +112,61 @@ public:
   };
   Q_ENUM(ErrorCode)
 
+  /**
+   * @brief Snapshot of the properties, emitted with statusChanged() when one of them changes.
+   * Safe to read from another thread than the updater's one.
+   */
+  struct Status {
+    State state{ State::Idle };
+    UpdateAvailability updateAvailability{ UpdateAvailability::Unknown };
+    bool changelogAvailable{ false };
+    bool installerAvailable{ false };
+    QString currentVersion;
+    QDateTime currentVersionDate;
+    QString latestVersion;
+    QDateTime latestVersionDate;
+    QString latestChangelog;
+  };
+
+  /**
+   * @brief Peer mode: verified installers are shared with the other updaters of the local network, and an
+   * installer is downloaded from a peer that has it before trying the server. Peers are found with a UDP
+   * datagram, and their files are verified against the appcast checksum (and the block manifest, if any).
+   * Peers are only used if the checksum is SHA-256 (or a SHA-256 tree hash), or if the update has a block manifest.
+   */
+  struct PeerOptions {
+    bool enabled{ false };
+    quint16 discoveryPort{ 45454 };
+    // Where the discovery datagram is sent: the whole local network by default. On Linux, a loopback address
+    // reaches all the updaters of the machine.
+    QString discoveryAddress{ QStringLiteral("255.255.255.255") };
+    // Time to wait for a peer before downloading from the server, in milliseconds.
+    int discoveryTimeout{ 300 };
+  };
+
+  /**
+   * @brief Hedged update checks: if the appcast request has not answered after a delay, a second request is
+   * sent, and the first valid answer is used while the other request is cancelled. The delay is a percentile of
+   * the durations of the previous checks, so that only the slowest checks send a second request.
+   */
+  struct HedgingOptions {
+    bool enabled{ false };
+    // Percentile of the previous check durations, between 0 and 1.
+    double percentile{ 0.95 };
+    // Delays used until enough checks are measured, and bounds of the delay, in milliseconds.
+    int initialDelay{ 1000 };
+    int minDelay{ 100 };
+    int maxDelay{ 5000 };
+    // Other endpoints that send the same appcast, used in turn for the second request. The server URL is used
+    // if empty.
+    QStringList alternateServerUrls;
+  };
+
+  // Bytes per second.
+  static inline const qint64 DefaultPrefetchBandwidthLimit = 1024 * 1024;
+  // Bytes.
+  static inline const qint64 DefaultSharedCacheSizeLimit = qint64{ 2 } * 1024 * 1024 * 1024;
+
 public:
   explicit QtUpdater(QObject* parent = nullptr);
   QtUpdater(const QString& serverUrl, QObject* parent = nullptr);
@@ -106,6 +182,7 @@ public:
   const QDateTime& currentVersionDate() const;
   QString latestVersion() const;
   QDateTime latestVersionDate() const;
+  // Never blocks: returns an empty string until the changelog is decoded, then emits latestChangelogChanged().
   const QString& latestChangelog() const;
   State state() const;
   const QString& serverUrl() const;
@@ -114,9 +191,57 @@ public:
   int checkTimeout() const;
   InstallMode installMode() const;
   const QString& installerDestinationDir() const;
+  bool binaryCacheEnabled() const;
+  bool paranoidVerification() const;
+  qint64 changelogSizeLimit() const;
+  bool changelogSinceCurrentVersion() const;
+  bool prefetchEnabled() const;
+  qint64 prefetchBandwidthLimit() const;
+  bool prefetchPaused() const;
+  // True while the changelog or the installer is downloaded in the background.
+  bool prefetching() const;
+  const QString& sharedCacheDirectory() const;
+  qint64 sharedCacheSizeLimit() const;
+  const PeerOptions& peerOptions() const;
+  const HedgingOptions& hedgingOptions() const;
+  const QtDownloader::TimeoutPolicy& timeoutPolicy() const;
+  const QtDownloader::ProgressPolicy& progressPolicy() const;
+  const std::shared_ptr<QtInstallStrategy>& installStrategy() const;
+  Status status() const;
+
+  // Replaces the behavior of the install mode. Set nullptr to use the install mode again.
+  void setInstallStrategy(const std::shared_ptr<QtInstallStrategy>& strategy);
+
+  void setPeerOptions(const PeerOptions& options);
+  void setHedgingOptions(const HedgingOptions& options);
+
+  // Shares the connections of the given manager, e.g. between the updaters of several applications.
+  // See QtDownloader::setNetworkAccessManager().
+  void setNetworkAccessManager(QNetworkAccessManager* manager);
+
+  // Adaptive timeouts of all the downloads. The statistics of the hosts are kept in the settings, so that the
+  // next checks fail fast when the server is down. See QtDownloader::TimeoutPolicy.
+  void setTimeoutPolicy(const QtDownloader::TimeoutPolicy& policy);
+
+  // Throttling of the download progress signals. See QtDownloader::ProgressPolicy.
+  void setProgressPolicy(const QtDownloader::ProgressPolicy& policy);
+
+  // Future-based API, alongside the signals. Must be called from the updater's thread.
+  // The future holds the ErrorCode of the operation (NoError on success). It is canceled if the operation
+  // is cancelled or cannot start (e.g. another one is running). Canceling the future cancels the operation.
+  QFuture<ErrorCode> checkForUpdateAsync(bool const force = false);
+  QFuture<ErrorCode> downloadChangelogAsync();
+  QFuture<ErrorCode> downloadInstallerAsync();
+  // Verifies the checksum of the available installer in a worker thread, unless already verified.
+  // The state is VerifyingInstaller meanwhile. An invalid installer is removed.
+  QFuture<ErrorCode> verifyInstallerAsync();
 
 public slots:
+  // Emits statusChanged(), e.g. to get the initial status from another thread.
+  void requestStatus();
   void setTemporaryDirectoryPath(const QString& path);
+  // Defaults to QCoreApplication::applicationVersion(). Set it when updating another application.
+  void setCurrentVersion(const QString& version);
   void setServerUrl(const QString& serverUrl);
   void setFrequency(Frequency frequency);
   void checkForUpdate();
@@ -124,14 +249,39 @@ public slots:
   void downloadChangelog();
   void downloadInstaller();
   // Set dry to true if you don't want to quit the application.
+  // The install strategy runs in a worker thread: installationFinished() or installationFailed() is emitted later.
   void installUpdate(const bool dry = false);
   void setCheckTimeout(int timeout);
   void setInstallMode(InstallMode mode);
   void setInstallerDestinationDir(const QString& path);
+  // Keep a compact binary cache of the last appcast in the temporary directory, for faster warm starts.
+  void setBinaryCacheEnabled(bool enabled);
+  // Always hash the installer again before installing, even if it was already verified and is unchanged.
+  void setParanoidVerification(bool enabled);
+  // Only read the first bytes of the changelog (0 means no limit).
+  void setChangelogSizeLimit(qint64 bytes);
+  // Only keep the changelog sections (delimited by version headings) newer than the current version.
+  void setChangelogSinceCurrentVersion(bool enabled);
+  // When an update is available after a check, download the changelog and the installer in the background,
+  // throttled, without changing the state. downloadChangelog() and downloadInstaller() then continue the
+  // background download at full speed, as a regular download.
+  void setPrefetchEnabled(bool enabled);
+  // Maximum transfer rate of the background downloads, in bytes per second (0 means no limit).
+  void setPrefetchBandwidthLimit(qint64 bytesPerSecond);
+  // Pauses the background downloads, e.g. when the application is busy or the connection is metered.
+  // They are also paused automatically while the event loop is busy.
+  void setPrefetchPaused(bool paused);
+  // Directory shared by updaters (and processes), where verified installers are stored by checksum (empty to
+  // disable). An installer already in this cache is hard-linked (or copied) instead of downloaded.
+  void setSharedCacheDirectory(const QString& path);
+  // The least recently used installers are removed from the shared cache above this size (0 means no limit).
+  void setSharedCacheSizeLimit(qint64 bytes);
   void cancel();
 
 signals:
+  void statusChanged(const oclero::QtUpdater::Status& status);
   void temporaryDirectoryPathChanged();
+  void currentVersionChanged();
   void latestVersionChanged();
   void latestVersionDateChanged();
   void latestChangelogChanged();
@@ -142,6 +292,16 @@ signals:
   void installModeChanged();
   void installerDestinationDirChanged();
   void checkTimeoutChanged();
+  void binaryCacheEnabledChanged();
+  void paranoidVerificationChanged();
+  void changelogSizeLimitChanged();
+  void changelogSinceCurrentVersionChanged();
+  void prefetchEnabledChanged();
+  void prefetchBandwidthLimitChanged();
+  void prefetchPausedChanged();
+  void prefetchingChanged();
+  void sharedCacheDirectoryChanged();
+  void sharedCacheSizeLimitChanged();
 
   void checkForUpdateForced();
   void checkForUpdateStarted();
@@ -161,12 +321,21 @@ signals:
 
   void installerDownloadStarted();
   void installerDownloadProgressChanged(int percentage);
+  // Emitted along with installerDownloadProgressChanged(). remainingTime is in milliseconds, or -1 if unknown.
+  void installerDownloadProgressDetailsChanged(
+    qint64 bytesReceived, qint64 bytesTotal, double bytesPerSecond, qint64 remainingTime);
   void installerDownloadFinished();
   void installerDownloadFailed(ErrorCode error);
   void installerDownloadCancelled();
   void installerAvailableChanged();
 
+  // Emitted when any download (appcast, changelog or installer) is finished, successfully or not.
+  void transferMetricsAvailable(const oclero::QtDownloader::TransferMetrics& metrics);
+
   void installationStarted();
+  // Emitted while the installer is installed, if the install strategy reports progress
+  // (e.g. while it is copied to its destination, in MoveFileToDir mode).
+  void installationProgressChanged(int percentage);
   void installationFailed(ErrorCode error);
   // Emitted only when run in dry mode.
   void installationFinished();
@@ -176,3 +345,5 @@ private:
   std::unique_ptr<Impl> _impl;
 };
 } // namespace oclero
+
+Q_DECLARE_METATYPE(oclero::QtUpdater::Status)
@@ -0,0 +1,101 @@
+#include <oclero/Changelog.hpp>
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QStringList>
+
+namespace oclero::changelog {
+namespace {
+// A Markdown heading that contains a version number, e.g. "## MyApp v1.2.0".
+const QRegularExpression& versionHeadingRegex() {
+  static const QRegularExpression regex(R"(^(#{1,6})\s+.*?v?(\d+(?:\.\d+)+))");
+  return regex;
+}
+} // namespace
+
+QString load(const QString& filePath, const LoadOptions& options) {
+  QFile file(filePath);
+  if (filePath.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+    return {};
+  }
+
+  QByteArray data;
+  if (options.maxSize > 0 && file.size() > options.maxSize) {
+    // Only read the head of the file, and cut at the last complete line,
+    // which also ensures a UTF-8 sequence is not split in the middle.
+    data = file.read(options.maxSize);
+    const auto lastLineEnd = data.lastIndexOf('\n');
+    if (lastLineEnd >= 0) {
+      data.truncate(lastLineEnd + 1);
+    }
+  } else {
+    data = file.readAll();
+  }
+  file.close();
+
+  auto result = QString::fromUtf8(data);
+  if (!options.sinceVersion.isNull()) {
+    result = filterSince(result, options.sinceVersion);
+  }
+  return result;
+}
+
+QString filterSince(const QString& markdown, const QVersionNumber& sinceVersion) {
+  const auto& regex = versionHeadingRegex();
+  const auto lines = markdown.split('\n');
+
+  QStringList result;
+  auto sectionLevel = 0;
+  auto foundSection = false;
+  auto keepCurrentSection = true;
+  for (const auto& line : lines) {
+    const auto match = regex.match(line);
+    if (match.hasMatch()) {
+      const auto level = match.capturedLength(1);
+      // The level of the first version heading gives the level of all sections.
+      if (!foundSection) {
+        foundSection = true;
+        sectionLevel = level;
+      }
+      if (level == sectionLevel) {
+        const auto version = QVersionNumber::fromString(match.captured(2));
+        keepCurrentSection = QVersionNumber::compare(version, sinceVersion) > 0;
+      }
+    } else if (foundSection && line.startsWith('#')) {
+      // A heading of higher level without version ends the sections (e.g. a new top-level title).
+      auto level = 0;
+      while (level < line.size() && line.at(level) == '#') {
+        ++level;
+      }
+      if (level < sectionLevel) {
+        keepCurrentSection = true;
+      }
+    }
+
+    if (keepCurrentSection) {
+      result << line;
+    }
+  }
+
+  return foundSection ? result.join('\n') : markdown;
+}
+
+QString merge(const QString& newer, const QString& older) {
+  const auto& regex = versionHeadingRegex();
+  const auto lines = older.split('\n');
+  auto firstSection = 0;
+  while (firstSection < lines.size() && !regex.match(lines.at(firstSection)).hasMatch()) {
+    ++firstSection;
+  }
+  if (firstSection == lines.size()) {
+    return newer;
+  }
+
+  auto result = newer;
+  if (!result.isEmpty() && !result.endsWith('\n')) {
+    result += '\n';
+  }
+  result += lines.mid(firstSection).join('\n');
+  return result;
+}
+} // namespace oclero::changelog
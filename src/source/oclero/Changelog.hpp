@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QString>
+#include <QVersionNumber>
+
+namespace oclero::changelog {
+struct LoadOptions {
+  // Maximum number of bytes read from the file (0 means no limit). Only the head of the file is read.
+  qint64 maxSize{ 0 };
+  // If not null, only keep the sections whose heading version is greater than this version.
+  QVersionNumber sinceVersion;
+};
+
+/**
+ * @brief Reads and decodes a Markdown changelog. Designed to be called from a worker thread.
+ */
+QString load(const QString& filePath, const LoadOptions& options);
+
+/**
+ * @brief Keeps only the sections of a Markdown changelog whose heading contains a version greater than the given one.
+ * A section starts with a heading containing a version number (e.g. "## MyApp 1.2.0") and ends at the next one.
+ * The text that precedes the first section (e.g. the title) is kept.
+ * If the changelog contains no version heading, it is returned untouched.
+ */
+QString filterSince(const QString& markdown, const QVersionNumber& sinceVersion);
+
+/**
+ * @brief Appends the sections of an older changelog after a newer changelog fragment.
+ * The text that precedes the first section of the older changelog (e.g. the title) is dropped.
+ */
+QString merge(const QString& newer, const QString& older);
+} // namespace oclero::changelog
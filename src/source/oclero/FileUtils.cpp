@@ -0,0 +1,315 @@
+#include "FileUtils.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QByteArray>
+#include <QDir>
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(Q_OS_WIN)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#  include <io.h>
+#else
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#if defined(Q_OS_LINUX)
+#  include <sys/ioctl.h>
+#  include <linux/fs.h>
+#endif
+
+namespace oclero::fileutils {
+namespace {
+// Size of the pieces copied at once, between two progress notifications.
+constexpr qint64 COPY_CHUNK_SIZE = 64 * 1024 * 1024;
+// Size of the buffer used by the streamed copy.
+constexpr qint64 COPY_BUFFER_SIZE = 4 * 1024 * 1024;
+
+// Atomic rename that replaces the destination. Fails if both paths are not on the same volume.
+bool renameReplacing(const QString& sourcePath, const QString& destinationPath) {
+#if defined(Q_OS_WIN)
+  return ::MoveFileExW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(sourcePath).utf16()),
+           reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(destinationPath).utf16()),
+           MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)
+         != 0;
+#else
+  return ::rename(QFile::encodeName(sourcePath).constData(), QFile::encodeName(destinationPath).constData()) == 0;
+#endif
+}
+
+// Copies the content with the kernel: reflink if the file system supports it, or copy_file_range().
+bool cloneContent(QFile& source, QFileDevice& destination, const CopyProgressCallback& onProgress) {
+#if defined(Q_OS_LINUX)
+  const auto sourceHandle = source.handle();
+  const auto destinationHandle = destination.handle();
+#  if defined(FICLONE)
+  if (::ioctl(destinationHandle, FICLONE, sourceHandle) == 0) {
+    if (onProgress) {
+      onProgress(source.size(), source.size());
+    }
+    return true;
+  }
+#  endif
+
+  const auto size = source.size();
+  auto copied = qint64{ 0 };
+  while (copied < size) {
+    const auto length = static_cast<size_t>(std::min(size - copied, COPY_CHUNK_SIZE));
+    const auto result = ::copy_file_range(sourceHandle, nullptr, destinationHandle, nullptr, length, 0);
+    if (result <= 0) {
+      // Not supported (e.g. old kernel or different file systems): nothing is lost if nothing was copied yet.
+      return false;
+    }
+    copied += result;
+    if (onProgress) {
+      onProgress(copied, size);
+    }
+  }
+  return true;
+#else
+  Q_UNUSED(source);
+  Q_UNUSED(destination);
+  Q_UNUSED(onProgress);
+  return false;
+#endif
+}
+
+bool copyContent(QFile& source, QFileDevice& destination, const CopyProgressCallback& onProgress) {
+  const auto size = source.size();
+  auto copied = qint64{ 0 };
+  auto lastNotified = qint64{ 0 };
+  QByteArray buffer(static_cast<int>(COPY_BUFFER_SIZE), Qt::Uninitialized);
+  while (copied < size) {
+    const auto read = source.read(buffer.data(), buffer.size());
+    if (read <= 0 || destination.write(buffer.constData(), read) != read) {
+      return false;
+    }
+    copied += read;
+    if (onProgress && (copied - lastNotified >= COPY_CHUNK_SIZE || copied == size)) {
+      onProgress(copied, size);
+      lastNotified = copied;
+    }
+  }
+  return true;
+}
+
+// Suffix of the hard link, before it is renamed.
+constexpr auto LINK_SUFFIX = ".link";
+
+bool createHardLink(const QString& sourcePath, const QString& linkPath) {
+#if defined(Q_OS_WIN)
+  return ::CreateHardLinkW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(linkPath).utf16()),
+           reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(sourcePath).utf16()), nullptr)
+         != 0;
+#else
+  return ::link(QFile::encodeName(sourcePath).constData(), QFile::encodeName(linkPath).constData()) == 0;
+#endif
+}
+
+// Suffix of the private copy of a hard-linked file, before it replaces the link.
+constexpr auto UNSHARE_SUFFIX = ".unshared";
+
+// Copies to a temporary file next to the destination (reflink clone if possible and allowed), then renames it.
+std::optional<MoveMethod> copyDurably(QFile& source, const QString& destinationPath,
+  const CopyProgressCallback& onProgress, bool const allowClone = true) {
+  if (!source.isOpen() && !source.open(QIODevice::ReadOnly)) {
+    return std::nullopt;
+  }
+  QSaveFile destination(destinationPath);
+  if (!destination.open(QIODevice::WriteOnly)) {
+    return std::nullopt;
+  }
+
+  auto method = MoveMethod::Clone;
+  if (!allowClone || !cloneContent(source, destination, onProgress)) {
+    method = MoveMethod::Copy;
+    if (!source.seek(0) || !destination.seek(0) || !destination.resize(0)
+        || !copyContent(source, destination, onProgress)) {
+      destination.cancelWriting();
+      return std::nullopt;
+    }
+  }
+
+  if (!commitDurably(destination)) {
+    return std::nullopt;
+  }
+  return method;
+}
+} // namespace
+
+bool syncFile(QFile& file) {
+  if (!file.isOpen() || !file.flush()) {
+    return false;
+  }
+
+  const auto handle = file.handle();
+  if (handle < 0) {
+    return false;
+  }
+
+#if defined(Q_OS_WIN)
+  return ::FlushFileBuffers(reinterpret_cast<HANDLE>(::_get_osfhandle(handle))) != 0;
+#elif defined(Q_OS_MACOS)
+  // fsync() doesn't flush the drive cache on macOS.
+  return ::fcntl(handle, F_FULLFSYNC) == 0 || ::fsync(handle) == 0;
+#else
+  return ::fsync(handle) == 0;
+#endif
+}
+
+bool syncDirectory(const QString& dirPath) {
+#if defined(Q_OS_WIN)
+  Q_UNUSED(dirPath);
+  return true;
+#else
+  const auto nativePath = QFile::encodeName(dirPath);
+  const auto handle = ::open(nativePath.constData(), O_RDONLY | O_DIRECTORY);
+  if (handle < 0) {
+    return false;
+  }
+  const auto result = ::fsync(handle) == 0;
+  ::close(handle);
+  return result;
+#endif
+}
+
+bool commitDurably(QSaveFile& file) {
+  const auto filePath = file.fileName();
+  if (!file.commit()) {
+    return false;
+  }
+  return syncDirectory(QFileInfo(filePath).absolutePath());
+}
+
+bool renameDurably(QFile& file, const QString& newFilePath) {
+  if (file.isOpen() && !syncFile(file)) {
+    return false;
+  }
+  file.close();
+
+  if (!file.rename(newFilePath)) {
+    return false;
+  }
+  return syncDirectory(QFileInfo(newFilePath).absolutePath());
+}
+
+std::optional<MoveMethod> moveFile(
+  const QString& sourcePath, const QString& destinationPath, const CopyProgressCallback& onProgress) {
+  QFile source(sourcePath);
+  if (!source.exists()) {
+    return std::nullopt;
+  }
+
+  // Same file system: instantaneous.
+  if (renameReplacing(sourcePath, destinationPath)) {
+    syncDirectory(QFileInfo(destinationPath).absolutePath());
+    if (onProgress) {
+      const auto size = QFileInfo(destinationPath).size();
+      onProgress(size, size);
+    }
+    return MoveMethod::Rename;
+  }
+
+  // Otherwise, copy to a temporary file next to the destination, then rename it.
+  const auto method = copyDurably(source, destinationPath, onProgress);
+  if (!method) {
+    return std::nullopt;
+  }
+
+  source.close();
+  // The destination is complete: failing to remove the source is not an error.
+  source.remove();
+  return method;
+}
+
+std::optional<MoveMethod> copyFile(const QString& sourcePath, const QString& destinationPath,
+  const CopyProgressCallback& onProgress, bool const allowClone) {
+  QFile source(sourcePath);
+  if (!source.exists()) {
+    return std::nullopt;
+  }
+  return copyDurably(source, destinationPath, onProgress, allowClone);
+}
+
+bool linkOrCopyFile(
+  const QString& sourcePath, const QString& destinationPath, const CopyProgressCallback& onProgress) {
+  QFile source(sourcePath);
+  if (!source.exists()) {
+    return false;
+  }
+
+  // Linked next to the destination, then renamed, so that the destination is replaced atomically.
+  const auto linkPath = destinationPath + LINK_SUFFIX;
+  QFile::remove(linkPath);
+  if (createHardLink(sourcePath, linkPath)) {
+    if (renameReplacing(linkPath, destinationPath)) {
+      // The rename does nothing if the destination already was a link to the same file.
+      QFile::remove(linkPath);
+      syncDirectory(QFileInfo(destinationPath).absolutePath());
+      return true;
+    }
+    QFile::remove(linkPath);
+    return false;
+  }
+
+  return copyDurably(source, destinationPath, onProgress).has_value();
+}
+std::optional<quint64> hardLinkCount(const QString& filePath) {
+#if defined(Q_OS_WIN)
+  const auto handle = ::CreateFileW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(filePath).utf16()), 0,
+    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS,
+    nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return std::nullopt;
+  }
+  BY_HANDLE_FILE_INFORMATION information;
+  const auto result = ::GetFileInformationByHandle(handle, &information) != 0;
+  ::CloseHandle(handle);
+  if (!result) {
+    return std::nullopt;
+  }
+  return static_cast<quint64>(information.nNumberOfLinks);
+#else
+  struct stat status;
+  if (::stat(QFile::encodeName(filePath).constData(), &status) != 0) {
+    return std::nullopt;
+  }
+  return static_cast<quint64>(status.st_nlink);
+#endif
+}
+
+bool unshareFile(const QString& filePath) {
+  const auto linkCount = hardLinkCount(filePath);
+  if (!linkCount) {
+    return false;
+  }
+  if (*linkCount <= 1) {
+    return true;
+  }
+
+  // Copied next to the file (a reflink clone if possible), then renamed: the other links keep the old content.
+  const auto copyPath = filePath + UNSHARE_SUFFIX;
+  QFile source(filePath);
+  if (!copyDurably(source, copyPath, nullptr)) {
+    return false;
+  }
+  source.close();
+  if (!QFile::setPermissions(copyPath, QFile::permissions(filePath)) || !renameReplacing(copyPath, filePath)) {
+    QFile::remove(copyPath);
+    return false;
+  }
+  syncDirectory(QFileInfo(filePath).absolutePath());
+  return true;
+}
+} // namespace oclero::fileutils
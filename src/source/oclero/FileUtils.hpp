@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QString>
+
+#include <functional>
+#include <optional>
+
+class QFile;
+class QSaveFile;
+
+namespace oclero::fileutils {
+/**
+ * @brief Flushes the file and asks the OS to write its content to the storage device (fsync).
+ * The file must be open.
+ */
+bool syncFile(QFile& file);
+
+/**
+ * @brief Asks the OS to write the directory entries to the storage device, so that a rename or a file
+ * creation survives a power loss. Does nothing on Windows, where it is not needed.
+ */
+bool syncDirectory(const QString& dirPath);
+
+/**
+ * @brief Commits the file (QSaveFile syncs and renames it), then syncs its directory.
+ */
+bool commitDurably(QSaveFile& file);
+
+/**
+ * @brief Syncs the file, closes it and renames it, then syncs the destination directory.
+ * The destination must not exist. On failure, the file is left as is.
+ */
+bool renameDurably(QFile& file, const QString& newFilePath);
+
+enum class MoveMethod {
+  Rename, // Same file system: nothing is copied.
+  Clone, // Copy-on-write clone (reflink), or in-kernel copy.
+  Copy, // Streamed copy.
+};
+
+using CopyProgressCallback = std::function<void(qint64 const bytesCopied, qint64 const bytesTotal)>;
+
+/**
+ * @brief Moves a file, replacing the destination if it exists.
+ * Tries a rename first, then (on Linux) a reflink clone or an in-kernel copy, and only then a streamed copy.
+ * The destination is complete or untouched: copies are written to a temporary file, synced and renamed.
+ * The source is removed only once the destination is complete.
+ * @return The method used, or nothing if the file could not be moved.
+ */
+std::optional<MoveMethod> moveFile(
+  const QString& sourcePath, const QString& destinationPath, const CopyProgressCallback& onProgress = nullptr);
+
+/**
+ * @brief Copies a file, replacing the destination if it exists. The destination is complete or untouched.
+ * Tries (on Linux) a reflink clone or an in-kernel copy, unless not allowed, and then a streamed copy.
+ * @return The method used (never Rename), or nothing if the file could not be copied.
+ */
+std::optional<MoveMethod> copyFile(const QString& sourcePath, const QString& destinationPath,
+  const CopyProgressCallback& onProgress = nullptr, bool const allowClone = true);
+
+/**
+ * @brief Creates a hard link to the file, replacing the destination if it exists. Both paths then share
+ * the same content, so the file must not be modified in place. Falls back to a copy (a reflink clone if possible)
+ * if the file system or the volume doesn't allow it. The destination is complete or untouched.
+ */
+bool linkOrCopyFile(
+  const QString& sourcePath, const QString& destinationPath, const CopyProgressCallback& onProgress = nullptr);
+
+/**
+ * @brief Number of hard links to the file, or nothing if it can't be read.
+ */
+std::optional<quint64> hardLinkCount(const QString& filePath);
+
+/**
+ * @brief Makes sure that the file doesn't share its content with another path (see linkOrCopyFile()), by replacing
+ * it with a copy (a reflink clone if possible) if it has several hard links. Its permissions are kept.
+ * Call it before changing the file in place, e.g. its permissions. Does nothing if the file has a single link.
+ */
+bool unshareFile(const QString& filePath);
+} // namespace oclero::fileutils
@@ -0,0 +1,148 @@
+#include "Mirrors.hpp"
+
+#include <QCryptographicHash>
+#include <QNetworkAccessManager>
+#include <QNetworkInterface>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+
+namespace oclero::mirrors {
+namespace {
+// Status of an answer to a Range request.
+constexpr auto HTTP_PARTIAL_CONTENT = 206;
+} // namespace
+
+QString networkId() {
+  QStringList subnets;
+  for (const auto& networkInterface : QNetworkInterface::allInterfaces()) {
+    const auto flags = networkInterface.flags();
+    if (!flags.testFlag(QNetworkInterface::IsUp) || !flags.testFlag(QNetworkInterface::IsRunning)
+        || flags.testFlag(QNetworkInterface::IsLoopBack)) {
+      continue;
+    }
+    for (const auto& entry : networkInterface.addressEntries()) {
+      const auto address = entry.ip();
+      if (address.protocol() != QAbstractSocket::IPv4Protocol) {
+        continue;
+      }
+      const auto subnet = QHostAddress(address.toIPv4Address() & entry.netmask().toIPv4Address());
+      subnets.append(subnet.toString() + '/' + QString::number(entry.prefixLength()));
+    }
+  }
+  subnets.sort();
+  subnets.removeDuplicates();
+  return QString::fromLatin1(
+    QCryptographicHash::hash(subnets.join(',').toUtf8(), QCryptographicHash::Sha1).toHex().left(16));
+}
+
+void race(const QVector<QUrl>& urls, QNetworkAccessManager* manager, QObject& context, int const timeout,
+  const RaceCallback& onFinished) {
+  // Deleted with the context: the callback is then never called.
+  auto* raceContext = new QObject(&context);
+  auto* raceManager = manager ? manager : new QNetworkAccessManager(raceContext);
+  auto replies = std::make_shared<QVector<QPointer<QNetworkReply>>>();
+  auto pending = std::make_shared<int>(urls.size());
+  auto finished = std::make_shared<bool>(false);
+  const auto finish = [raceContext, finished, onFinished](const QUrl& url) {
+    if (*finished) {
+      return;
+    }
+    *finished = true;
+    raceContext->deleteLater();
+    onFinished(url);
+  };
+
+  // The requests still running are aborted once the race is decided.
+  QObject::connect(raceContext, &QObject::destroyed, [replies, finished]() {
+    *finished = true;
+    for (const auto& reply : *replies) {
+      if (reply) {
+        reply->abort();
+        reply->deleteLater();
+      }
+    }
+  });
+
+  for (const auto& url : urls) {
+    auto request = QNetworkRequest(url);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::SameOriginRedirectPolicy);
+    request.setTransferTimeout(timeout);
+    request.setRawHeader("Range", "bytes=0-0");
+    auto* reply = raceManager->get(request);
+    replies->append(reply);
+
+    // First byte wins: the response headers alone don't tell that the mirror can send the file.
+    // A mirror that ignores the Range request would send the whole file: it wins as soon as the byte arrives.
+    QObject::connect(reply, &QNetworkReply::readyRead, raceContext, [reply, url, finish]() {
+      const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+      if (reply->error() == QNetworkReply::NoError && status != HTTP_PARTIAL_CONTENT
+          && (status == 0 || (status >= 200 && status < 300))) {
+        finish(url);
+      }
+    });
+    // Otherwise, it wins once the byte is received: its connection is then free for the download, instead of
+    // being closed by the abort.
+    QObject::connect(reply, &QNetworkReply::finished, raceContext, [reply, url, pending, finish]() {
+      const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+      if (reply->error() == QNetworkReply::NoError && status == HTTP_PARTIAL_CONTENT) {
+        finish(url);
+        return;
+      }
+      if (--*pending == 0) {
+        finish({});
+      }
+    });
+  }
+
+  // Called asynchronously, as when a mirror answers.
+  QTimer::singleShot(urls.isEmpty() ? 0 : timeout, raceContext, [finish]() {
+    finish({});
+  });
+}
+
+QUrl pickWeighted(const QVector<UpdateJSON::Mirror>& mirrors) {
+  auto totalWeight = 0.;
+  for (const auto& mirror : mirrors) {
+    totalWeight += std::max(0., mirror.weight);
+  }
+  if (totalWeight <= 0.) {
+    return mirrors.isEmpty() ? QUrl{} : mirrors.first().url;
+  }
+
+  auto value = QRandomGenerator::global()->bounded(totalWeight);
+  QUrl result;
+  for (const auto& mirror : mirrors) {
+    if (mirror.weight <= 0.) {
+      continue;
+    }
+    result = mirror.url;
+    if (value < mirror.weight) {
+      break;
+    }
+    value -= mirror.weight;
+  }
+  return result;
+}
+
+QVector<QUrl> fallbacks(const QVector<UpdateJSON::Mirror>& mirrors, const QUrl& selectedUrl) {
+  auto sortedMirrors = mirrors;
+  std::stable_sort(sortedMirrors.begin(), sortedMirrors.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.weight > rhs.weight;
+  });
+
+  QVector<QUrl> result;
+  for (const auto& mirror : sortedMirrors) {
+    if (mirror.url != selectedUrl && !result.contains(mirror.url)) {
+      result.append(mirror.url);
+    }
+  }
+  return result;
+}
+} // namespace oclero::mirrors
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+#include <oclero/UpdateJSON.hpp>
+
+#include <functional>
+
+class QNetworkAccessManager;
+
+namespace oclero::mirrors {
+using RaceCallback = std::function<void(const QUrl& url)>;
+
+/**
+ * @brief Identifies the network the machine is connected to, from the subnets of its active interfaces.
+ * The fastest mirror depends on it: e.g. a mirror of the office network is useless at home.
+ */
+QString networkId();
+
+/**
+ * @brief Sends a one-byte Range request to each URL, and calls back with the first one that sends data,
+ * or with an invalid URL if none does within the timeout. The other requests are then aborted.
+ * The callback is never called if the context is destroyed before.
+ * @param manager Manager to send the requests with, so that the download reuses the connection of the winner
+ * (a temporary one is used if nullptr). A winner that honors the Range request is left to finish for this purpose.
+ */
+void race(const QVector<QUrl>& urls, QNetworkAccessManager* manager, QObject& context, int const timeout,
+  const RaceCallback& onFinished);
+
+/**
+ * @brief Picks one of the mirrors with a positive weight, randomly, proportionally to its weight.
+ */
+QUrl pickWeighted(const QVector<UpdateJSON::Mirror>& mirrors);
+
+/**
+ * @brief The mirrors to fail over to when the selected one fails, by decreasing weight.
+ */
+QVector<QUrl> fallbacks(const QVector<UpdateJSON::Mirror>& mirrors, const QUrl& selectedUrl);
+} // namespace oclero::mirrors
@@ -0,0 +1,267 @@
+#include "PeerNetwork.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkDatagram>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+
+namespace oclero {
+namespace {
+// Identifies the datagrams of this protocol.
+constexpr auto PROTOCOL_NAME = "qtupdater-peer";
+constexpr auto PROTOCOL_VERSION = 1;
+// Requests are only a few lines: anything larger is not one.
+constexpr qint64 MAX_REQUEST_SIZE = 8 * 1024;
+// Data waiting to be sent to a peer, read from the file as it is sent.
+constexpr qint64 SEND_BUFFER_SIZE = 256 * 1024;
+// Reaches every socket bound to the discovery port on this machine.
+constexpr auto LOOPBACK_BROADCAST_ADDRESS = "127.255.255.255";
+
+QByteArray datagram(QJsonObject message) {
+  message.insert("protocol", PROTOCOL_NAME);
+  message.insert("version", PROTOCOL_VERSION);
+  return QJsonDocument(message).toJson(QJsonDocument::Compact);
+}
+
+QJsonObject parseDatagram(const QByteArray& data) {
+  const auto message = QJsonDocument::fromJson(data).object();
+  if (message.value("protocol").toString() != PROTOCOL_NAME || message.value("version").toInt() != PROTOCOL_VERSION) {
+    return {};
+  }
+  return message;
+}
+
+void respond(QTcpSocket& socket, const QByteArray& status, const QByteArray& extraHeaders = {}) {
+  socket.write("HTTP/1.1 " + status + "\r\nContent-Length: 0\r\nConnection: close\r\n" + extraHeaders + "\r\n");
+  socket.disconnectFromHost();
+}
+} // namespace
+
+PeerNetwork::PeerNetwork(QObject& owner)
+  : _owner(owner) {
+  _discoverySocket.setParent(&owner);
+  _server.setParent(&owner);
+  QObject::connect(&_discoverySocket, &QUdpSocket::readyRead, &owner, [this]() {
+    onDiscoveryDatagrams();
+  });
+  QObject::connect(&_server, &QTcpServer::newConnection, &owner, [this]() {
+    onNewConnection();
+  });
+}
+
+PeerNetwork::~PeerNetwork() {
+  stop();
+}
+
+void PeerNetwork::share(const QString& key, const QString& filePath, quint16 const discoveryPort) {
+  if (_discoverySocket.state() == QAbstractSocket::BoundState && _discoverySocket.localPort() != discoveryPort) {
+    stop();
+  }
+  if (_discoverySocket.state() != QAbstractSocket::BoundState && !start(discoveryPort)) {
+    return;
+  }
+  _files.insert(key, filePath);
+}
+
+void PeerNetwork::unshareAll() {
+  _files.clear();
+  stop();
+}
+
+bool PeerNetwork::isSharing() const {
+  return !_files.isEmpty();
+}
+
+void PeerNetwork::find(const QString& key, const QString& discoveryAddress, quint16 const discoveryPort,
+  int const timeout, const FoundCallback& onFound) {
+  // Deleted with the owner: the callback is then never called.
+  auto* socket = new QUdpSocket(&_owner);
+  auto* timer = new QTimer(socket);
+  auto finished = std::make_shared<bool>(false);
+  const auto finish = [socket, finished, onFound](const QUrl& url) {
+    if (*finished) {
+      return;
+    }
+    *finished = true;
+    socket->deleteLater();
+    onFound(url);
+  };
+
+  QObject::connect(socket, &QUdpSocket::readyRead, socket, [socket, key, finish]() {
+    while (socket->hasPendingDatagrams()) {
+      const auto received = socket->receiveDatagram();
+      const auto message = parseDatagram(received.data());
+      const auto port = message.value("port").toInt();
+      const auto path = message.value("path").toString();
+      if (message.value("offer").toString() == key && port > 0 && path.startsWith('/' + key + '/')) {
+        QUrl url;
+        url.setScheme("http");
+        url.setHost(received.senderAddress().toString());
+        url.setPort(port);
+        url.setPath(path);
+        finish(url);
+        return;
+      }
+    }
+  });
+  QObject::connect(timer, &QTimer::timeout, socket, [finish]() {
+    finish({});
+  });
+
+  // The updaters of the machine share the discovery port, and a unicast datagram reaches only one of them.
+  // On Linux, the loopback network has a broadcast address that reaches all of them.
+  auto address = QHostAddress(discoveryAddress);
+#if defined(Q_OS_LINUX)
+  if (address.isLoopback() && address.protocol() == QAbstractSocket::IPv4Protocol) {
+    address = QHostAddress(LOOPBACK_BROADCAST_ADDRESS);
+  }
+#endif
+
+  const auto query = datagram({ { "query", key } });
+  if (!socket->bind(QHostAddress::AnyIPv4, 0) || socket->writeDatagram(query, address, discoveryPort) != query.size()) {
+    // Called asynchronously, as when a peer answers.
+    QTimer::singleShot(0, socket, [finish]() {
+      finish({});
+    });
+    return;
+  }
+  timer->setSingleShot(true);
+  timer->start(timeout);
+}
+
+bool PeerNetwork::start(quint16 const discoveryPort) {
+  // Several updaters of the same machine may listen to the discovery port.
+  if (!_discoverySocket.bind(
+        QHostAddress::AnyIPv4, discoveryPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+    return false;
+  }
+  if (!_server.listen(QHostAddress::AnyIPv4, 0)) {
+    _discoverySocket.close();
+    return false;
+  }
+  return true;
+}
+
+void PeerNetwork::stop() {
+  _discoverySocket.close();
+  _server.close();
+}
+
+void PeerNetwork::onDiscoveryDatagrams() {
+  while (_discoverySocket.hasPendingDatagrams()) {
+    const auto received = _discoverySocket.receiveDatagram();
+    const auto message = parseDatagram(received.data());
+    const auto key = message.value("query").toString();
+    if (key.isEmpty() || !_files.contains(key) || !QFileInfo::exists(_files.value(key))) {
+      continue;
+    }
+
+    // The file name is kept, as it is the name of the downloaded file.
+    const auto path = '/' + key + '/' + QFileInfo(_files.value(key)).fileName();
+    const auto offer = datagram({ { "offer", key }, { "port", _server.serverPort() }, { "path", path } });
+    _discoverySocket.writeDatagram(offer, received.senderAddress(), static_cast<quint16>(received.senderPort()));
+  }
+}
+
+void PeerNetwork::onNewConnection() {
+  while (auto* socket = _server.nextPendingConnection()) {
+    QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+      onRequest(*socket);
+    });
+  }
+}
+
+void PeerNetwork::onRequest(QTcpSocket& socket) {
+  // Wait for the end of the header.
+  if (!socket.peek(MAX_REQUEST_SIZE).contains("\r\n\r\n")) {
+    if (socket.bytesAvailable() >= MAX_REQUEST_SIZE) {
+      socket.abort();
+    }
+    return;
+  }
+  QObject::disconnect(&socket, &QTcpSocket::readyRead, nullptr, nullptr);
+
+  const auto lines = socket.readAll().split('\n');
+  const auto requestLine = lines.first().trimmed().split(' ');
+  if (requestLine.size() < 2 || requestLine[0] != "GET") {
+    respond(socket, "405 Method Not Allowed");
+    return;
+  }
+
+  // Path: "/<key>/<file name>".
+  const auto key = QUrl::fromPercentEncoding(requestLine[1]).section('/', 1, 1);
+  auto file = std::make_unique<QFile>(_files.value(key));
+  if (key.isEmpty() || !_files.contains(key) || !file->open(QIODevice::ReadOnly)) {
+    respond(socket, "404 Not Found");
+    return;
+  }
+
+  // Only single ranges are supported: "bytes=first-" or "bytes=first-last".
+  const auto size = file->size();
+  auto first = qint64{ 0 };
+  auto last = size - 1;
+  auto partial = false;
+  for (const auto& line : lines) {
+    const auto header = line.trimmed();
+    if (!header.toLower().startsWith("range:")) {
+      continue;
+    }
+    const auto range = header.mid(header.indexOf('=') + 1).split('-');
+    // Suffix ranges ("bytes=-last") are not supported: the whole file is sent.
+    if (range.size() != 2 || range[0].isEmpty()) {
+      continue;
+    }
+    first = range[0].toLongLong();
+    if (!range[1].isEmpty()) {
+      last = std::min(last, range[1].toLongLong());
+    }
+    partial = true;
+  }
+  if (first < 0 || first > last || (partial && first >= size)) {
+    respond(socket, "416 Range Not Satisfiable", "Content-Range: bytes */" + QByteArray::number(size) + "\r\n");
+    return;
+  }
+
+  QByteArray header = partial ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+  header += "Content-Type: application/octet-stream\r\n";
+  header += "Content-Length: " + QByteArray::number(last - first + 1) + "\r\n";
+  if (partial) {
+    header += "Content-Range: bytes " + QByteArray::number(first) + '-' + QByteArray::number(last) + '/'
+              + QByteArray::number(size) + "\r\n";
+  }
+  header += "Accept-Ranges: bytes\r\nConnection: close\r\n\r\n";
+  socket.write(header);
+  if (!file->seek(first)) {
+    socket.abort();
+    return;
+  }
+
+  // The file is read as it is sent.
+  auto* source = file.release();
+  source->setParent(&socket);
+  auto remaining = std::make_shared<qint64>(last - first + 1);
+  const auto sendMore = [&socket, source, remaining]() {
+    while (*remaining > 0 && socket.bytesToWrite() < SEND_BUFFER_SIZE) {
+      const auto chunk = source->read(std::min(*remaining, SEND_BUFFER_SIZE));
+      if (chunk.isEmpty()) {
+        socket.abort();
+        return;
+      }
+      socket.write(chunk);
+      *remaining -= chunk.size();
+    }
+    if (*remaining == 0) {
+      socket.disconnectFromHost();
+    }
+  };
+  QObject::connect(&socket, &QTcpSocket::bytesWritten, &socket, sendMore);
+  sendMore();
+}
+} // namespace oclero
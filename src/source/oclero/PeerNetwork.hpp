@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QUrl>
+#include <QUdpSocket>
+#include <QTcpServer>
+
+#include <functional>
+
+class QTcpSocket;
+
+namespace oclero {
+/**
+ * @brief Shares verified files with the other updaters of the local network, and finds the files they share.
+ * A file is looked for with a UDP datagram (broadcast by default). The peers that have it answer with the port
+ * and the path of a minimal HTTP server that serves it. Files are identified by their checksum: the receiver must verify them.
+ */
+class PeerNetwork {
+public:
+  using FoundCallback = std::function<void(const QUrl& url)>;
+
+  // The sockets are children of the owner, so they move along with it to another thread.
+  explicit PeerNetwork(QObject& owner);
+  ~PeerNetwork();
+
+  // The discovery port and the HTTP server are only bound while files are shared.
+  void share(const QString& key, const QString& filePath, quint16 const discoveryPort);
+  void unshareAll();
+  bool isSharing() const;
+
+  // Calls back with the URL of the file on the first peer that answers, or with an invalid URL after the timeout.
+  void find(const QString& key, const QString& discoveryAddress, quint16 const discoveryPort, int const timeout,
+    const FoundCallback& onFound);
+
+private:
+  bool start(quint16 const discoveryPort);
+  void stop();
+  void onDiscoveryDatagrams();
+  void onNewConnection();
+  void onRequest(QTcpSocket& socket);
+
+private:
+  QObject& _owner;
+  QUdpSocket _discoverySocket;
+  QTcpServer _server;
+  // Shared files, by key.
+  QHash<QString, QString> _files;
+};
+} // namespace oclero
@@ -1,6 +1,8 @@
 #include <oclero/QtDownloader.hpp>
 
 #include <oclero/QtPointerUtils.hpp>
+#include <oclero/FileUtils.hpp>
+#include <oclero/QtInstallStrategy.hpp>
 
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
@@ -10,17 +12,116 @@
 #include <QDir>
 #include <QCryptographicHash>
 #include <QPointer>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <optional>
+#include <atomic>
 #include <cmath>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#if defined(Q_OS_LINUX)
+#  include <fcntl.h>
+#endif
 
 namespace oclero {
 static const QString PARTIAL_DOWNLOAD_SUFFIX = ".part";
 static const int PARTIAL_DOWNLOAD_SUFFIX_LENGTH = PARTIAL_DOWNLOAD_SUFFIX.length();
+// Minimum duration between two transfer rate samples, in milliseconds.
+static constexpr qint64 RATE_SAMPLE_INTERVAL = 250;
+// Weight of the last sample in the smoothed transfer rate.
+static constexpr double RATE_SMOOTHING_FACTOR = 0.3;
+// Size of the part of the file mapped at once when computing a checksum.
+static constexpr qint64 CHECKSUM_MAP_WINDOW_SIZE = 256 * 1024 * 1024;
+// Size of the buffer used when the file can't be mapped.
+static constexpr qint64 CHECKSUM_READ_BUFFER_SIZE = 4 * 1024 * 1024;
+// Size of the data given at once to the hash function.
+static constexpr qint64 CHECKSUM_CHUNK_SIZE = 16 * 1024 * 1024;
+// Minimum amount of data between two checksum progress notifications.
+static constexpr qint64 CHECKSUM_PROGRESS_INTERVAL = 64 * 1024 * 1024;
+// The download is aborted when at least this many blocks, and more than a quarter of the blocks, are corrupted.
+static constexpr int MIN_CORRUPTED_BLOCKS_FOR_MISMATCH = 3;
+// Number of times a corrupted block is downloaded again before giving up.
+static constexpr int MAX_BLOCK_REPAIR_ATTEMPTS = 2;
+static constexpr auto EXTRACTION_PROGRAM = "tar";
+static const QString EXTRACTION_STAGING_SUFFIX = ".staging";
+static const QString EXTRACTION_PREVIOUS_SUFFIX = ".previous";
+// Maximum amount of data waiting to be written to tar's input. The network isn't read meanwhile.
+static constexpr qint64 EXTRACTION_MAX_PENDING_BYTES = 8 * 1024 * 1024;
+// Size of the pieces of data read at once from the network when writing to a file or to tar.
+static constexpr qint64 READ_CHUNK_SIZE = 1024 * 1024;
+// Interval between two bandwidth allowance refills, in milliseconds.
+static constexpr int THROTTLE_INTERVAL = 100;
+// Minimum size of the network read buffer when the bandwidth is limited.
+static constexpr qint64 THROTTLE_MIN_READ_BUFFER_SIZE = 16 * 1024;
+// Interval between two throughput samples for stall detection, in milliseconds.
+static constexpr int STALL_SAMPLE_INTERVAL = 1000;
+// Weight of the last time to first byte in the smoothed one of the host.
+static constexpr double HOST_TTFB_SMOOTHING_FACTOR = 0.3;
+// The response deadline is halved for each request without response, up to this count.
+static constexpr int MAX_RESPONSE_TIMEOUT_HALVINGS = 8;
+static constexpr auto BLOCK_MANIFEST_TAG_SIZE = "size";
+static constexpr auto BLOCK_MANIFEST_TAG_BLOCK_SIZE = "blockSize";
+static constexpr auto BLOCK_MANIFEST_TAG_BLOCKS = "blocks";
 
 struct QtDownloader::Impl {
+  // Hashes data received piece by piece, for any checksum type.
+  class StreamHasher {
+  public:
+    StreamHasher(QCryptographicHash::Algorithm const algorithm, bool const tree)
+      : _hash(algorithm)
+      , _tree(tree) {}
+
+    void addData(const QByteArray& data) {
+      if (!_tree) {
+        _hash.addData(data);
+        return;
+      }
+
+      auto offset = 0;
+      while (offset < data.size()) {
+        const auto length =
+          static_cast<int>(std::min<qint64>(TreeHashBlockSize - _block.size(), data.size() - offset));
+        _block.append(data.constData() + offset, length);
+        offset += length;
+        if (_block.size() == TreeHashBlockSize) {
+          addBlock();
+        }
+      }
+    }
+
+    QByteArray result() {
+      if (_tree && !_block.isEmpty()) {
+        addBlock();
+      }
+      return _hash.result();
+    }
+
+  private:
+    void addBlock() {
+      _hash.addData(QCryptographicHash::hash(_block, QCryptographicHash::Algorithm::Sha256));
+      _block.truncate(0);
+    }
+
+    QCryptographicHash _hash;
+    bool _tree{ false };
+    QByteArray _block;
+  };
+
   QtDownloader& owner;
-  QNetworkAccessManager manager;
+  QNetworkAccessManager ownManager;
+  QPointer<QNetworkAccessManager> sharedManager;
   QUrl url;
   QFileInfo fileInfo;
   QScopedPointer<QFile> fileStream{ nullptr };
@@ -30,6 +131,8 @@ struct QtDownloader::Impl {
   QMetaObject::Connection progressConnection;
   QMetaObject::Connection readyReadConnection;
   QMetaObject::Connection finishedConnection;
+  QMetaObject::Connection metaDataConnection;
+  QMetaObject::Connection encryptedConnection;
   FileFinishedCallback onFileFinished;
   DataFinishedCallback onDataFinished;
   ProgressCallback onProgress;
@@ -37,20 +140,393 @@ struct QtDownloader::Impl {
   QString downloadedFilepath;
   QByteArray downloadedData;
   int timeout{ DefaultTimeout };
+  ProgressPolicy progressPolicy;
+  Progress progress;
+  TimeoutPolicy timeoutPolicy;
+  std::shared_ptr<HostStatisticsMap> hostStatistics{ std::make_shared<HostStatisticsMap>() };
+  QTimer responseTimer;
+  QTimer stallTimer;
+  // Bytes received at each sample of the stall window, the most recent last.
+  QVector<qint64> stallSamples;
+  // Why the reply was aborted by a deadline, if it was.
+  QString timeoutReason;
+  // Local files are read, linked or copied in a worker thread, without the network stack.
+  QFutureWatcher<bool> localFileWatcher;
+  QFutureWatcher<std::optional<QByteArray>> localDataWatcher;
+  QTimer localCopyTimer;
+  std::shared_ptr<std::atomic<qint64>> localBytesCopied;
+  qint64 localFileSize{ 0 };
+  QElapsedTimer progressTimer;
+  qint64 lastProgressNotification{ -1 };
+  qint64 lastRateSampleTime{ 0 };
+  qint64 lastRateSampleBytes{ 0 };
+  TransferMetrics metrics;
+  // Manifest set for the next file download, and manifest of the current one.
+  BlockManifest nextBlockManifest;
+  BlockManifest blockManifest;
+  QByteArray currentBlock;
+  int currentBlockIndex{ 0 };
+  int checkedBlockCount{ 0 };
+  QVector<int> corruptedBlocks;
+  bool blockMismatch{ false };
+  QByteArray repairedBlock;
+  int blockRepairAttempts{ 0 };
+  ExtractionOptions extractionOptions;
+  // Deleted later, as it may be deleted when it emits a signal.
+  QScopedPointer<QProcess, QScopedPointerDeleteLater> extractor{ nullptr };
+  std::unique_ptr<StreamHasher> extractionHasher;
+  QString extractionStagingPath;
+  bool extractorFailed{ false };
+  QMetaObject::Connection extractorBytesWrittenConnection;
+  QMetaObject::Connection extractorFinishedConnection;
+  qint64 bandwidthLimit{ 0 };
+  qint64 bandwidthAllowance{ std::numeric_limits<qint64>::max() };
+  QTimer throttleTimer;
+  bool paused{ false };
+  bool repairing{ false };
+  // Position in the file of the first byte of the current request (non-zero when resumed).
+  qint64 requestOffset{ 0 };
+  bool resumedReplyUnchecked{ false };
+  // Mirrors set for the next file download, and mirrors of the current one not tried yet.
+  QVector<QUrl> nextMirrorUrls;
+  QVector<QUrl> remainingMirrorUrls;
 
   Impl(QtDownloader& o)
     : owner(o) {
-    manager.setAutoDeleteReplies(false);
+    // Children move along with the downloader when it is moved to another thread.
+    ownManager.setParent(&owner);
+    throttleTimer.setParent(&owner);
+    responseTimer.setParent(&owner);
+    stallTimer.setParent(&owner);
+    localFileWatcher.setParent(&owner);
+    localDataWatcher.setParent(&owner);
+    localCopyTimer.setParent(&owner);
+    ownManager.setAutoDeleteReplies(false);
+
+    responseTimer.setSingleShot(true);
+    QObject::connect(&responseTimer, &QTimer::timeout, &owner, [this]() {
+      abortForTimeout(QStringLiteral("No response from the server"));
+    });
+    stallTimer.setInterval(STALL_SAMPLE_INTERVAL);
+    QObject::connect(&stallTimer, &QTimer::timeout, &owner, [this]() {
+      onStallSample();
+    });
+
+    localCopyTimer.setInterval(THROTTLE_INTERVAL);
+    QObject::connect(&localCopyTimer, &QTimer::timeout, &owner, [this]() {
+      onDownloadProgress(*localBytesCopied, localFileSize);
+    });
+    QObject::connect(&localFileWatcher, &QFutureWatcher<bool>::finished, &owner, [this]() {
+      onLocalFileCopied();
+    });
+    QObject::connect(&localDataWatcher, &QFutureWatcher<std::optional<QByteArray>>::finished, &owner, [this]() {
+      onLocalDataRead();
+    });
+
+    throttleTimer.setInterval(THROTTLE_INTERVAL);
+    throttleTimer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&throttleTimer, &QTimer::timeout, &owner, [this]() {
+      // No more than one second of data may accumulate, to keep the transfer rate smooth.
+      bandwidthAllowance =
+        std::min(bandwidthAllowance + bandwidthLimit * THROTTLE_INTERVAL / 1000, std::max(bandwidthLimit, qint64{ 1 }));
+      readReceivedData();
+    });
   }
 
   ~Impl() {
+    disconnectReply();
+    if (extractor) {
+      discardExtraction();
+    }
+  }
+
+  QNetworkAccessManager& manager() {
+    return sharedManager ? *sharedManager : ownManager;
+  }
+
+  void disconnectReply() {
+    responseTimer.stop();
+    stallTimer.stop();
     QObject::disconnect(progressConnection);
     QObject::disconnect(readyReadConnection);
     QObject::disconnect(finishedConnection);
+    QObject::disconnect(metaDataConnection);
+    QObject::disconnect(encryptedConnection);
+  }
+
+  void resetProgress() {
+    progress = {};
+    progressTimer.start();
+    lastProgressNotification = -1;
+    lastRateSampleTime = 0;
+    lastRateSampleBytes = 0;
+    metrics = {};
+    metrics.url = url;
+  }
+
+  void connectMetrics() {
+    startResponseDeadline();
+    metaDataConnection = QObject::connect(reply, &QNetworkReply::metaDataChanged, &owner, [this]() {
+      if (metrics.timeToFirstByte < 0) {
+        metrics.timeToFirstByte = progressTimer.elapsed();
+      }
+      startStallDetection();
+    });
+    encryptedConnection = QObject::connect(reply, &QNetworkReply::encrypted, &owner, [this]() {
+      metrics.secureConnectionTime = progressTimer.elapsed();
+    });
+  }
+
+  void finishMetrics(ErrorCode const errorCode) {
+    metrics.totalTime = progressTimer.elapsed();
+    metrics.error = errorCode;
+    metrics.bytesOnWire = std::max(metrics.bytesOnWire, progress.bytesReceived);
+    if (metrics.totalTime > 0) {
+      metrics.averageBytesPerSecond = metrics.bytesDecoded * 1000. / metrics.totalTime;
+    }
+    metrics.peakBytesPerSecond = std::max(metrics.peakBytesPerSecond, metrics.averageBytesPerSecond);
+    if (reply) {
+      metrics.httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+      metrics.networkError = static_cast<int>(reply->error());
+      if (reply->error() != QNetworkReply::NoError) {
+        metrics.errorString = timeoutReason.isEmpty() ? reply->errorString() : timeoutReason;
+      }
+    }
+  }
+
+  // Deadline of the response, from what is known of the host.
+  int responseTimeout() const {
+    const auto statistics = hostStatistics ? hostStatistics->value(url.host()) : HostStatistics{};
+    auto result = statistics.timeToFirstByte >= 0.
+                    ? static_cast<qint64>(timeoutPolicy.responseTimeoutFactor * statistics.timeToFirstByte)
+                    : qint64{ timeoutPolicy.maxResponseTimeout };
+    // The host didn't answer the previous requests: it is probably down.
+    result >>= std::min(statistics.consecutiveFailures, MAX_RESPONSE_TIMEOUT_HALVINGS);
+    const auto minTimeout = qint64{ timeoutPolicy.minResponseTimeout };
+    const auto maxTimeout = std::max(minTimeout, qint64{ timeoutPolicy.maxResponseTimeout });
+    return static_cast<int>(std::clamp(result, minTimeout, maxTimeout));
+  }
+
+  void startResponseDeadline() {
+    timeoutReason.clear();
+    stallSamples.clear();
+    if (timeoutPolicy.enabled) {
+      responseTimer.start(responseTimeout());
+    }
+  }
+
+  void startStallDetection() {
+    responseTimer.stop();
+    if (timeoutPolicy.enabled && !stallTimer.isActive()) {
+      stallSamples = { progress.bytesReceived };
+      stallTimer.start();
+    }
+  }
+
+  // Fails the download if the throughput over the stall window is too low.
+  void onStallSample() {
+    stallSamples.append(progress.bytesReceived);
+    const auto windowSampleCount = std::max(1, timeoutPolicy.stallWindow / STALL_SAMPLE_INTERVAL);
+    if (stallSamples.size() <= windowSampleCount) {
+      return;
+    }
+    stallSamples.removeFirst();
+
+    // A low bandwidth limit is not a stall.
+    auto minBytesPerSecond = timeoutPolicy.minBytesPerSecond;
+    if (bandwidthLimit > 0) {
+      minBytesPerSecond = std::min(minBytesPerSecond, bandwidthLimit / 2);
+    }
+    const auto bytesReceived = stallSamples.last() - stallSamples.first();
+    if (bytesReceived < minBytesPerSecond * windowSampleCount * STALL_SAMPLE_INTERVAL / 1000) {
+      abortForTimeout(QStringLiteral("Transfer stalled"));
+    }
+  }
+
+  // The reply finishes with an error, as if the connection failed.
+  void abortForTimeout(const QString& reason) {
+    if (!reply || reply->isFinished()) {
+      return;
+    }
+    timeoutReason = reason;
+    reply->abort();
+  }
+
+  void updateHostStatistics(ErrorCode const errorCode) {
+    if (!timeoutPolicy.enabled || !hostStatistics || metrics.url.host().isEmpty()) {
+      return;
+    }
+
+    auto& statistics = (*hostStatistics)[metrics.url.host()];
+    if (metrics.timeToFirstByte >= 0) {
+      // After a failover, the time to first byte is the first mirror's one.
+      if (metrics.failovers == 0) {
+        const auto timeToFirstByte = static_cast<double>(metrics.timeToFirstByte);
+        statistics.timeToFirstByte = statistics.timeToFirstByte < 0.
+                                       ? timeToFirstByte
+                                       : HOST_TTFB_SMOOTHING_FACTOR * timeToFirstByte
+                                           + (1. - HOST_TTFB_SMOOTHING_FACTOR) * statistics.timeToFirstByte;
+      }
+      statistics.consecutiveFailures = 0;
+    } else if (errorCode == ErrorCode::NetworkError) {
+      statistics.consecutiveFailures++;
+    }
+  }
+
+  void notifyProgress(int const percentage) {
+    progress.percentage = percentage;
+    lastProgressNotification = progressTimer.elapsed();
+    if (onProgress) {
+      onProgress(percentage);
+    }
+  }
+
+  void notifyFinalProgress() {
+    if (progress.bytesTotal < 0) {
+      progress.bytesTotal = progress.bytesReceived;
+    }
+    progress.remainingTime = 0;
+    notifyProgress(100);
+  }
+
+  void resetBlockVerification() {
+    currentBlock.clear();
+    currentBlockIndex = 0;
+    checkedBlockCount = 0;
+    corruptedBlocks.clear();
+    blockMismatch = false;
+    repairedBlock.clear();
+    blockRepairAttempts = 0;
+    repairing = false;
+  }
+
+  qint64 expectedBlockSize(int const index) const {
+    const auto start = index * blockManifest.blockSize;
+    return std::max(qint64{ 0 }, std::min(blockManifest.blockSize, blockManifest.size - start));
+  }
+
+  bool blockIsValid(int const index, const QByteArray& block) const {
+    return index < blockManifest.blockHashes.size() && block.size() == expectedBlockSize(index)
+           && QCryptographicHash::hash(block, QCryptographicHash::Algorithm::Sha256)
+                == blockManifest.blockHashes.at(index);
+  }
+
+  void abortOnBlockMismatch() {
+    blockMismatch = true;
+    if (reply) {
+      reply->abort();
+    }
+  }
+
+  void checkBlock(int const index, const QByteArray& block) {
+    checkedBlockCount++;
+    if (blockIsValid(index, block)) {
+      return;
+    }
+
+    corruptedBlocks.append(index);
+    if (corruptedBlocks.size() >= MIN_CORRUPTED_BLOCKS_FOR_MISMATCH && corruptedBlocks.size() * 4 > checkedBlockCount) {
+      abortOnBlockMismatch();
+    }
+  }
+
+  // Verifies the blocks as soon as they are complete.
+  void verifyReceivedData(const QByteArray& data) {
+    auto offset = 0;
+    while (offset < data.size() && !blockMismatch) {
+      const auto expectedSize = expectedBlockSize(currentBlockIndex);
+      if (expectedSize == 0) {
+        // More data than announced by the manifest.
+        abortOnBlockMismatch();
+        return;
+      }
+
+      const auto length = static_cast<int>(std::min<qint64>(expectedSize - currentBlock.size(), data.size() - offset));
+      currentBlock.append(data.constData() + offset, length);
+      offset += length;
+      if (currentBlock.size() == expectedSize) {
+        checkBlock(currentBlockIndex, currentBlock);
+        currentBlock.clear();
+        currentBlockIndex++;
+      }
+    }
+  }
+
+  // Downloads the corrupted blocks again, one by one, then finishes the download.
+  void repairNextBlock() {
+    repairing = true;
+    if (corruptedBlocks.isEmpty()) {
+      onFileDownloadFinished(commitFile());
+      return;
+    }
+
+    const auto index = corruptedBlocks.first();
+    const auto start = index * blockManifest.blockSize;
+    const auto length = expectedBlockSize(index);
+    auto request = QNetworkRequest(url);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::SameOriginRedirectPolicy);
+    request.setTransferTimeout(timeout);
+    request.setRawHeader("Range", "bytes=" + QByteArray::number(start) + '-' + QByteArray::number(start + length - 1));
+    repairedBlock.clear();
+    metrics.retries++;
+    reply = manager().get(request);
+
+    readyReadConnection = QObject::connect(reply, &QNetworkReply::readyRead, &owner, [this, length]() {
+      repairedBlock.append(reply->readAll());
+      if (repairedBlock.size() > length) {
+        // The server sends more than the block.
+        reply->abort();
+      }
+    });
+
+    finishedConnection = QObject::connect(reply, &QNetworkReply::finished, &owner, [this, index, start]() {
+      disconnectReply();
+      QtDeleteLaterScopedPointer<QNetworkReply> replyRAII(reply);
+
+      if (cancelled) {
+        closeFileStream(true);
+        onFileDownloadFinished(ErrorCode::Cancelled);
+        return;
+      }
+
+      // The server must support Range requests.
+      const auto statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+      if (statusCode == 200) {
+        closeFileStream(true);
+        onFileDownloadFinished(ErrorCode::BlockVerificationFailed);
+        return;
+      }
+      if (reply->error() != QNetworkReply::NoError) {
+        closeFileStream(true);
+        onFileDownloadFinished(ErrorCode::NetworkError);
+        return;
+      }
+
+      if (blockIsValid(index, repairedBlock)) {
+        if (!fileStream->seek(start) || fileStream->write(repairedBlock) != repairedBlock.size()) {
+          closeFileStream(true);
+          onFileDownloadFinished(ErrorCode::NotAllowedToWriteFile);
+          return;
+        }
+        corruptedBlocks.removeFirst();
+        blockRepairAttempts = 0;
+      } else if (++blockRepairAttempts >= MAX_BLOCK_REPAIR_ATTEMPTS) {
+        closeFileStream(true);
+        onFileDownloadFinished(ErrorCode::BlockVerificationFailed);
+        return;
+      }
+
+      repairNextBlock();
+    });
   }
 
   void startFileDownload() {
     isDownloading = true;
+    paused = false;
+    requestOffset = 0;
+    resumedReplyUnchecked = false;
+    resetProgress();
+    resetBlockVerification();
 
     // Check url validity.
     if (url.isEmpty() || !url.isValid()) {
@@ -64,6 +540,15 @@ struct QtDownloader::Impl {
       return;
     }
 
+    // The archive is extracted as it is received, and never written to the disk.
+    // The directory is created only once the archive is extracted.
+    if (extractionOptions.enabled) {
+      if (startExtractor(QDir(localDir).absolutePath())) {
+        sendFileRequest();
+      }
+      return;
+    }
+
     // Create directory if it does not exist.
     QDir dir(localDir);
     if (!dir.exists()) {
@@ -78,6 +563,11 @@ struct QtDownloader::Impl {
     const auto finalFilePath = dir.absolutePath() + '/' + urlFileName;
     const auto partialFilePath = finalFilePath + PARTIAL_DOWNLOAD_SUFFIX;
 
+    if (url.isLocalFile()) {
+      copyLocalFile(url.toLocalFile(), finalFilePath);
+      return;
+    }
+
     // Remove file if it was previously downloaded.
     for (const auto& previousPath : { partialFilePath, finalFilePath }) {
       QFile previousFile{ previousPath };
@@ -104,41 +594,474 @@ struct QtDownloader::Impl {
       return;
     }
 
+    sendFileRequest();
+  }
+
+  void sendFileRequest() {
     auto request = QNetworkRequest(url);
     request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::SameOriginRedirectPolicy);
     request.setTransferTimeout(timeout);
-    reply = manager.get(request);
-    if (onProgress) {
-      onProgress(0);
-      progressConnection = QObject::connect(
-        reply, &QNetworkReply::downloadProgress, &owner, [this](qint64 bytesReceived, qint64 bytesTotal) {
-          if (bytesTotal >= bytesReceived) {
-            onDownloadProgress(bytesReceived, bytesTotal);
-          }
-        });
+    if (requestOffset > 0) {
+      request.setRawHeader("Range", "bytes=" + QByteArray::number(requestOffset) + '-');
+    }
+    reply = manager().get(request);
+    applyBandwidthLimit();
+    connectMetrics();
+    if (onProgress && requestOffset == 0) {
+      notifyProgress(0);
     }
+    progressConnection = QObject::connect(
+      reply, &QNetworkReply::downloadProgress, &owner, [this](qint64 bytesReceived, qint64 bytesTotal) {
+        if (bytesTotal >= bytesReceived) {
+          onDownloadProgress(requestOffset + bytesReceived, bytesTotal > 0 ? requestOffset + bytesTotal : bytesTotal);
+        }
+      });
 
     readyReadConnection = QObject::connect(reply, &QNetworkReply::readyRead, &owner, [this]() {
-      if (reply->bytesAvailable()) {
-        fileStream->write(reply->readAll());
-      }
+      readReceivedData();
     });
 
     finishedConnection = QObject::connect(reply, &QNetworkReply::finished, &owner, [this]() {
+      disconnectReply();
+
+      // Paused: the reply was aborted, and the download continues from the end of the file on resume.
+      if (paused) {
+        QtDeleteLaterScopedPointer<QNetworkReply> replyRAII(reply);
+        return;
+      }
+
+      if (failOver()) {
+        return;
+      }
+
       if (onProgress) {
-        onProgress(100);
+        notifyFinalProgress();
       }
 
-      QObject::disconnect(progressConnection);
-      QObject::disconnect(readyReadConnection);
-      QObject::disconnect(finishedConnection);
+      finishMetrics(ErrorCode::NoError);
+      // The end of the data may still be in the reply's buffer: it is already received, so not throttled.
+      throttleTimer.stop();
+      bandwidthAllowance = std::numeric_limits<qint64>::max();
+      if (extractor) {
+        finishExtraction(handleExtractionReply(reply, cancelled));
+        return;
+      }
+      if (!cancelled && reply->error() == QNetworkReply::NoError) {
+        readFileData();
+      }
       const auto errorCode = handleFileReply(reply, cancelled);
+      if (errorCode == ErrorCode::NoError && !corruptedBlocks.isEmpty()) {
+        repairNextBlock();
+        return;
+      }
       onFileDownloadFinished(errorCode);
     });
   }
 
+  // Limits the transfer rate by reading the reply only within the allowance. The reply's buffer is kept
+  // small so that the network isn't read meanwhile, and the server slows down.
+  void applyBandwidthLimit() {
+    if (!reply) {
+      return;
+    }
+
+    // With tar, the buffer bounds the memory used when tar is slower than the network.
+    const auto readBufferSize = bandwidthLimit > 0
+                                  ? std::max(bandwidthLimit, THROTTLE_MIN_READ_BUFFER_SIZE)
+                                  : extractor ? EXTRACTION_MAX_PENDING_BYTES : qint64{ 0 };
+    reply->setReadBufferSize(extractor ? std::min(readBufferSize, EXTRACTION_MAX_PENDING_BYTES) : readBufferSize);
+    if (bandwidthLimit > 0) {
+      bandwidthAllowance = std::min(bandwidthAllowance, bandwidthLimit * THROTTLE_INTERVAL / 1000);
+      throttleTimer.start();
+    } else {
+      throttleTimer.stop();
+      bandwidthAllowance = std::numeric_limits<qint64>::max();
+    }
+  }
+
+  void consumeBandwidthAllowance(qint64 const bytes) {
+    if (bandwidthLimit > 0) {
+      bandwidthAllowance -= bytes;
+    }
+  }
+
+  void readReceivedData() {
+    if (!reply || paused) {
+      return;
+    }
+
+    if (extractor) {
+      feedExtractor(EXTRACTION_MAX_PENDING_BYTES);
+    } else if (fileStream && !repairing) {
+      readFileData();
+    }
+  }
+
+  // Writes the received data to the file, within the bandwidth allowance.
+  void readFileData() {
+    if (resumedReplyUnchecked) {
+      resumedReplyUnchecked = false;
+      if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 206) {
+        restartFile();
+      }
+    }
+
+    while (reply->bytesAvailable() > 0 && bandwidthAllowance > 0) {
+      const auto data = reply->read(std::min(bandwidthAllowance, READ_CHUNK_SIZE));
+      consumeBandwidthAllowance(data.size());
+      metrics.bytesDecoded += data.size();
+      fileStream->write(data);
+      if (blockManifest.isValid()) {
+        verifyReceivedData(data);
+      }
+    }
+  }
+
+  // The server doesn't support Range requests: the whole file is sent again.
+  void restartFile() {
+    fileStream->resize(0);
+    fileStream->seek(0);
+    requestOffset = 0;
+    metrics.bytesDecoded = 0;
+    resetBlockVerification();
+  }
+
+  // Closes the connection, but keeps the partial file to continue from its end on resume.
+  void pause() {
+    if (!isDownloading || paused || !fileStream || extractor || repairing || !reply) {
+      return;
+    }
+
+    paused = true;
+    throttleTimer.stop();
+    reply->abort();
+  }
+
+  void resume() {
+    if (!paused) {
+      return;
+    }
+
+    paused = false;
+    requestRemainingFile();
+  }
+
+  // Requests the rest of the file, from the end of the partial file.
+  void requestRemainingFile() {
+    requestOffset = fileStream->pos();
+    resumedReplyUnchecked = requestOffset > 0;
+    lastRateSampleTime = progressTimer.elapsed();
+    lastRateSampleBytes = requestOffset;
+    sendFileRequest();
+  }
+
+  // The connection to the current mirror failed: the download continues on the next one.
+  bool failOver() {
+    if (cancelled || blockMismatch || extractor || !fileStream || !reply || reply->error() == QNetworkReply::NoError
+        || remainingMirrorUrls.isEmpty()) {
+      return false;
+    }
+
+    QtDeleteLaterScopedPointer<QNetworkReply> replyRAII(reply);
+    // Keep what was received before the connection failed, unless it is an error page.
+    const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 200 || status == 206) {
+      throttleTimer.stop();
+      bandwidthAllowance = std::numeric_limits<qint64>::max();
+      readFileData();
+    } else {
+      restartFile();
+    }
+
+    url = remainingMirrorUrls.takeFirst();
+    metrics.url = url;
+    metrics.failovers++;
+    requestRemainingFile();
+    return true;
+  }
+
+  // Hard-links the local file next to the destination (or clones or copies it, on another volume), instead of
+  // writing a partial file. The checksum is then verified in place, through the link.
+  void copyLocalFile(const QString& sourcePath, const QString& destinationPath) {
+    fileInfo = QFileInfo(destinationPath);
+    localFileSize = QFileInfo(sourcePath).size();
+    localBytesCopied = std::make_shared<std::atomic<qint64>>(0);
+    metrics.timeToFirstByte = 0;
+    if (onProgress) {
+      notifyProgress(0);
+    }
+    localCopyTimer.start();
+    localFileWatcher.setFuture(QtConcurrent::run([sourcePath, destinationPath, bytesCopied = localBytesCopied]() {
+      return fileutils::linkOrCopyFile(sourcePath, destinationPath, [bytesCopied](qint64 const copied, qint64) {
+        *bytesCopied = copied;
+      });
+    }));
+  }
+
+  // A copy can't be interrupted: a cancelled copy is removed once it is complete.
+  void onLocalFileCopied() {
+    localCopyTimer.stop();
+    const auto copied = localFileWatcher.result();
+    if (cancelled) {
+      if (copied) {
+        QFile::remove(fileInfo.absoluteFilePath());
+      }
+      onFileDownloadFinished(ErrorCode::Cancelled);
+      return;
+    }
+    if (!copied) {
+      onFileDownloadFinished(ErrorCode::FileDoesNotExistOrIsCorrupted);
+      return;
+    }
+
+    fileInfo.refresh();
+    metrics.bytesDecoded = fileInfo.size();
+    onDownloadProgress(fileInfo.size(), fileInfo.size());
+    if (onProgress) {
+      notifyFinalProgress();
+    }
+    finishMetrics(ErrorCode::NoError);
+    onFileDownloadFinished(ErrorCode::NoError);
+  }
+
+  void readLocalData(const QString& filePath) {
+    metrics.timeToFirstByte = 0;
+    if (onProgress) {
+      notifyProgress(0);
+    }
+    localDataWatcher.setFuture(QtConcurrent::run([filePath]() -> std::optional<QByteArray> {
+      QFile file(filePath);
+      if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+      }
+      return file.readAll();
+    }));
+  }
+
+  void onLocalDataRead() {
+    const auto data = localDataWatcher.result();
+    if (cancelled) {
+      onDataDownloadFinished(ErrorCode::Cancelled);
+      return;
+    }
+    if (!data) {
+      onDataDownloadFinished(ErrorCode::FileDoesNotExistOrIsCorrupted);
+      return;
+    }
+
+    downloadedData = *data;
+    metrics.bytesDecoded = downloadedData.size();
+    onDownloadProgress(downloadedData.size(), downloadedData.size());
+    if (onProgress) {
+      notifyFinalProgress();
+    }
+    finishMetrics(ErrorCode::NoError);
+    onDataDownloadFinished(ErrorCode::NoError);
+  }
+
+  // Starts tar, which extracts the archive in a staging directory next to the destination directory.
+  bool startExtractor(const QString& destinationPath) {
+    fileInfo = QFileInfo(destinationPath);
+    extractionStagingPath = destinationPath + EXTRACTION_STAGING_SUFFIX;
+    QDir stagingDir(extractionStagingPath);
+    if (stagingDir.exists() && !stagingDir.removeRecursively()) {
+      onFileDownloadFinished(ErrorCode::CannotRemoveFile);
+      return false;
+    }
+    if (!stagingDir.mkpath(".")) {
+      onFileDownloadFinished(ErrorCode::CannotCreateLocalDir);
+      return false;
+    }
+
+    const auto algorithm = getQtAlgorithm(extractionOptions.checksumType);
+    if (algorithm) {
+      extractionHasher = std::make_unique<StreamHasher>(
+        algorithm.value(), extractionOptions.checksumType == ChecksumType::SHA256_TREE);
+    }
+    extractorFailed = false;
+    extractor.reset(new QProcess);
+    extractor->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    extractor->start(
+      EXTRACTION_PROGRAM, QtArchiveInstallStrategy::streamExtractionArguments(url.fileName(), extractionStagingPath));
+    if (!extractor->waitForStarted()) {
+      discardExtraction();
+      onFileDownloadFinished(ErrorCode::ExtractionFailed);
+      return false;
+    }
+
+    // Resume reading the network when tar has consumed the data.
+    extractorBytesWrittenConnection = QObject::connect(extractor.get(), &QProcess::bytesWritten, &owner, [this]() {
+      feedExtractor(EXTRACTION_MAX_PENDING_BYTES);
+    });
+    // tar stops early if the archive is invalid.
+    extractorFinishedConnection = QObject::connect(extractor.get(),
+      QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), &owner,
+      [this](int const exitCode, QProcess::ExitStatus const exitStatus) {
+        if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+          extractorFailed = true;
+          if (reply) {
+            reply->abort();
+          }
+        }
+      });
+    return true;
+  }
+
+  // Hashes the received data and gives it to tar, while less than maxPendingBytes wait to be written.
+  void feedExtractor(qint64 const maxPendingBytes) {
+    if (!reply || !extractor) {
+      return;
+    }
+
+    while (reply->bytesAvailable() > 0 && extractor->bytesToWrite() < maxPendingBytes && bandwidthAllowance > 0) {
+      const auto data = reply->read(std::min(bandwidthAllowance, READ_CHUNK_SIZE));
+      consumeBandwidthAllowance(data.size());
+      metrics.bytesDecoded += data.size();
+      if (extractionHasher) {
+        extractionHasher->addData(data);
+      }
+      if (blockManifest.isValid()) {
+        // Blocks can't be repaired once given to tar: a corrupted block fails the download.
+        verifyReceivedData(data);
+      }
+      extractor->write(data);
+    }
+  }
+
+  ErrorCode handleExtractionReply(QNetworkReply* reply, bool cancelled) {
+    if (!reply)
+      return ErrorCode::NetworkError;
+
+    QtDeleteLaterScopedPointer<QNetworkReply> replyRAII(reply);
+
+    if (cancelled) {
+      return ErrorCode::Cancelled;
+    }
+
+    if (extractorFailed) {
+      return ErrorCode::ExtractionFailed;
+    }
+
+    // Aborted because the blocks don't match the manifest.
+    if (blockMismatch) {
+      return ErrorCode::BlockVerificationFailed;
+    }
+
+    if (reply->error() != QNetworkReply::NoError) {
+      return ErrorCode::NetworkError;
+    }
+
+    // The end of the data may still be in the reply's buffer.
+    feedExtractor(std::numeric_limits<qint64>::max());
+
+    if (blockManifest.isValid()
+        && (blockMismatch || !corruptedBlocks.isEmpty() || !currentBlock.isEmpty()
+            || currentBlockIndex != blockManifest.blockHashes.size())) {
+      return ErrorCode::BlockVerificationFailed;
+    }
+
+    return ErrorCode::NoError;
+  }
+
+  // Waits for tar to extract the end of the archive, then commits or discards the extracted content.
+  void finishExtraction(ErrorCode const errorCode) {
+    QObject::disconnect(extractorBytesWrittenConnection);
+    QObject::disconnect(extractorFinishedConnection);
+    if (errorCode != ErrorCode::NoError) {
+      discardExtraction();
+      onFileDownloadFinished(errorCode);
+      return;
+    }
+
+    // tar may already have stopped, after the end-of-archive marker.
+    if (extractor->state() == QProcess::NotRunning) {
+      onFileDownloadFinished(
+        commitExtraction(extractor->exitStatus() == QProcess::NormalExit && extractor->exitCode() == 0));
+      return;
+    }
+
+    extractorFinishedConnection = QObject::connect(extractor.get(),
+      QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), &owner,
+      [this](int const exitCode, QProcess::ExitStatus const exitStatus) {
+        QObject::disconnect(extractorFinishedConnection);
+        onFileDownloadFinished(commitExtraction(exitStatus == QProcess::NormalExit && exitCode == 0));
+      });
+    extractor->closeWriteChannel();
+  }
+
+  // Replaces the destination directory with the staging directory, if the archive is valid.
+  // The previous content is moved aside first, and removed only once the new one is in place:
+  // whatever happens, one of them is complete.
+  ErrorCode commitExtraction(bool const extracted) {
+    const auto checksumIsValid = !extractionHasher
+                                 || extractionHasher->result().toHex() == extractionOptions.checksum.toLower().toUtf8();
+    const auto errorCode = cancelled          ? ErrorCode::Cancelled
+                           : !extracted       ? ErrorCode::ExtractionFailed
+                           : !checksumIsValid ? ErrorCode::FileDoesNotExistOrIsCorrupted
+                                              : ErrorCode::NoError;
+    if (errorCode != ErrorCode::NoError) {
+      discardExtraction();
+      return errorCode;
+    }
+
+    const auto destinationPath = fileInfo.absoluteFilePath();
+    const auto previousPath = destinationPath + EXTRACTION_PREVIOUS_SUFFIX;
+    const auto parentPath = fileInfo.absolutePath();
+    QDir parentDir(parentPath);
+    const auto hasPrevious = QFileInfo::exists(destinationPath);
+    if (hasPrevious) {
+      // May remain from an interrupted commit.
+      QDir previousDir(previousPath);
+      if (previousDir.exists() && !previousDir.removeRecursively()) {
+        discardExtraction();
+        return ErrorCode::CannotRemoveFile;
+      }
+      if (!parentDir.rename(destinationPath, previousPath)) {
+        discardExtraction();
+        return ErrorCode::CannotRenameFile;
+      }
+    }
+
+    const auto restorePrevious = [&parentDir, &previousPath, &destinationPath, hasPrevious]() {
+      if (hasPrevious) {
+        parentDir.rename(previousPath, destinationPath);
+      }
+    };
+    if (!parentDir.rename(extractionStagingPath, destinationPath)) {
+      restorePrevious();
+      discardExtraction();
+      return ErrorCode::CannotRenameFile;
+    }
+    if (!fileutils::syncDirectory(parentPath)) {
+      QDir(destinationPath).removeRecursively();
+      restorePrevious();
+      discardExtraction();
+      return ErrorCode::CannotRenameFile;
+    }
+
+    // The new content is in place: failing to remove the previous one doesn't matter.
+    QDir(previousPath).removeRecursively();
+
+    extractor.reset(nullptr);
+    extractionHasher.reset();
+    return ErrorCode::NoError;
+  }
+
+  void discardExtraction() {
+    QObject::disconnect(extractorBytesWrittenConnection);
+    QObject::disconnect(extractorFinishedConnection);
+    if (extractor && extractor->state() != QProcess::NotRunning) {
+      extractor->kill();
+      extractor->waitForFinished();
+    }
+    extractor.reset(nullptr);
+    extractionHasher.reset();
+    QDir(extractionStagingPath).removeRecursively();
+  }
+
   void startDataDownload() {
     isDownloading = true;
+    resetProgress();
     downloadedData.clear();
 
     if (url.isEmpty() || !url.isValid()) {
@@ -146,38 +1069,44 @@ struct QtDownloader::Impl {
       return;
     }
 
+    if (url.isLocalFile()) {
+      readLocalData(url.toLocalFile());
+      return;
+    }
+
     auto request = QNetworkRequest(url);
     request.setTransferTimeout(timeout);
-    reply = manager.get(request);
+    reply = manager().get(request);
 
     const auto error = reply->error();
     if (error != QNetworkReply::NoError) {
       onDataDownloadFinished(ErrorCode::NetworkError);
     }
 
+    connectMetrics();
     if (onProgress) {
-      onProgress(0);
-
-      progressConnection = QObject::connect(
-        reply, &QNetworkReply::downloadProgress, &owner, [this](qint64 bytesReceived, qint64 bytesTotal) {
-          onDownloadProgress(bytesReceived, bytesTotal);
-        });
+      notifyProgress(0);
     }
+    progressConnection = QObject::connect(
+      reply, &QNetworkReply::downloadProgress, &owner, [this](qint64 bytesReceived, qint64 bytesTotal) {
+        onDownloadProgress(bytesReceived, bytesTotal);
+      });
 
     readyReadConnection = QObject::connect(reply, &QNetworkReply::readyRead, &owner, [this]() {
       if (reply->bytesAvailable()) {
-        downloadedData.append(reply->readAll());
+        const auto data = reply->readAll();
+        metrics.bytesDecoded += data.size();
+        downloadedData.append(data);
       }
     });
 
     finishedConnection = QObject::connect(reply, &QNetworkReply::finished, &owner, [this]() {
       if (onProgress) {
-        onProgress(100);
+        notifyFinalProgress();
       }
 
-      QObject::disconnect(progressConnection);
-      QObject::disconnect(readyReadConnection);
-      QObject::disconnect(finishedConnection);
+      disconnectReply();
+      finishMetrics(ErrorCode::NoError);
       const auto errorCode = handleDataReply(reply, cancelled);
       onDataDownloadFinished(errorCode);
     });
@@ -185,7 +1114,14 @@ struct QtDownloader::Impl {
 
   void onFileDownloadFinished(ErrorCode const errorCode) {
     isDownloading = false;
+    paused = false;
+    throttleTimer.stop();
     cancelled = false;
+    metrics.error = errorCode;
+    if (metrics.totalTime < 0) {
+      metrics.totalTime = progressTimer.elapsed();
+    }
+    updateHostStatistics(errorCode);
     if (onFileFinished) {
       downloadedFilepath = errorCode != ErrorCode::NoError ? QString{} : fileInfo.absoluteFilePath();
       onFileFinished(errorCode, downloadedFilepath);
@@ -195,20 +1131,51 @@ struct QtDownloader::Impl {
   void onDataDownloadFinished(ErrorCode const errorCode) {
     isDownloading = false;
     cancelled = false;
+    metrics.error = errorCode;
+    if (metrics.totalTime < 0) {
+      metrics.totalTime = progressTimer.elapsed();
+    }
+    updateHostStatistics(errorCode);
     if (onDataFinished) {
       onDataFinished(errorCode, downloadedData);
     }
   }
 
   void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal) {
+    const auto now = progressTimer.elapsed();
+    progress.bytesReceived = bytesReceived;
+    progress.bytesTotal = bytesTotal > 0 ? bytesTotal : -1;
+
+    // Smoothed transfer rate, sampled at a fixed pace to avoid noise.
+    const auto sampleDuration = now - lastRateSampleTime;
+    if (sampleDuration >= RATE_SAMPLE_INTERVAL) {
+      const auto sampleRate = (bytesReceived - lastRateSampleBytes) * 1000. / sampleDuration;
+      progress.bytesPerSecond = lastRateSampleTime == 0 ? sampleRate
+                                                        : RATE_SMOOTHING_FACTOR * sampleRate
+                                                            + (1. - RATE_SMOOTHING_FACTOR) * progress.bytesPerSecond;
+      lastRateSampleTime = now;
+      lastRateSampleBytes = bytesReceived;
+      metrics.peakBytesPerSecond = std::max(metrics.peakBytesPerSecond, sampleRate);
+    }
+    const auto bytesRemaining = progress.bytesTotal - bytesReceived;
+    progress.remainingTime = progress.bytesTotal > 0 && progress.bytesPerSecond > 0.
+                               ? static_cast<qint64>(bytesRemaining * 1000. / progress.bytesPerSecond)
+                               : -1;
+
     // Arbitrary minimum size above which we consider we are actually downloading a real file (>= 1KB),
     // and not just a reply from the server.
     if (bytesTotal >= 1000) {
       const auto percentage = bytesTotal == 0 ? 0. : (bytesReceived * 100.) / bytesTotal;
       const auto percentageInt = static_cast<int>(std::round(percentage));
-      if (onProgress) {
-        onProgress(percentageInt);
+
+      // Throttle notifications. 100% is notified when the download is finished.
+      const auto tooEarly =
+        lastProgressNotification >= 0 && now - lastProgressNotification < progressPolicy.minInterval;
+      const auto tooSmall = std::abs(percentageInt - progress.percentage) < progressPolicy.minDelta;
+      if (tooEarly || tooSmall || percentageInt >= 100) {
+        return;
       }
+      notifyProgress(percentageInt);
     }
   }
 
@@ -221,48 +1188,71 @@ struct QtDownloader::Impl {
 
     QtDeleteLaterScopedPointer<QNetworkReply> replyRAII(reply);
 
-    const auto closeFilestream = [this, reply](bool const removeFile) {
-      isDownloading = false;
-      if (removeFile) {
-        fileStream->remove();
-      }
-      fileStream.reset(nullptr);
-    };
-
     // Cancelled by user.
     if (cancelled) {
-      closeFilestream(true);
+      closeFileStream(true);
       return ErrorCode::Cancelled;
     }
 
+    // Aborted because the blocks don't match the manifest.
+    if (blockMismatch) {
+      closeFileStream(true);
+      return ErrorCode::BlockVerificationFailed;
+    }
+
     // Network error.
     if (reply->error() != QNetworkReply::NoError) {
-      closeFilestream(true);
+      closeFileStream(true);
       return ErrorCode::NetworkError;
     }
 
     // IO error.
     if (!fileInfo.exists()) {
-      closeFilestream(true);
+      closeFileStream(true);
       return ErrorCode::FileDoesNotExistOrIsCorrupted;
     }
 
     // Filename should end with a certain suffix as we are still writing to disk.
     if (!fileInfo.fileName().endsWith(PARTIAL_DOWNLOAD_SUFFIX)) {
-      closeFilestream(true);
+      closeFileStream(true);
       return ErrorCode::FileDoesNotEndWithSuffix;
     }
 
-    // Rename file as it is fully downloaded
+    // The file must have the size announced by the manifest (a partial block means it is truncated).
+    if (blockManifest.isValid()
+        && (!currentBlock.isEmpty() || currentBlockIndex != blockManifest.blockHashes.size())) {
+      closeFileStream(true);
+      return ErrorCode::BlockVerificationFailed;
+    }
+
+    // Corrupted blocks are downloaded again before the file is ready.
+    if (!corruptedBlocks.isEmpty()) {
+      return ErrorCode::NoError;
+    }
+
+    return commitFile();
+  }
+
+  void closeFileStream(bool const removeFile) {
+    isDownloading = false;
+    if (removeFile) {
+      fileStream->remove();
+    }
+    fileStream.reset(nullptr);
+  }
+
+  // Renames the file as it is fully downloaded. The content is synced to the disk first, so that
+  // a crash or a power loss can't leave a truncated file with the final name.
+  ErrorCode commitFile() {
     auto actualFileName = fileInfo.absoluteFilePath().chopped(PARTIAL_DOWNLOAD_SUFFIX_LENGTH);
     fileInfo.setFile(actualFileName);
-    if (!fileStream->rename(actualFileName)) {
-      closeFilestream(true);
+    if (!fileutils::renameDurably(*fileStream, actualFileName)) {
+      closeFileStream(true);
       return ErrorCode::CannotRenameFile;
     }
 
     // File is ready.
-    closeFilestream(false);
+    closeFileStream(false);
     return ErrorCode::NoError;
   }
 
@@ -291,11 +1281,146 @@ struct QtDownloader::Impl {
       case ChecksumType::SHA1:
         result = QCryptographicHash::Algorithm::Sha1;
         break;
+      case ChecksumType::SHA256:
+      case ChecksumType::SHA256_TREE:
+        result = QCryptographicHash::Algorithm::Sha256;
+        break;
       default:
         break;
     }
     return result;
   }
+
+  static void adviseSequentialRead(QFile& file, qint64 const offset) {
+#if defined(Q_OS_LINUX)
+    ::posix_fadvise(file.handle(), offset, 0, POSIX_FADV_SEQUENTIAL);
+#else
+    Q_UNUSED(file);
+    Q_UNUSED(offset);
+#endif
+  }
+
+  using DataConsumer = std::function<void(const char* data, qint64 length)>;
+
+  // Gives the whole file content to the consumer, mapping it window by window, or reading it
+  // by blocks of readBufferSize if it can't be mapped (e.g. some network file systems).
+  // Pieces are always multiples of readBufferSize (and of the window size), except the last one.
+  static bool readFile(QFile& file, qint64 const readBufferSize, const DataConsumer& consume,
+    const ChecksumProgressCallback& onProgress, const ChecksumCancellationCallback& isCancelled) {
+    const auto size = file.size();
+    auto processed = qint64{ 0 };
+    auto lastNotified = qint64{ 0 };
+    QElapsedTimer timer;
+    timer.start();
+
+    const auto notifyProgress = [&]() {
+      if (onProgress) {
+        const auto elapsed = timer.nsecsElapsed();
+        const auto bytesPerSecond = elapsed > 0 ? processed * 1e9 / elapsed : 0.;
+        onProgress(processed, size, bytesPerSecond);
+      }
+      lastNotified = processed;
+    };
+    const auto consumeAndNotify = [&](const char* data, qint64 const length) {
+      consume(data, length);
+      processed += length;
+      if (processed - lastNotified >= CHECKSUM_PROGRESS_INTERVAL) {
+        notifyProgress();
+      }
+    };
+    const auto cancelled = [&isCancelled]() {
+      return isCancelled && isCancelled();
+    };
+
+    while (processed < size) {
+      if (cancelled()) {
+        return false;
+      }
+      const auto length = std::min(size - processed, CHECKSUM_MAP_WINDOW_SIZE);
+      auto* data = file.map(processed, length);
+      if (!data) {
+        break;
+      }
+      consumeAndNotify(reinterpret_cast<const char*>(data), length);
+      file.unmap(data);
+    }
+
+    if (processed < size) {
+      if (!file.seek(processed)) {
+        return false;
+      }
+      adviseSequentialRead(file, processed);
+      QByteArray buffer(static_cast<int>(readBufferSize), Qt::Uninitialized);
+      while (processed < size) {
+        if (cancelled()) {
+          return false;
+        }
+        // Fill the whole buffer, so that pieces keep their alignment.
+        const auto expected = std::min(size - processed, readBufferSize);
+        auto filled = qint64{ 0 };
+        while (filled < expected) {
+          const auto read = file.read(buffer.data() + filled, expected - filled);
+          if (read <= 0) {
+            return false;
+          }
+          filled += read;
+        }
+        consumeAndNotify(buffer.constData(), filled);
+      }
+    }
+
+    notifyProgress();
+    return true;
+  }
+
+  static bool hashFile(QFile& file, QCryptographicHash& hash, const ChecksumProgressCallback& onProgress,
+    const ChecksumCancellationCallback& isCancelled) {
+    return readFile(
+      file, CHECKSUM_READ_BUFFER_SIZE,
+      [&hash](const char* data, qint64 length) {
+        while (length > 0) {
+          const auto chunkLength = std::min(length, CHECKSUM_CHUNK_SIZE);
+          hash.addData(data, static_cast<int>(chunkLength));
+          data += chunkLength;
+          length -= chunkLength;
+        }
+      },
+      onProgress, isCancelled);
+  }
+
+  static QByteArray hashTreeBlock(const char* data, qint64 const length) {
+    return QCryptographicHash::hash(
+      QByteArray::fromRawData(data, static_cast<int>(length)), QCryptographicHash::Algorithm::Sha256);
+  }
+
+  // Tree hash: SHA-256 of the concatenated SHA-256 digests of each block of TreeHashBlockSize bytes.
+  // Blocks are hashed in parallel with the global thread pool.
+  static bool hashFileAsTree(QFile& file, QByteArray& rootHash, const ChecksumProgressCallback& onProgress,
+    const ChecksumCancellationCallback& isCancelled) {
+    QCryptographicHash root(QCryptographicHash::Algorithm::Sha256);
+    const auto threadCount = std::max(1, QThreadPool::globalInstance()->maxThreadCount());
+    const auto readBufferSize = threadCount * TreeHashBlockSize;
+
+    const auto success = readFile(
+      file, readBufferSize,
+      [&root](const char* data, qint64 const length) {
+        QVector<QFuture<QByteArray>> futures;
+        futures.reserve(static_cast<int>((length + TreeHashBlockSize - 1) / TreeHashBlockSize));
+        for (auto offset = qint64{ 0 }; offset < length; offset += TreeHashBlockSize) {
+          const auto blockLength = std::min(TreeHashBlockSize, length - offset);
+          futures.append(QtConcurrent::run(&Impl::hashTreeBlock, data + offset, blockLength));
+        }
+        for (auto& future : futures) {
+          root.addData(future.result());
+        }
+      },
+      onProgress, isCancelled);
+
+    if (success) {
+      rootHash = root.result();
+    }
+    return success;
+  }
 };
 
 QtDownloader::QtDownloader(QObject* parent)
@@ -304,8 +1429,8 @@ QtDownloader::QtDownloader(QObject* parent)
 
 QtDownloader::~QtDownloader() = default;
 
-void QtDownloader::downloadFile(const QUrl& url, const QString& localDir, const FileFinishedCallback&& onFinished,
-  const ProgressCallback&& onProgress, const int timeout) {
+void QtDownloader::downloadFile(const QUrl& url, const QString& localDir, FileFinishedCallback onFinished,
+  ProgressCallback onProgress, const int timeout) {
   if (_impl->isDownloading) {
     if (onFinished) {
       onFinished(ErrorCode::AlreadyDownloading, {});
@@ -314,10 +1439,12 @@ void QtDownloader::downloadFile(const QUrl& url, const QString& localDir, const
   }
 
   _impl->url = url;
+  _impl->remainingMirrorUrls = std::exchange(_impl->nextMirrorUrls, {});
+  _impl->blockManifest = std::exchange(_impl->nextBlockManifest, {});
   _impl->localDir = localDir;
-  _impl->onFileFinished = onFinished;
+  _impl->onFileFinished = std::move(onFinished);
   _impl->onDataFinished = nullptr;
-  _impl->onProgress = onProgress;
+  _impl->onProgress = std::move(onProgress);
   _impl->timeout = timeout;
   _impl->reply.clear();
   _impl->cancelled = false;
@@ -326,7 +1453,7 @@ void QtDownloader::downloadFile(const QUrl& url, const QString& localDir, const
 }
 
 void QtDownloader::downloadData(
-  const QUrl& url, const DataFinishedCallback&& onFinished, const ProgressCallback&& onProgress, const int timeout) {
+  const QUrl& url, DataFinishedCallback onFinished, ProgressCallback onProgress, const int timeout) {
   if (_impl->isDownloading) {
     if (onFinished) {
       onFinished(ErrorCode::AlreadyDownloading, {});
@@ -337,8 +1464,8 @@ void QtDownloader::downloadData(
   _impl->url = url;
   _impl->localDir.clear();
   _impl->onFileFinished = nullptr;
-  _impl->onDataFinished = onFinished;
-  _impl->onProgress = onProgress;
+  _impl->onDataFinished = std::move(onFinished);
+  _impl->onProgress = std::move(onProgress);
   _impl->timeout = timeout;
   _impl->reply.clear();
   _impl->cancelled = false;
@@ -355,6 +1482,17 @@ void QtDownloader::cancel() {
       // Finished signal will be emitted, and the reply will be deleted at this moment.
       _impl->reply->abort();
     }
+
+    if (_impl->extractor) {
+      // tar may be extracting the end of the archive: its finished signal will be emitted.
+      _impl->extractor->kill();
+    }
+
+    if (_impl->paused) {
+      // No reply to abort.
+      _impl->closeFileStream(true);
+      _impl->onFileDownloadFinished(ErrorCode::Cancelled);
+    }
   }
 }
 
@@ -362,8 +1500,139 @@ bool QtDownloader::isDownloading() const {
   return _impl->isDownloading;
 }
 
+void QtDownloader::pause() {
+  _impl->pause();
+}
+
+void QtDownloader::resume() {
+  _impl->resume();
+}
+
+bool QtDownloader::isPaused() const {
+  return _impl->paused;
+}
+
+const QVector<QUrl>& QtDownloader::mirrorUrls() const {
+  return _impl->nextMirrorUrls;
+}
+
+void QtDownloader::setMirrorUrls(const QVector<QUrl>& urls) {
+  _impl->nextMirrorUrls = urls;
+}
+
+qint64 QtDownloader::bandwidthLimit() const {
+  return _impl->bandwidthLimit;
+}
+
+void QtDownloader::setBandwidthLimit(qint64 const bytesPerSecond) {
+  _impl->bandwidthLimit = std::max(qint64{ 0 }, bytesPerSecond);
+  if (_impl->isDownloading && !_impl->paused) {
+    _impl->applyBandwidthLimit();
+    _impl->readReceivedData();
+  }
+}
+
+QNetworkAccessManager* QtDownloader::networkAccessManager() const {
+  return _impl->sharedManager;
+}
+
+void QtDownloader::setNetworkAccessManager(QNetworkAccessManager* manager) {
+  _impl->sharedManager = manager;
+}
+
+const QtDownloader::ProgressPolicy& QtDownloader::progressPolicy() const {
+  return _impl->progressPolicy;
+}
+
+void QtDownloader::setProgressPolicy(const ProgressPolicy& policy) {
+  _impl->progressPolicy = policy;
+}
+
+const QtDownloader::TimeoutPolicy& QtDownloader::timeoutPolicy() const {
+  return _impl->timeoutPolicy;
+}
+
+void QtDownloader::setTimeoutPolicy(const TimeoutPolicy& policy) {
+  _impl->timeoutPolicy = policy;
+}
+
+const std::shared_ptr<QtDownloader::HostStatisticsMap>& QtDownloader::hostStatistics() const {
+  return _impl->hostStatistics;
+}
+
+void QtDownloader::setHostStatistics(const std::shared_ptr<HostStatisticsMap>& statistics) {
+  _impl->hostStatistics = statistics ? statistics : std::make_shared<HostStatisticsMap>();
+}
+
+const QtDownloader::Progress& QtDownloader::progress() const {
+  return _impl->progress;
+}
+
+const QtDownloader::TransferMetrics& QtDownloader::transferMetrics() const {
+  return _impl->metrics;
+}
+
+const QtDownloader::BlockManifest& QtDownloader::blockManifest() const {
+  return _impl->nextBlockManifest;
+}
+
+void QtDownloader::setBlockManifest(const BlockManifest& manifest) {
+  _impl->nextBlockManifest = manifest;
+}
+
+const QtDownloader::ExtractionOptions& QtDownloader::extractionOptions() const {
+  return _impl->extractionOptions;
+}
+
+void QtDownloader::setExtractionOptions(const ExtractionOptions& options) {
+  _impl->extractionOptions = options;
+}
+
+bool QtDownloader::BlockManifest::isValid() const {
+  if (size <= 0 || blockSize <= 0) {
+    return false;
+  }
+
+  const auto blockCount = (size + blockSize - 1) / blockSize;
+  if (blockHashes.size() != blockCount) {
+    return false;
+  }
+
+  const auto hashLength = QCryptographicHash::hashLength(QCryptographicHash::Algorithm::Sha256);
+  return std::all_of(blockHashes.cbegin(), blockHashes.cend(), [hashLength](const QByteArray& hash) {
+    return hash.size() == hashLength;
+  });
+}
+
+QByteArray QtDownloader::BlockManifest::rootHash() const {
+  QCryptographicHash root(QCryptographicHash::Algorithm::Sha256);
+  for (const auto& hash : blockHashes) {
+    root.addData(hash);
+  }
+  return root.result();
+}
+
+QtDownloader::BlockManifest QtDownloader::BlockManifest::fromJSON(const QByteArray& data) {
+  BlockManifest result;
+  const auto jsonDocument = QJsonDocument::fromJson(data);
+  if (!jsonDocument.isObject()) {
+    return result;
+  }
+
+  const auto jsonObject = jsonDocument.object();
+  result.size = static_cast<qint64>(jsonObject[BLOCK_MANIFEST_TAG_SIZE].toDouble(-1));
+  result.blockSize = static_cast<qint64>(jsonObject[BLOCK_MANIFEST_TAG_BLOCK_SIZE].toDouble(TreeHashBlockSize));
+  const auto blocks = jsonObject[BLOCK_MANIFEST_TAG_BLOCKS].toArray();
+  result.blockHashes.reserve(blocks.size());
+  for (const auto& block : blocks) {
+    result.blockHashes.append(QByteArray::fromHex(block.toString().toUtf8()));
+  }
+  return result;
+}
+
 bool QtDownloader::verifyFileChecksum(const QString& filePath, const QString& checksumStr,
-  ChecksumType const checksumType, InvalidChecksumBehavior const behavior) {
+  ChecksumType const checksumType, InvalidChecksumBehavior const behavior,
+  const ChecksumProgressCallback& onProgress, const ChecksumCancellationCallback& isCancelled) {
   if (checksumType == ChecksumType::NoChecksum) {
     return true;
   }
@@ -380,16 +1649,24 @@ bool QtDownloader::verifyFileChecksum(const QString& filePath, const QString& ch
   auto result = false;
   QFile file(filePath);
   if (file.open(QFile::ReadOnly)) {
-    QCryptographicHash hash(qtAlgorithm.value());
-    if (hash.addData(&file)) {
-      const auto fileHash = hash.result().toHex();
-      const auto checksum = checksumStr.toLower().toUtf8();
-      result = checksum == fileHash;
+    const auto checksum = checksumStr.toLower().toUtf8();
+    if (checksumType == ChecksumType::SHA256_TREE) {
+      QByteArray rootHash;
+      if (Impl::hashFileAsTree(file, rootHash, onProgress, isCancelled)) {
+        result = checksum == rootHash.toHex();
+      }
+    } else {
+      QCryptographicHash hash(qtAlgorithm.value());
+      if (Impl::hashFile(file, hash, onProgress, isCancelled)) {
+        result = checksum == hash.result().toHex();
+      }
     }
   }
   file.close();
 
-  if (!result && behavior == InvalidChecksumBehavior::RemoveFile) {
+  // A cancelled verification doesn't tell anything about the file.
+  const auto cancelled = isCancelled && isCancelled();
+  if (!result && !cancelled && behavior == InvalidChecksumBehavior::RemoveFile) {
     file.remove();
   }
 
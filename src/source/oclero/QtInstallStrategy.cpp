@@ -0,0 +1,240 @@
+#include <oclero/QtInstallStrategy.hpp>
+
+#include <oclero/FileUtils.hpp>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+
+#include <cstdio>
+
+namespace oclero {
+namespace {
+constexpr auto TAR_PROGRAM = "tar";
+constexpr auto TAR_STANDARD_INPUT = "-";
+constexpr auto STAGING_SUFFIX = ".staging";
+constexpr auto LINK_TEMPORARY_SUFFIX = ".tmp";
+// "<version>" or "<version>-<n>", as created by QtArchiveInstallStrategy.
+constexpr auto VERSION_DIR_PATTERN = R"(^\d+(\.\d+)*(-\d+)?$)";
+constexpr auto APPIMAGE_ENVIRONMENT_VARIABLE = "APPIMAGE";
+// No timeout: large archives may take a while to extract.
+constexpr int TAR_TIMEOUT = -1;
+
+QStringList tarArguments(const QString& archiveName, const QString& source, const QString& destinationDir) {
+  const auto fileName = QFileInfo(archiveName).fileName().toLower();
+  QStringList arguments{ "-x" };
+  if (fileName.endsWith(".tar.gz") || fileName.endsWith(".tgz")) {
+    arguments << "-z";
+  } else if (fileName.endsWith(".tar.zst") || fileName.endsWith(".tzst")) {
+    arguments << "--zstd";
+  }
+  arguments << "-f" << source << "-C" << destinationDir;
+  return arguments;
+}
+
+// The installer may be a hard link to a local source or to the shared cache: it gets its own copy first.
+bool makeExecutable(const QString& filePath) {
+  if (!fileutils::unshareFile(filePath)) {
+    return false;
+  }
+  QFile file(filePath);
+  return file.setPermissions(
+    file.permissions() | QFileDevice::ExeOwner | QFileDevice::ExeUser | QFileDevice::ExeGroup | QFileDevice::ExeOther);
+}
+} // namespace
+
+#pragma region QtExecuteFileInstallStrategy
+
+QtInstallStrategy::Result QtExecuteFileInstallStrategy::install(
+  const Context& context, const ProgressCallback& onProgress) {
+  Q_UNUSED(onProgress);
+  auto success = false;
+#if defined(Q_OS_WIN)
+  success = QProcess::startDetached(context.installerPath, {});
+#elif defined(Q_OS_MAC)
+  success = QProcess::startDetached("open", { context.installerPath });
+#else
+  success = makeExecutable(context.installerPath) && QProcess::startDetached(context.installerPath, {});
+#endif
+  return success ? Result::QuitApplication : Result::Failure;
+}
+
+#pragma endregion
+
+#pragma region QtMoveFileInstallStrategy
+
+QtMoveFileInstallStrategy::QtMoveFileInstallStrategy(const QString& destinationDir)
+  : _destinationDir(destinationDir) {}
+
+QtInstallStrategy::Result QtMoveFileInstallStrategy::install(
+  const Context& context, const ProgressCallback& onProgress) {
+  if (_destinationDir.isEmpty()) {
+    return Result::Failure;
+  }
+
+  // The moved file belongs to the user: it must not share its content with a local source or the shared cache.
+  if (!fileutils::unshareFile(context.installerPath)) {
+    return Result::DiskError;
+  }
+
+  const auto destinationPath = _destinationDir + '/' + QFileInfo(context.installerPath).fileName();
+  const auto method = fileutils::moveFile(
+    context.installerPath, destinationPath, [&onProgress](qint64 const bytesCopied, qint64 const bytesTotal) {
+      if (onProgress) {
+        onProgress(bytesTotal > 0 ? static_cast<int>(bytesCopied * 100 / bytesTotal) : 100);
+      }
+    });
+  return method ? Result::Success : Result::DiskError;
+}
+
+#pragma endregion
+
+#pragma region QtAppImageInstallStrategy
+
+QtAppImageInstallStrategy::QtAppImageInstallStrategy(const QString& appImagePath)
+  : _appImagePath(appImagePath) {}
+
+QtInstallStrategy::Result QtAppImageInstallStrategy::install(
+  const Context& context, const ProgressCallback& onProgress) {
+  const auto appImagePath =
+    _appImagePath.isEmpty() ? qEnvironmentVariable(APPIMAGE_ENVIRONMENT_VARIABLE) : _appImagePath;
+  if (appImagePath.isEmpty()) {
+    return Result::Failure;
+  }
+  if (!makeExecutable(context.installerPath)) {
+    return Result::DiskError;
+  }
+
+  // The running AppImage keeps its inode: replacing the file doesn't affect it.
+  const auto method = fileutils::moveFile(
+    context.installerPath, appImagePath, [&onProgress](qint64 const bytesCopied, qint64 const bytesTotal) {
+      if (onProgress) {
+        onProgress(bytesTotal > 0 ? static_cast<int>(bytesCopied * 100 / bytesTotal) : 100);
+      }
+    });
+  if (!method) {
+    return Result::DiskError;
+  }
+
+  // A copy doesn't keep the permissions.
+  return makeExecutable(appImagePath) ? Result::Success : Result::DiskError;
+}
+
+#pragma endregion
+
+#pragma region QtArchiveInstallStrategy
+
+QtArchiveInstallStrategy::QtArchiveInstallStrategy(const QString& installDir, const QString& linkName)
+  : _installDir(installDir)
+  , _linkName(linkName) {}
+
+QtInstallStrategy::Result QtArchiveInstallStrategy::install(
+  const Context& context, const ProgressCallback& onProgress) {
+  if (_installDir.isEmpty() || _linkName.isEmpty() || context.version.isNull()) {
+    return Result::Failure;
+  }
+
+  QDir const installDir(_installDir);
+  if (!installDir.exists() && !installDir.mkpath(".")) {
+    return Result::DiskError;
+  }
+
+  // An existing version directory may be the one the link points to: never modify it.
+  auto versionName = context.version.toString();
+  for (auto index = 1; QFileInfo::exists(installDir.absoluteFilePath(versionName)); ++index) {
+    versionName = context.version.toString() + '-' + QString::number(index);
+  }
+
+  // Extract in a staging directory, so that a partial extraction is never used.
+  const auto stagingPath = installDir.absoluteFilePath(versionName + STAGING_SUFFIX);
+  const auto versionPath = installDir.absoluteFilePath(versionName);
+  QDir stagingDir(stagingPath);
+  if (stagingDir.exists() && !stagingDir.removeRecursively()) {
+    return Result::DiskError;
+  }
+  if (!installDir.mkpath(stagingPath)) {
+    return Result::DiskError;
+  }
+
+  if (onProgress) {
+    onProgress(0);
+  }
+  QProcess tar;
+  tar.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+  tar.start(TAR_PROGRAM, extractionArguments(context.installerPath, stagingPath));
+  const auto extracted =
+    tar.waitForFinished(TAR_TIMEOUT) && tar.exitStatus() == QProcess::NormalExit && tar.exitCode() == 0;
+  if (!extracted) {
+    stagingDir.removeRecursively();
+    return Result::Failure;
+  }
+
+  // Commit the staging directory.
+  if (!installDir.rename(stagingPath, versionPath)) {
+    stagingDir.removeRecursively();
+    return Result::DiskError;
+  }
+  if (!fileutils::syncDirectory(installDir.absolutePath())) {
+    QDir(versionPath).removeRecursively();
+    return Result::DiskError;
+  }
+
+  const auto previousName = QFileInfo(QFileInfo(installDir.absoluteFilePath(_linkName)).symLinkTarget()).fileName();
+  if (!swapLink(installDir.absolutePath(), _linkName, versionName)) {
+    QDir(versionPath).removeRecursively();
+    return Result::DiskError;
+  }
+
+  // Keep the previous version, to be able to go back to it. Failing to remove the others doesn't matter.
+  removeVersions(installDir.absolutePath(), { versionName, previousName });
+
+  if (onProgress) {
+    onProgress(100);
+  }
+  return Result::Success;
+}
+
+QStringList QtArchiveInstallStrategy::extractionArguments(const QString& archivePath, const QString& destinationDir) {
+  return tarArguments(archivePath, archivePath, destinationDir);
+}
+
+QStringList QtArchiveInstallStrategy::streamExtractionArguments(
+  const QString& archiveName, const QString& destinationDir) {
+  return tarArguments(archiveName, TAR_STANDARD_INPUT, destinationDir);
+}
+
+bool QtArchiveInstallStrategy::swapLink(const QString& installDir, const QString& linkName, const QString& targetName) {
+  // Create the new link next to the current one, then rename it: the link always exists and is valid.
+  const auto linkPath = installDir + '/' + linkName;
+  const auto temporaryLinkPath = linkPath + LINK_TEMPORARY_SUFFIX;
+  QFile::remove(temporaryLinkPath);
+  // Relative target, so that the installation directory can be moved.
+  if (!QFile::link(targetName, temporaryLinkPath)) {
+    return false;
+  }
+  if (std::rename(QFile::encodeName(temporaryLinkPath).constData(), QFile::encodeName(linkPath).constData()) != 0) {
+    QFile::remove(temporaryLinkPath);
+    return false;
+  }
+  return fileutils::syncDirectory(installDir);
+}
+
+bool QtArchiveInstallStrategy::removeVersions(const QString& installDir, const QStringList& keptNames) {
+  static const QRegularExpression versionDirRegex(VERSION_DIR_PATTERN);
+  auto success = true;
+  // Symbolic links are skipped: only the directories they point to are removed.
+  const auto entries = QDir(installDir).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+  for (const auto& entry : entries) {
+    const auto name = entry.fileName();
+    if (keptNames.contains(name) || !versionDirRegex.match(name).hasMatch()) {
+      continue;
+    }
+    success = QDir(entry.absoluteFilePath()).removeRecursively() && success;
+  }
+  return success;
+}
+
+#pragma endregion
+} // namespace oclero
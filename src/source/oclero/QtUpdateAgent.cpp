@@ -0,0 +1,203 @@
+#include <oclero/QtUpdateAgent.hpp>
+
+#include <oclero/QtEnumUtils.hpp>
+#include <oclero/QtUpdater.hpp>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QList>
+#include <QMap>
+#include <QNetworkAccessManager>
+
+#include <algorithm>
+#include <vector>
+
+namespace oclero {
+namespace {
+// Installers are shared by the targets in this subdirectory of the storage directory, by checksum.
+constexpr auto SHARED_CACHE_DIR_NAME = "shared";
+} // namespace
+
+struct QtUpdateAgent::Impl {
+  // Updater of the targets with the same server and current version.
+  struct Source {
+    QString key;
+    QStringList targetIds;
+    std::unique_ptr<QtUpdater> updater;
+  };
+
+  QtUpdateAgent& owner;
+  QString storageDir;
+  QNetworkAccessManager networkAccessManager;
+  std::vector<std::unique_ptr<Source>> sources;
+  QMap<QString, Source*> targets;
+  // Sources with a background download, by order of arrival.
+  QList<Source*> downloadQueue;
+  int maxConcurrentDownloads{ DefaultMaxConcurrentDownloads };
+  qint64 bandwidthLimit{ 0 };
+
+  Impl(QtUpdateAgent& o, const QString& dir)
+    : owner(o)
+    , storageDir(dir) {}
+
+  Source& sourceFor(const Target& target) {
+    const auto key = QString::fromLatin1(
+      QCryptographicHash::hash((target.serverUrl + '\n' + target.currentVersion).toUtf8(), QCryptographicHash::Sha1)
+        .toHex()
+        .left(16));
+    const auto it = std::find_if(sources.begin(), sources.end(), [&key](const auto& source) {
+      return source->key == key;
+    });
+    if (it != sources.end()) {
+      return **it;
+    }
+
+    // Each source has its own settings and its own directory.
+    const auto settingsParameters = QtUpdater::SettingsParameters{ QSettings::NativeFormat, QSettings::UserScope,
+      QCoreApplication::organizationName(), QCoreApplication::applicationName() + '-' + key };
+    auto source = std::make_unique<Source>();
+    source->key = key;
+    source->updater = std::make_unique<QtUpdater>(target.serverUrl, settingsParameters);
+
+    const QDir dir(storageDir);
+    auto& updater = *source->updater;
+    updater.setCurrentVersion(target.currentVersion);
+    updater.setTemporaryDirectoryPath(dir.absoluteFilePath(key));
+    updater.setSharedCacheDirectory(dir.absoluteFilePath(SHARED_CACHE_DIR_NAME));
+    updater.setNetworkAccessManager(&networkAccessManager);
+    // Downloads start paused: the scheduler resumes them.
+    updater.setPrefetchPaused(true);
+    updater.setPrefetchEnabled(true);
+
+    auto* sourcePtr = source.get();
+    QObject::connect(&updater, &QtUpdater::prefetchingChanged, &owner, [this, sourcePtr]() {
+      downloadQueue.removeAll(sourcePtr);
+      if (sourcePtr->updater->prefetching()) {
+        downloadQueue.append(sourcePtr);
+      }
+      schedule();
+    });
+    for (const auto signal : { &QtUpdater::stateChanged, &QtUpdater::updateAvailabilityChanged,
+           &QtUpdater::changelogAvailableChanged, &QtUpdater::installerAvailableChanged,
+           &QtUpdater::prefetchingChanged, &QtUpdater::prefetchPausedChanged }) {
+      QObject::connect(&updater, signal, &owner, [this, sourcePtr]() {
+        notifySource(*sourcePtr);
+      });
+    }
+
+    sources.push_back(std::move(source));
+    return *sourcePtr;
+  }
+
+  void notifySource(const Source& source) {
+    for (const auto& id : source.targetIds) {
+      emit owner.targetStatusChanged(id);
+    }
+  }
+
+  // The first downloads of the queue run, and share the bandwidth. The others are paused.
+  void schedule() {
+    const auto activeCount = std::min(maxConcurrentDownloads, static_cast<int>(downloadQueue.size()));
+    const auto bandwidthPerDownload =
+      bandwidthLimit > 0 && activeCount > 0 ? std::max(qint64{ 1 }, bandwidthLimit / activeCount) : qint64{ 0 };
+    for (auto i = 0; i < downloadQueue.size(); ++i) {
+      auto& updater = *downloadQueue[i]->updater;
+      if (i < activeCount) {
+        updater.setPrefetchBandwidthLimit(bandwidthPerDownload);
+        updater.setPrefetchPaused(false);
+      } else {
+        updater.setPrefetchPaused(true);
+      }
+    }
+  }
+};
+
+#pragma region Ctor / Dtor
+
+QtUpdateAgent::QtUpdateAgent(const QString& storageDir, QObject* parent)
+  : QObject(parent)
+  , _impl(new Impl(*this, storageDir)) {}
+
+QtUpdateAgent::~QtUpdateAgent() = default;
+
+#pragma endregion
+
+#pragma region Targets
+
+QString QtUpdateAgent::storageDir() const {
+  return _impl->storageDir;
+}
+
+bool QtUpdateAgent::addTarget(const Target& target) {
+  if (target.id.isEmpty() || _impl->targets.contains(target.id)) {
+    return false;
+  }
+
+  auto& source = _impl->sourceFor(target);
+  source.targetIds.append(target.id);
+  _impl->targets.insert(target.id, &source);
+  return true;
+}
+
+QStringList QtUpdateAgent::targetIds() const {
+  return _impl->targets.keys();
+}
+
+QJsonObject QtUpdateAgent::targetStatus(const QString& id) const {
+  const auto* source = _impl->targets.value(id, nullptr);
+  if (!source) {
+    return {};
+  }
+
+  const auto& updater = *source->updater;
+  return QJsonObject{
+    { "id", id },
+    { "state", enumToString(updater.state()) },
+    { "updateAvailability", enumToString(updater.updateAvailability()) },
+    { "currentVersion", updater.currentVersion() },
+    { "latestVersion", updater.latestVersion() },
+    { "latestVersionDate", updater.latestVersionDate().toString(Qt::ISODate) },
+    { "changelogAvailable", updater.changelogAvailable() },
+    { "installerAvailable", updater.installerAvailable() },
+    { "downloading", updater.prefetching() },
+    // Waiting for another download to finish.
+    { "paused", updater.prefetching() && updater.prefetchPaused() },
+    { "directory", updater.temporaryDirectoryPath() },
+  };
+}
+
+#pragma endregion
+
+#pragma region Scheduling
+
+int QtUpdateAgent::maxConcurrentDownloads() const {
+  return _impl->maxConcurrentDownloads;
+}
+
+void QtUpdateAgent::setMaxConcurrentDownloads(int count) {
+  _impl->maxConcurrentDownloads = std::max(1, count);
+  _impl->schedule();
+}
+
+qint64 QtUpdateAgent::bandwidthLimit() const {
+  return _impl->bandwidthLimit;
+}
+
+void QtUpdateAgent::setBandwidthLimit(qint64 bytesPerSecond) {
+  _impl->bandwidthLimit = std::max(qint64{ 0 }, bytesPerSecond);
+  _impl->schedule();
+}
+
+void QtUpdateAgent::checkForUpdates(bool const force) {
+  for (const auto& source : _impl->sources) {
+    if (force) {
+      source->updater->forceCheckForUpdate();
+    } else {
+      source->updater->checkForUpdate();
+    }
+  }
+}
+
+#pragma endregion
+} // namespace oclero
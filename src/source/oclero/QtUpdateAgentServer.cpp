@@ -0,0 +1,120 @@
+#include <oclero/QtUpdateAgentServer.hpp>
+
+#include <oclero/QtUpdateAgent.hpp>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+namespace oclero {
+namespace {
+// Protects the agent from clients that never send a line break.
+constexpr auto MAX_REQUEST_SIZE = 4096;
+constexpr auto REQUEST_TAG_TARGET = "target";
+constexpr auto ANSWER_TAG_TARGETS = "targets";
+} // namespace
+
+struct QtUpdateAgentServer::Impl {
+  QtUpdateAgentServer& owner;
+  QtUpdateAgent& agent;
+  QLocalServer server;
+  // Error that doesn't come from the server.
+  QString error;
+
+  Impl(QtUpdateAgentServer& o, QtUpdateAgent& a)
+    : owner(o)
+    , agent(a) {
+    QObject::connect(&server, &QLocalServer::newConnection, &owner, [this]() {
+      onNewConnection();
+    });
+  }
+
+  void onNewConnection() {
+    while (auto* socket = server.nextPendingConnection()) {
+      QObject::connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+      QObject::connect(socket, &QLocalSocket::readyRead, &owner, [this, socket]() {
+        onReadyRead(*socket);
+      });
+    }
+  }
+
+  void onReadyRead(QLocalSocket& socket) {
+    while (socket.canReadLine()) {
+      const auto request = socket.readLine(MAX_REQUEST_SIZE);
+      socket.write(owner.answer(request) + '\n');
+    }
+
+    if (socket.bytesAvailable() > MAX_REQUEST_SIZE) {
+      socket.abort();
+    }
+  }
+};
+
+QtUpdateAgentServer::QtUpdateAgentServer(QtUpdateAgent& agent, QObject* parent)
+  : QObject(parent)
+  , _impl(new Impl(*this, agent)) {}
+
+QtUpdateAgentServer::~QtUpdateAgentServer() = default;
+
+bool QtUpdateAgentServer::listen(const QString& name) {
+  // Another agent may already use the name: it is left as is.
+  _impl->error.clear();
+  if (isListening(name)) {
+    _impl->error = QStringLiteral("Another agent is already listening");
+    return false;
+  }
+  // Otherwise, a previous agent may have crashed without removing its socket.
+  QLocalServer::removeServer(name);
+  // Only the current user may query the agent.
+  _impl->server.setSocketOptions(QLocalServer::UserAccessOption);
+  return _impl->server.listen(name);
+}
+
+bool QtUpdateAgentServer::isListening(const QString& name, int timeout) {
+  QLocalSocket socket;
+  socket.connectToServer(name);
+  return socket.waitForConnected(timeout);
+}
+
+QString QtUpdateAgentServer::errorString() const {
+  return _impl->error.isEmpty() ? _impl->server.errorString() : _impl->error;
+}
+
+QByteArray QtUpdateAgentServer::answer(const QByteArray& request) const {
+  const auto json = QJsonDocument::fromJson(request).object();
+  if (json.contains(REQUEST_TAG_TARGET)) {
+    const auto status = _impl->agent.targetStatus(json.value(REQUEST_TAG_TARGET).toString());
+    return QJsonDocument(status).toJson(QJsonDocument::Compact);
+  }
+
+  QJsonArray targets;
+  for (const auto& id : _impl->agent.targetIds()) {
+    targets.append(_impl->agent.targetStatus(id));
+  }
+  return QJsonDocument(QJsonObject{ { ANSWER_TAG_TARGETS, targets } }).toJson(QJsonDocument::Compact);
+}
+
+QByteArray QtUpdateAgentServer::query(const QByteArray& request, const QString& name, int timeout) {
+  QLocalSocket socket;
+  socket.connectToServer(name);
+  if (!socket.waitForConnected(timeout)) {
+    return {};
+  }
+
+  socket.write(request.trimmed() + '\n');
+  if (!socket.waitForBytesWritten(timeout)) {
+    return {};
+  }
+
+  QByteArray result;
+  while (!result.endsWith('\n')) {
+    if (!socket.waitForReadyRead(timeout)) {
+      return {};
+    }
+    result += socket.readAll();
+  }
+  return result.trimmed();
+}
+} // namespace oclero
@@ -6,20 +6,12 @@ namespace oclero {
 QtUpdateController::QtUpdateController(oclero::QtUpdater& updater, QObject* parent)
   : QObject(parent)
   , _updater(updater) {
-  const auto updaterState = _updater.state();
-  switch (updaterState) {
-    case QtUpdater::State::CheckingForUpdate:
-      setState(State::Checking);
-      break;
-    case QtUpdater::State::DownloadingInstaller:
-      setState(State::Downloading);
-      break;
-    case QtUpdater::State::InstallingUpdate:
-      setState(State::Installing);
-      break;
-    default:
-      break;
-  }
+  // The updater may live in another thread: its properties are only read from its status, and its slots are
+  // called with QMetaObject::invokeMethod() (directly if it lives in the same thread).
+  QObject::connect(&_updater, &QtUpdater::statusChanged, this, [this](const QtUpdater::Status& status) {
+    setStatus(status);
+  });
+  QMetaObject::invokeMethod(&_updater, &QtUpdater::requestStatus);
 
   // Checking.
   QObject::connect(&_updater, &QtUpdater::checkForUpdateForced, this, &QtUpdateController::manualCheckingRequested);
@@ -34,10 +26,10 @@ QtUpdateController::QtUpdateController(oclero::QtUpdater& updater, QObject* pare
     emit checkForUpdateErrorChanged(code);
   });
   QObject::connect(&_updater, &QtUpdater::checkForUpdateFinished, this, [this]() {
-    const auto availability = _updater.updateAvailability();
+    const auto availability = _status.updateAvailability;
     switch (availability) {
       case oclero::QtUpdater::UpdateAvailability::Available:
-        _updater.downloadChangelog();
+        QMetaObject::invokeMethod(&_updater, &QtUpdater::downloadChangelog);
         break;
       case oclero::QtUpdater::UpdateAvailability::UpToDate:
         setState(State::CheckingUpToDate);
@@ -48,7 +40,7 @@ QtUpdateController::QtUpdateController(oclero::QtUpdater& updater, QObject* pare
     }
   });
   QObject::connect(&_updater, &QtUpdater::changelogDownloadFinished, this, [this]() {
-    const auto available = _updater.changelogAvailable();
+    const auto available = _status.changelogAvailable;
     if (available) {
       setState(State::CheckingSuccess);
     }
@@ -64,12 +56,16 @@ QtUpdateController::QtUpdateController(oclero::QtUpdater& updater, QObject* pare
   QObject::connect(&_updater, &QtUpdater::installerDownloadProgressChanged, this, [this](int percentage) {
     setDownloadProgress(percentage);
   });
+  QObject::connect(&_updater, &QtUpdater::installerDownloadProgressDetailsChanged, this,
+    [this](qint64 bytesReceived, qint64 bytesTotal, double bytesPerSecond, qint64 remainingTime) {
+      setDownloadDetails(bytesReceived, bytesTotal, bytesPerSecond, remainingTime);
+    });
   QObject::connect(&_updater, &QtUpdater::installerDownloadFailed, this, [this](QtUpdater::ErrorCode code) {
     setState(State::DownloadingFail);
     emit updateDownloadErrorChanged(code);
   });
   QObject::connect(&_updater, &QtUpdater::installerDownloadFinished, this, [this]() {
-    const auto available = _updater.installerAvailable();
+    const auto available = _status.installerAvailable;
     setState(available ? State::DownloadingSuccess : State::DownloadingFail);
   });
 
@@ -104,6 +100,38 @@ void QtUpdateController::setState(State state) {
   }
 }
 
+void QtUpdateController::setStatus(const QtUpdater::Status& status) {
+  const auto firstStatus = !_statusReceived;
+  _statusReceived = true;
+  const auto versionChanged = status.currentVersion != _status.currentVersion;
+  const auto versionDateChanged = status.currentVersionDate != _status.currentVersionDate;
+  _status = status;
+
+  if (firstStatus) {
+    switch (status.state) {
+      case QtUpdater::State::CheckingForUpdate:
+        setState(State::Checking);
+        break;
+      case QtUpdater::State::DownloadingInstaller:
+        setState(State::Downloading);
+        break;
+      case QtUpdater::State::InstallingUpdate:
+        setState(State::Installing);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // The other changes are forwarded from the updater's signals.
+  if (versionChanged) {
+    emit currentVersionChanged();
+  }
+  if (versionDateChanged) {
+    emit currentVersionDateChanged();
+  }
+}
+
 void QtUpdateController::setDownloadProgress(int value) {
   if (value != _downloadProgress) {
     _downloadProgress = value;
@@ -111,58 +139,84 @@ void QtUpdateController::setDownloadProgress(int value) {
   }
 }
 
+void QtUpdateController::setDownloadDetails(
+  qint64 downloadedBytes, qint64 totalBytes, double downloadSpeed, qint64 remainingTime) {
+  if (downloadedBytes != _downloadedBytes || totalBytes != _totalBytes || downloadSpeed != _downloadSpeed
+      || remainingTime != _remainingTime) {
+    _downloadedBytes = downloadedBytes;
+    _totalBytes = totalBytes;
+    _downloadSpeed = downloadSpeed;
+    _remainingTime = remainingTime;
+    emit downloadDetailsChanged();
+  }
+}
+
 QString QtUpdateController::currentVersion() const {
-  return _updater.currentVersion();
+  return _status.currentVersion;
 }
 
 QDateTime QtUpdateController::currentVersionDate() const {
-  return _updater.currentVersionDate();
+  return _status.currentVersionDate;
 }
 
 QString QtUpdateController::latestVersion() const {
-  return _updater.latestVersion();
+  return _status.latestVersion;
 }
 
 QDateTime QtUpdateController::latestVersionDate() const {
-  return _updater.latestVersionDate();
+  return _status.latestVersionDate;
 }
 
 QString QtUpdateController::latestVersionChangelog() const {
-  return _updater.latestChangelog();
+  return _status.latestChangelog;
 }
 
 int QtUpdateController::downloadProgress() const {
   return _downloadProgress;
 }
 
+qint64 QtUpdateController::downloadedBytes() const {
+  return _downloadedBytes;
+}
+
+qint64 QtUpdateController::totalBytes() const {
+  return _totalBytes;
+}
+
+double QtUpdateController::downloadSpeed() const {
+  return _downloadSpeed;
+}
+
+qint64 QtUpdateController::remainingTime() const {
+  return _remainingTime;
+}
+
 void QtUpdateController::cancel() {
-  _updater.cancel();
+  QMetaObject::invokeMethod(&_updater, &QtUpdater::cancel);
   setState(State::None);
   emit closeDialogRequested();
 }
 
 void QtUpdateController::checkForUpdate() {
-  _updater.checkForUpdate();
+  QMetaObject::invokeMethod(&_updater, &QtUpdater::checkForUpdate);
 }
 
 void QtUpdateController::forceCheckForUpdate() {
-  _updater.forceCheckForUpdate();
+  QMetaObject::invokeMethod(&_updater, &QtUpdater::forceCheckForUpdate);
 }
 
 void QtUpdateController::downloadUpdate() {
-  if (_updater.updateAvailability() == oclero::QtUpdater::UpdateAvailability::Available) {
-#ifdef Q_OS_LINUX
-    emit linuxDownloadUpdateRequested();
-    emit closeDialogRequested();
-#else
-    _updater.downloadInstaller();
-#endif
+  if (_status.updateAvailability == oclero::QtUpdater::UpdateAvailability::Available) {
+    QMetaObject::invokeMethod(&_updater, &QtUpdater::downloadInstaller);
   }
 }
 
 void QtUpdateController::installUpdate() {
-  if (_updater.installerAvailable()) {
-    _updater.installUpdate();
+  if (_status.installerAvailable) {
+    auto* updater = &_updater;
+    QMetaObject::invokeMethod(updater, [updater]() {
+      updater->installUpdate();
+    });
   }
 }
 } // namespace oclero
@@ -1,6 +1,12 @@
 #include <oclero/QtUpdater.hpp>
 
 #include <oclero/QtDownloader.hpp>
+#include <oclero/Changelog.hpp>
+#include <oclero/UpdateJSON.hpp>
+#include <oclero/FileUtils.hpp>
+#include <oclero/SharedCache.hpp>
+#include <oclero/PeerNetwork.hpp>
+#include <oclero/Mirrors.hpp>
 
 #include <oclero/QtEnumUtils.hpp>
 #include <oclero/QtSettingsUtils.hpp>
@@ -9,17 +15,40 @@
 #include <QLoggingCategory>
 #include <QFile>
 #include <QVersionNumber>
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QCryptographicHash>
 #include <QFileInfo>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QCoreApplication>
 #include <QDir>
 #include <QStandardPaths>
-#include <QProcess>
-
+#include <QSaveFile>
+#include <QDataStream>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QUrlQuery>
+#include <QNetworkAccessManager>
+
+#include <atomic>
 #include <optional>
+#include <memory>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+#if defined(Q_OS_WIN)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#else
+#  include <sys/stat.h>
+#endif
 
 Q_LOGGING_CATEGORY(CATEGORY_UPDATER, "oclero.qtupdater")
 
@@ -52,193 +81,226 @@ QString getDefaultTemporaryDirectoryPath() {
 
   return result;
 }
+
+// Returns an identifier that changes when the file is replaced (inode on Unix, file index on Windows), or 0.
+quint64 getFileIdentifier(const QString& filePath) {
+#if defined(Q_OS_WIN)
+  const auto nativePath = QDir::toNativeSeparators(filePath);
+  const auto handle = CreateFileW(reinterpret_cast<const wchar_t*>(nativePath.utf16()), FILE_READ_ATTRIBUTES,
+    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS,
+    nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return 0;
+  }
+  quint64 result{ 0 };
+  BY_HANDLE_FILE_INFORMATION info;
+  if (GetFileInformationByHandle(handle, &info)) {
+    result = (static_cast<quint64>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+  }
+  CloseHandle(handle);
+  return result;
+#else
+  struct stat info;
+  if (::stat(QFile::encodeName(filePath).constData(), &info) != 0) {
+    return 0;
+  }
+  return static_cast<quint64>(info.st_ino);
+#endif
+}
 } // namespace utils
 
 namespace oclero {
-constexpr auto JSON_DATETIME_FORMAT = "dd/MM/yyyy";
-constexpr auto JSON_TAG_CHECKSUM = "checksum";
-constexpr auto JSON_TAG_CHECKSUM_TYPE = "checksumType";
-constexpr auto JSON_TAG_DATE = "date";
-constexpr auto JSON_TAG_INSTALLER_URL = "installerUrl";
-constexpr auto JSON_TAG_CHANGELOG_URL = "changelogUrl";
-constexpr auto JSON_TAG_VERSION = "version";
-
 constexpr auto SETTINGS_KEY_LASTCHECKTIME = "Update/LastCheckTime";
 constexpr auto SETTINGS_KEY_FREQUENCY = "Update/CheckFrequency";
 constexpr auto SETTINGS_KEY_LASTUPDATEJSON = "Update/LastUpdateJSON";
-
-class LazyFileContent {
-public:
-  LazyFileContent(const QString& path = {})
-    : _path(path) {}
-
-  void setPath(const QString& path) {
-    if (path != _path) {
-      _path = path;
-      _content.reset();
+// Followed by the network identifier.
+constexpr auto SETTINGS_KEY_FASTESTMIRROR = "Update/FastestMirror";
+constexpr auto SETTINGS_KEY_CHECKDURATIONS = "Update/CheckDurations";
+// Group of the statistics of the hosts, by percent-encoded host name.
+constexpr auto SETTINGS_GROUP_HOSTSTATISTICS = "Update/HostStatistics";
+
+// Appcast read when the server URL is a local directory.
+constexpr auto LOCAL_APPCAST_FILE_NAME = "appcast.json";
+
+constexpr auto CACHE_FILE_NAME = "update.cache";
+constexpr quint32 CACHE_MAGIC = 0x43505551; // 'QUPC'
+constexpr quint16 CACHE_FORMAT_VERSION = 5;
+constexpr int CACHE_HEADER_SIZE = 4 + 2 + 2 + 4 + 16; // Magic, version, reserved, payload size, payload MD5.
+
+// Query parameter used to ask the server for the changelog sections newer than a version.
+constexpr auto CHANGELOG_QUERY_SINCE = "since";
+
+// The event loop is considered busy when a timer fires later than this (milliseconds).
+constexpr int PREFETCH_BUSY_PROBE_INTERVAL = 100;
+constexpr qint64 PREFETCH_BUSY_LAG = 50;
+// Number of late timers in a row needed to pause the prefetch: a single slow event doesn't drop the connection.
+constexpr int PREFETCH_BUSY_SAMPLES = 5;
+// Prefetch resumes when the event loop has not been busy for this duration (milliseconds).
+constexpr qint64 PREFETCH_IDLE_DELAY = 2000;
+// Mirrors that don't send their first byte within this duration lose the race (milliseconds).
+constexpr int MIRROR_RACE_TIMEOUT = 3000;
+// Number of previous check durations kept to compute the hedging delay, and needed to use it.
+constexpr int CHECK_DURATION_SAMPLES = 20;
+constexpr int HEDGING_MIN_SAMPLES = 5;
+
+/**
+ * @brief Size, modification time and identifier of a file, used to detect if it changed since it was last seen.
+ */
+struct FileStamp {
+  qint64 size{ -1 };
+  qint64 lastModified{ -1 };
+  quint64 fileId{ 0 };
+
+  static FileStamp fromFile(const QString& filePath) {
+    const QFileInfo fileInfo(filePath);
+    if (filePath.isEmpty() || !fileInfo.exists() || !fileInfo.isFile()) {
+      return {};
     }
+    return { fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch(), utils::getFileIdentifier(filePath) };
   }
 
-  const QString& getContent() {
-    if (!_content.has_value()) {
-      if (!_path.isEmpty()) {
-        QFile file(_path);
-        if (file.open(QIODevice::ReadOnly)) {
-          _content = QString::fromUtf8(file.readAll());
-        } else {
-          _content = QString(); // Mark as read.
-        }
-        file.close();
-      } else {
-        _content = QString(); // Mark as read.
-      }
-    }
-    return _content.value();
+  bool isValid() const {
+    return size >= 0 && lastModified >= 0;
   }
 
-private:
-  QString _path;
-  std::optional<QString> _content;
-};
-
-struct UpdateJSON {
-  QVersionNumber version;
-  QUrl installerUrl;
-  QUrl changelogUrl;
-  QByteArray checksum;
-  QtDownloader::ChecksumType checksumType{ QtDownloader::ChecksumType::NoChecksum };
-  QDateTime date;
-
-  UpdateJSON() = default;
-
-  UpdateJSON(const QByteArray& data) {
-    const auto jsonDocument = QJsonDocument::fromJson(data);
-    if (!jsonDocument.isNull() && jsonDocument.isObject()) {
-      const auto jsonObject = jsonDocument.object();
-      if (!jsonObject.isEmpty()) {
-        if (jsonObject.contains(JSON_TAG_VERSION)) {
-          version = QVersionNumber::fromString(jsonObject[JSON_TAG_VERSION].toString());
-        }
-
-        if (jsonObject.contains(JSON_TAG_CHANGELOG_URL)) {
-          changelogUrl = QUrl(jsonObject[JSON_TAG_CHANGELOG_URL].toString());
-        }
-
-        if (jsonObject.contains(JSON_TAG_INSTALLER_URL)) {
-          installerUrl = QUrl(jsonObject[JSON_TAG_INSTALLER_URL].toString());
-        }
-
-        if (jsonObject.contains(JSON_TAG_CHECKSUM)) {
-          checksum = jsonObject[JSON_TAG_CHECKSUM].toString().toUtf8();
-        }
-
-        if (jsonObject.contains(JSON_TAG_CHECKSUM_TYPE)) {
-          checksumType =
-            enumFromString<QtDownloader::ChecksumType>(jsonObject[JSON_TAG_CHECKSUM_TYPE].toString().toUpper());
-        }
-
-        if (jsonObject.contains(JSON_TAG_DATE)) {
-          date = QDateTime::fromString(jsonObject[JSON_TAG_DATE].toString(), JSON_DATETIME_FORMAT);
-        }
-      }
-    }
+  bool operator==(const FileStamp& other) const {
+    return size == other.size && lastModified == other.lastModified && fileId == other.fileId;
   }
 
-  bool isValid() const {
-    const auto validVersionNumber = !version.isNull();
-    if (!validVersionNumber)
-      return false;
+  bool operator!=(const FileStamp& other) const {
+    return !(*this == other);
+  }
+};
 
-    const auto validInstallerUrl = installerUrl.isEmpty() || installerUrl.isValid();
-    if (!validInstallerUrl)
-      return false;
+/**
+ * @brief Compact binary snapshot of the last appcast and of the files downloaded for it.
+ * Allows a warm start without parsing JSON (if the binary cache is enabled), and without hashing again an installer
+ * that was already verified (always).
+ * Layout: a fixed-size header (magic, format version, payload size, payload MD5) followed by a QDataStream payload.
+ */
+struct UpdateCache {
+  UpdateJSON json;
+  FileStamp installer;
+  FileStamp changelog;
+  // Checksum the installer was successfully verified against (empty if not verified).
+  QByteArray verifiedChecksum;
 
-    const auto validChangelogUrl = changelogUrl.isEmpty() || changelogUrl.isValid();
-    if (!validChangelogUrl)
-      return false;
+  bool isValid() const {
+    return json.isValid();
+  }
 
-    const auto validDate = date.isValid();
-    if (!validDate)
-      return false;
+  // Whether the installer expected by the appcast was verified, i.e. the same file against the same checksum.
+  bool installerIsVerified(const UpdateJSON& expected) const {
+    return installer.isValid() && !verifiedChecksum.isEmpty() && verifiedChecksum == expected.checksum.toLower()
+           && json.checksumType == expected.checksumType
+           && json.installerUrl.fileName() == expected.installerUrl.fileName();
+  }
 
-    auto validChecksum = true;
-    if (checksumType != QtDownloader::ChecksumType::NoChecksum) {
-      auto qtAlgorithm = QCryptographicHash::Md5;
-      switch (checksumType) {
-        case QtDownloader::ChecksumType::MD5:
-          qtAlgorithm = QCryptographicHash::Algorithm::Md5;
-          break;
-        case QtDownloader::ChecksumType::SHA1:
-          qtAlgorithm = QCryptographicHash::Algorithm::Sha1;
-          break;
-        default:
-          break;
+  QByteArray toBinary() const {
+    QByteArray payload;
+    {
+      QDataStream stream(&payload, QIODevice::WriteOnly);
+      stream.setVersion(QDataStream::Qt_5_15);
+      stream << json.version << json.installerUrl << json.changelogUrl << json.checksum
+             << static_cast<qint32>(json.checksumType) << json.date.toMSecsSinceEpoch() << json.changelogDelta
+             << json.blockManifestUrl;
+      stream << static_cast<qint32>(json.mirrors.size());
+      for (const auto& mirror : json.mirrors) {
+        stream << mirror.url << mirror.weight;
       }
-
-      validChecksum = !checksum.isEmpty() && checksum.size() == 2 * QCryptographicHash::hashLength(qtAlgorithm);
+      stream << installer.size << installer.lastModified << installer.fileId;
+      stream << changelog.size << changelog.lastModified << changelog.fileId;
+      stream << verifiedChecksum;
     }
-    if (!validChecksum)
-      return false;
 
-    return true;
+    QByteArray result;
+    result.reserve(CACHE_HEADER_SIZE + payload.size());
+    {
+      QDataStream stream(&result, QIODevice::WriteOnly);
+      stream.setVersion(QDataStream::Qt_5_15);
+      stream << CACHE_MAGIC << CACHE_FORMAT_VERSION << quint16{ 0 } << static_cast<quint32>(payload.size());
+      stream.writeRawData(QCryptographicHash::hash(payload, QCryptographicHash::Md5).constData(), 16);
+    }
+    result.append(payload);
+    return result;
   }
 
-  QByteArray toJSON() const {
-    if (!isValid()) {
-      return QByteArray();
+  static std::optional<UpdateCache> fromBinary(const QByteArray& data) {
+    if (data.size() < CACHE_HEADER_SIZE) {
+      return std::nullopt;
     }
 
-    // Create JSON object.
-    QJsonObject jsonObject({
-      { JSON_TAG_VERSION, version.toString() },
-      { JSON_TAG_INSTALLER_URL, installerUrl.toString() },
-      { JSON_TAG_CHANGELOG_URL, changelogUrl.toString() },
-      { JSON_TAG_CHECKSUM, checksum.constData() },
-      { JSON_TAG_CHECKSUM_TYPE, enumToString(checksumType).toLower() },
-      { JSON_TAG_DATE, date.toString(JSON_DATETIME_FORMAT) },
-    });
+    // Header.
+    QDataStream headerStream(data.left(CACHE_HEADER_SIZE));
+    headerStream.setVersion(QDataStream::Qt_5_15);
+    quint32 magic{ 0 };
+    quint16 formatVersion{ 0 };
+    quint16 reserved{ 0 };
+    quint32 payloadSize{ 0 };
+    headerStream >> magic >> formatVersion >> reserved >> payloadSize;
+    if (magic != CACHE_MAGIC || formatVersion != CACHE_FORMAT_VERSION
+        || static_cast<qint64>(payloadSize) != data.size() - CACHE_HEADER_SIZE) {
+      return std::nullopt;
+    }
 
-    return QJsonDocument(jsonObject).toJson(QJsonDocument::JsonFormat::Compact);
-  }
+    const auto payload = QByteArray::fromRawData(data.constData() + CACHE_HEADER_SIZE, payloadSize);
+    const auto expectedDigest = QByteArray::fromRawData(data.constData() + CACHE_HEADER_SIZE - 16, 16);
+    if (QCryptographicHash::hash(payload, QCryptographicHash::Md5) != expectedDigest) {
+      return std::nullopt;
+    }
 
-  std::tuple<bool, QString> saveToFile(const QString& dirPath) const {
-    if (!isValid()) {
-      return { false, {} };
+    // Payload.
+    UpdateCache result;
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_15);
+    qint32 checksumType{ 0 };
+    qint64 date{ 0 };
+    stream >> result.json.version >> result.json.installerUrl >> result.json.changelogUrl >> result.json.checksum
+      >> checksumType >> date >> result.json.changelogDelta >> result.json.blockManifestUrl;
+    qint32 mirrorCount{ 0 };
+    stream >> mirrorCount;
+    for (auto i = 0; i < mirrorCount && stream.status() == QDataStream::Ok; ++i) {
+      UpdateJSON::Mirror mirror;
+      stream >> mirror.url >> mirror.weight;
+      result.json.mirrors.append(mirror);
     }
+    stream >> result.installer.size >> result.installer.lastModified >> result.installer.fileId;
+    stream >> result.changelog.size >> result.changelog.lastModified >> result.changelog.fileId;
+    stream >> result.verifiedChecksum;
+    if (stream.status() != QDataStream::Ok) {
+      return std::nullopt;
+    }
+    result.json.checksumType = static_cast<QtDownloader::ChecksumType>(checksumType);
+    result.json.date = QDateTime::fromMSecsSinceEpoch(date);
 
-    const auto filename = QFileInfo(installerUrl.fileName()).completeBaseName();
-    const auto filePath = dirPath + '/' + filename + ".json";
-    QFile file(filePath);
+    return result;
+  }
 
-    // Remove existing JSON file, if one.
-    if (file.exists()) {
-      if (!file.remove()) {
-        return { false, {} };
-      }
+  bool saveToFile(const QString& dirPath) const {
+    if (!isValid()) {
+      return false;
     }
 
-    // Create directory if not existing yet.
     QDir const dir(dirPath);
-    if (!dir.exists()) {
-      if (!dir.mkpath(".")) {
-        return { false, {} };
-      }
+    if (!dir.exists() && !dir.mkpath(".")) {
+      return false;
     }
 
-    // Write file.
+    QSaveFile file(dir.absoluteFilePath(CACHE_FILE_NAME));
     if (!file.open(QIODevice::WriteOnly)) {
-      return { false, {} };
+      return false;
     }
+    file.write(toBinary());
+    return fileutils::commitDurably(file);
+  }
 
-    const auto data = toJSON();
-    if (data.isEmpty()) {
-      return { false, {} };
+  static std::optional<UpdateCache> loadFromFile(const QString& dirPath) {
+    QFile file(dirPath + '/' + CACHE_FILE_NAME);
+    if (!file.open(QIODevice::ReadOnly)) {
+      return std::nullopt;
     }
-
-    file.write(data);
-    file.close();
-
-    return { true, filePath };
+    // The cache is small: a single read is enough.
+    return fromBinary(file.readAll());
   }
 };
 
@@ -246,7 +308,8 @@ struct UpdateInfo {
   UpdateJSON json;
   QFileInfo installer;
   QFileInfo changelog;
-  LazyFileContent changelogContent;
+  // State of the installer file when its checksum was last successfully verified.
+  FileStamp verifiedInstaller;
 
   bool isValid() const {
     return json.isValid();
@@ -268,21 +331,27 @@ struct UpdateInfo {
     return isValid() && installer.exists() && installer.isFile() && isOSInstaller;
   }
 
-  const QString& getChangelogContent() {
-    changelogContent.setPath(changelog.absoluteFilePath());
-    return changelogContent.getContent();
+  bool installerAlreadyVerified() const {
+    return verifiedInstaller.isValid() && verifiedInstaller == FileStamp::fromFile(installer.absoluteFilePath());
   }
 };
 
+QtUpdater::ErrorCode mapError(QtDownloader::ErrorCode error);
+
 struct QtUpdater::Impl {
   QtUpdater& owner;
   SettingsParameters settingsParameters;
   QString serverUrl;
   bool serverUrlInitialized{ false };
   State state{ State::Idle };
+  // Shared by the downloaders (unless the application gives one), so that a download reuses the connection
+  // opened by another request to the same host, e.g. the race of the mirrors.
+  QNetworkAccessManager networkAccessManager;
   QtDownloader downloader;
   UpdateInfo localUpdateInfo;
   UpdateInfo onlineUpdateInfo;
+  // Block manifest of the online installer, given to the downloader of each attempt to download it.
+  QtDownloader::BlockManifest installerBlockManifest;
   Frequency frequency{ Frequency::EveryDay };
   QDateTime lastCheckTime;
   int checkTimeout{ QtDownloader::DefaultTimeout };
@@ -291,11 +360,107 @@ struct QtUpdater::Impl {
   QString currentVersion{ QCoreApplication::applicationVersion() };
   QDateTime currentVersionDate;
   InstallMode installMode{ InstallMode::ExecuteFile };
+  std::shared_ptr<QtInstallStrategy> installStrategy;
   QString installerDestinationDir;
+  bool binaryCacheEnabled{ false };
+  QString sharedCacheDirectory;
+  qint64 sharedCacheSizeLimit{ DefaultSharedCacheSizeLimit };
+  bool paranoidVerification{ false };
+  qint64 changelogSizeLimit{ 0 };
+  bool changelogSinceCurrentVersion{ false };
+  // Changelog content is decoded in a worker thread, to never block the caller.
+  QString changelogContent;
+  QString changelogContentPath;
+  QString changelogLoadingPath;
+  QFutureWatcher<QString> changelogWatcher;
+  // The install strategy runs in a worker thread, since it may copy or extract large files.
+  QFutureWatcher<QtInstallStrategy::Result> installWatcher;
+  // Set while the installer is verified in a worker thread: stops the hash.
+  std::shared_ptr<std::atomic_bool> verificationCancelled;
+  // Retrieval of the installer from the shared cache, if running.
+  QFutureWatcher<bool>* sharedCacheWatcher{ nullptr };
+  // Changelog of a previously downloaded update, kept to be merged with the sections newer than its version.
+  QVersionNumber previousChangelogVersion;
+  QByteArray previousChangelog;
+  // Merge of the downloaded changelog fragment, if running.
+  QFutureWatcher<void>* changelogMergeWatcher{ nullptr };
+  bool changelogMergePrefetched{ false };
+  // Background download of the changelog and the installer, with its own downloader.
+  enum class PrefetchStage {
+    None,
+    Changelog,
+    Installer,
+  };
+  QtDownloader prefetchDownloader;
+  bool prefetchEnabled{ false };
+  qint64 prefetchBandwidthLimit{ DefaultPrefetchBandwidthLimit };
+  bool prefetchPaused{ false };
+  PrefetchStage prefetchStage{ PrefetchStage::None };
+  // The user asked for the file being prefetched: the download is shown and not throttled anymore.
+  bool prefetchPromoted{ false };
+  bool eventLoopBusy{ false };
+  QTimer busyProbe;
+  QElapsedTimer busyClock;
+  qint64 lastBusyProbeTime{ 0 };
+  qint64 lastBusyTime{ 0 };
+  int busySamples{ 0 };
+  PeerOptions peerOptions;
+  PeerNetwork peerNetwork{ owner };
+  // The installer downloaded from a peer is verified before being accepted: it is not hashed again.
+  bool installerVerifiedFromPeer{ false };
+  // Second appcast request, sent when the first one is slower than usual.
+  HedgingOptions hedgingOptions;
+  QtDownloader hedgeDownloader;
+  QTimer hedgeTimer;
+  QElapsedTimer checkClock;
+  // Replies of previous checks are ignored.
+  int checkRequestId{ 0 };
+  int pendingCheckRequests{ 0 };
+  int nextAlternateServerUrl{ 0 };
+  // Durations of the previous successful checks, in milliseconds, the most recent last.
+  QVector<qint64> checkDurations;
+  // Shared by the downloaders, to adapt their timeouts to the hosts.
+  std::shared_ptr<QtDownloader::HostStatisticsMap> hostStatistics{
+    std::make_shared<QtDownloader::HostStatisticsMap>()
+  };
 
   Impl(QtUpdater& o, const SettingsParameters& p = {})
     : owner(o)
     , settingsParameters(p) {
+    // Children move along with the updater when it is moved to a worker thread.
+    networkAccessManager.setParent(&owner);
+    downloader.setParent(&owner);
+    prefetchDownloader.setParent(&owner);
+    hedgeDownloader.setParent(&owner);
+    timer.setParent(&owner);
+    hedgeTimer.setParent(&owner);
+    busyProbe.setParent(&owner);
+    changelogWatcher.setParent(&owner);
+    installWatcher.setParent(&owner);
+    for (auto* const source : { &downloader, &prefetchDownloader, &hedgeDownloader }) {
+      source->setNetworkAccessManager(&networkAccessManager);
+    }
+
+    qRegisterMetaType<QtUpdater::Status>();
+    qRegisterMetaType<QtUpdater::ErrorCode>();
+    qRegisterMetaType<QtDownloader::TransferMetrics>();
+    // Connected first, so that the status is up-to-date when the other receivers are notified.
+    for (const auto signal : { &QtUpdater::stateChanged, &QtUpdater::updateAvailabilityChanged,
+           &QtUpdater::changelogAvailableChanged, &QtUpdater::installerAvailableChanged,
+           &QtUpdater::currentVersionChanged, &QtUpdater::latestVersionChanged, &QtUpdater::latestVersionDateChanged,
+           &QtUpdater::latestChangelogChanged,
+           &QtUpdater::checkForUpdateFinished, &QtUpdater::changelogDownloadFinished,
+           &QtUpdater::installerDownloadFinished }) {
+      QObject::connect(&o, signal, &o, &QtUpdater::requestStatus);
+    }
+
+    // The verified installer is shared as soon as it is available.
+    for (const auto signal : { &QtUpdater::updateAvailabilityChanged, &QtUpdater::installerAvailableChanged }) {
+      QObject::connect(&o, signal, &o, [this]() {
+        updatePeerSharing();
+      });
+    }
+
     // Load settings.
     QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
       settingsParameters.application);
@@ -318,6 +483,105 @@ struct QtUpdater::Impl {
     if (frequency == Frequency::EveryHour) {
       timer.start();
     }
+
+    const auto checkDurationsInSettings = loadSetting<QString>(settings, SETTINGS_KEY_CHECKDURATIONS);
+    for (const auto& value : checkDurationsInSettings.split(',', Qt::SkipEmptyParts)) {
+      checkDurations.append(value.toLongLong());
+    }
+
+    loadHostStatistics(settings);
+    for (auto* source : { &downloader, &prefetchDownloader, &hedgeDownloader }) {
+      source->setHostStatistics(hostStatistics);
+    }
+
+    hedgeTimer.setSingleShot(true);
+    QObject::connect(&hedgeTimer, &QTimer::timeout, &o, [this]() {
+      sendHedgedAppcastRequest();
+    });
+
+    QObject::connect(&changelogWatcher, &QFutureWatcher<QString>::finished, &o, [this]() {
+      onChangelogLoaded();
+    });
+
+    QObject::connect(&installWatcher, &QFutureWatcher<QtInstallStrategy::Result>::finished, &o, [this]() {
+      onInstallFinished(installWatcher.result());
+    });
+
+    busyClock.start();
+    busyProbe.setInterval(PREFETCH_BUSY_PROBE_INTERVAL);
+    busyProbe.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&busyProbe, &QTimer::timeout, &o, [this]() {
+      onBusyProbe();
+    });
+  }
+
+  ~Impl() {
+    // The workers only read their own copies of the arguments, but we must not outlive their results.
+    changelogWatcher.waitForFinished();
+    installWatcher.waitForFinished();
+    cancelVerification();
+  }
+
+  // Starts loading the changelog in a worker thread, if not already loaded or loading.
+  void loadChangelog(const QString& path) {
+    if (path.isEmpty() || path == changelogContentPath || path == changelogLoadingPath) {
+      return;
+    }
+
+    changelogLoadingPath = path;
+    changelog::LoadOptions options;
+    options.maxSize = changelogSizeLimit;
+    if (changelogSinceCurrentVersion) {
+      options.sinceVersion = QVersionNumber::fromString(currentVersion);
+    }
+    changelogWatcher.setFuture(QtConcurrent::run([path, options]() {
+      return changelog::load(path, options);
+    }));
+  }
+
+  void onChangelogLoaded() {
+    if (changelogLoadingPath.isEmpty()) {
+      return;
+    }
+
+    changelogContent = changelogWatcher.result();
+    changelogContentPath = changelogLoadingPath;
+    changelogLoadingPath.clear();
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Changelog loaded @" << changelogContentPath;
+#endif
+    emit owner.latestChangelogChanged();
+  }
+
+  void onInstallFinished(QtInstallStrategy::Result const result) {
+    if (result == QtInstallStrategy::Result::Failure || result == QtInstallStrategy::Result::DiskError) {
+#if UPDATER_ENABLE_DEBUG
+      qCDebug(CATEGORY_UPDATER) << "Installation failed";
+#endif
+      setState(State::Idle);
+      emit owner.installationFailed(result == QtInstallStrategy::Result::DiskError ? ErrorCode::DiskError
+                                                                                  : ErrorCode::InstallerExecutionError);
+      return;
+    }
+
+    if (result == QtInstallStrategy::Result::QuitApplication) {
+#if UPDATER_ENABLE_DEBUG
+      qCDebug(CATEGORY_UPDATER) << "App will quit to let the installer do the update";
+#endif
+      // The updater may live in a worker thread.
+      QMetaObject::invokeMethod(QCoreApplication::instance(), []() {
+        QCoreApplication::quit();
+      });
+    }
+
+    setState(State::Idle);
+    emit owner.installationFinished();
+  }
+
+  void resetChangelog() {
+    changelogContent.clear();
+    changelogContentPath.clear();
+    changelogLoadingPath.clear();
   }
 
   void setState(State const value) {
@@ -339,6 +603,17 @@ struct QtUpdater::Impl {
     }
   }
 
+  // Same, to record the verification of its installer.
+  UpdateInfo* mostRecentUpdate() {
+    if (onlineUpdateInfo.isValid()) {
+      return &onlineUpdateInfo;
+    } else if (localUpdateInfo.isValid()) {
+      return &localUpdateInfo;
+    } else {
+      return nullptr;
+    }
+  }
+
   UpdateAvailability updateAvailability() const {
     const auto update = mostRecentUpdate();
     if (update && update->isValid()) {
@@ -357,7 +632,7 @@ struct QtUpdater::Impl {
 
   bool installerAvailable() const {
     if (updateAvailability() == UpdateAvailability::Available) {
-      return installMode == InstallMode::ExecuteFile ? mostRecentUpdate()->readyToInstall() : true;
+      return installMode == InstallMode::ExecuteFile || installStrategy ? mostRecentUpdate()->readyToInstall() : true;
     }
     return false;
   }
@@ -397,6 +672,15 @@ struct QtUpdater::Impl {
   }
 
   UpdateInfo checkForLocalUpdate() const {
+    // Warm start: try the binary cache first, to avoid parsing JSON.
+    const auto cache = UpdateCache::loadFromFile(downloadsDir);
+    if (binaryCacheEnabled && cache && cache->isValid()) {
+#if UPDATER_ENABLE_DEBUG
+      qCDebug(CATEGORY_UPDATER) << "Found previously downloaded update data in cache";
+#endif
+      return checkForLocalBundle(cache->json, cache);
+    }
+
     // Check presence of a JSON file.
     QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
       settingsParameters.application);
@@ -441,6 +725,10 @@ struct QtUpdater::Impl {
       return UpdateInfo{};
     }
 
+    return checkForLocalBundle(localJSON, cache);
+  }
+
+  UpdateInfo checkForLocalBundle(const UpdateJSON& localJSON, const std::optional<UpdateCache>& cache) const {
     // Check presence of changelog and installer files along with the JSON file.
     const auto changelogFileName = localJSON.changelogUrl.fileName();
     QFileInfo localChangelog(downloadsDir + '/' + changelogFileName);
@@ -455,7 +743,768 @@ struct QtUpdater::Impl {
       return UpdateInfo{};
     }
 
-    return UpdateInfo{ localJSON, localInstaller, localChangelog, {} };
+    auto result = UpdateInfo{ localJSON, localInstaller, localChangelog };
+    if (cache && cache->installerIsVerified(localJSON)) {
+      result.verifiedInstaller = cache->installer;
+    }
+    return result;
+  }
+
+  // Whether the checksum of the installer must be computed, i.e. it was not already verified or changed since.
+  bool installerNeedsVerification(const UpdateInfo& update) const {
+    if (update.json.checksumType == QtDownloader::ChecksumType::NoChecksum) {
+      return false;
+    }
+
+    if (!paranoidVerification && update.installerAlreadyVerified()) {
+#if UPDATER_ENABLE_DEBUG
+      qCDebug(CATEGORY_UPDATER) << "Installer already verified";
+#endif
+      return false;
+    }
+    return true;
+  }
+
+  // Persists the successful verification, so that the installer is not hashed again while unchanged.
+  void recordInstallerVerification(UpdateInfo& update) const {
+    update.verifiedInstaller = FileStamp::fromFile(update.installer.absoluteFilePath());
+    saveCache(update);
+  }
+
+  // Verifies the checksum of the installer, unless it was already verified and has not changed since.
+  // The file is hashed in a worker thread, then onFinished() is called in the updater's thread, and an invalid
+  // installer is removed. Called at once if no hash is needed. Stopped by cancelVerification(): onFinished() is then
+  // called with nothing, and the installer is kept.
+  void verifyInstaller(
+    UpdateInfo& update, std::function<void(std::optional<bool> const checksumIsValid)> onFinished) {
+    if (!installerNeedsVerification(update)) {
+      onFinished(true);
+      return;
+    }
+
+    const auto installerPath = update.installer.absoluteFilePath();
+    const auto checksum = update.json.checksum;
+    const auto checksumType = update.json.checksumType;
+    update.verifiedInstaller = {};
+
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    verificationCancelled = cancelled;
+    auto* watcher = new QFutureWatcher<bool>(&owner);
+    QObject::connect(watcher, &QFutureWatcher<bool>::finished, &owner,
+      [this, watcher, cancelled, &update, installerPath, onFinished = std::move(onFinished)]() {
+        watcher->deleteLater();
+        // Cancelled: the update may have changed since.
+        if (*cancelled) {
+          onFinished(std::nullopt);
+          return;
+        }
+
+        if (verificationCancelled == cancelled) {
+          verificationCancelled.reset();
+        }
+        const auto checksumIsValid = watcher->result();
+        if (checksumIsValid) {
+          recordInstallerVerification(update);
+        } else {
+#if UPDATER_ENABLE_DEBUG
+          qCDebug(CATEGORY_UPDATER) << "Checksum is invalid";
+#endif
+          QFile::remove(installerPath);
+        }
+        onFinished(checksumIsValid);
+      });
+    // The worker only reads the file.
+    watcher->setFuture(QtConcurrent::run([installerPath, checksum, checksumType, cancelled]() {
+      return QtDownloader::verifyFileChecksum(installerPath, checksum, checksumType,
+        QtDownloader::InvalidChecksumBehavior::KeepFile, nullptr, [cancelled]() {
+          return cancelled->load();
+        });
+    }));
+  }
+
+  // Same as verifyInstaller(), in the VerifyingInstaller state, with a future.
+  QFuture<ErrorCode> verifyInstallerInBackground(UpdateInfo& update) {
+    setState(State::VerifyingInstaller);
+    auto promise = std::make_shared<QFutureInterface<ErrorCode>>();
+    promise->reportStarted();
+    verifyInstaller(update, [this, promise](std::optional<bool> const checksumIsValid) {
+      // Cancelled by cancel(): the state is already Idle.
+      if (!checksumIsValid) {
+        promise->reportCanceled();
+        promise->reportFinished();
+        return;
+      }
+
+      setState(State::Idle);
+      if (!*checksumIsValid) {
+        emit owner.installerAvailableChanged();
+      }
+      promise->reportResult(*checksumIsValid ? ErrorCode::NoError : ErrorCode::ChecksumError);
+      promise->reportFinished();
+    });
+
+    // Canceling the future cancels the verification.
+    auto* promiseWatcher = new QFutureWatcher<ErrorCode>(&owner);
+    QObject::connect(promiseWatcher, &QFutureWatcher<ErrorCode>::canceled, &owner, [this]() {
+      if (state == State::VerifyingInstaller) {
+        owner.cancel();
+      }
+    });
+    QObject::connect(promiseWatcher, &QFutureWatcher<ErrorCode>::finished, promiseWatcher, &QObject::deleteLater);
+    promiseWatcher->setFuture(promise->future());
+    return promise->future();
+  }
+
+  // Stops the verification started by verifyInstaller(), if running. Returns true if it was running.
+  bool cancelVerification() {
+    if (!verificationCancelled) {
+      return false;
+    }
+    *verificationCancelled = true;
+    verificationCancelled.reset();
+    return true;
+  }
+
+  // Future that is already finished with the result, or canceled if there is none.
+  static QFuture<ErrorCode> finishedFuture(std::optional<ErrorCode> const result) {
+    QFutureInterface<ErrorCode> promise;
+    promise.reportStarted();
+    if (result) {
+      promise.reportResult(*result);
+    } else {
+      promise.reportCanceled();
+    }
+    promise.reportFinished();
+    return promise.future();
+  }
+
+  // Returns a future finished by the first signal that ends the operation started by 'start'.
+  // If the updater did not enter 'runningState' nor end the operation, the result is given by 'resultIfNotStarted'.
+  QFuture<ErrorCode> trackOperation(const std::function<void()>& start, State const runningState,
+    void (QtUpdater::*finished)(), void (QtUpdater::*failed)(ErrorCode), void (QtUpdater::*cancelled)(),
+    const std::function<std::optional<ErrorCode>()>& resultIfNotStarted) {
+    struct Operation {
+      QFutureInterface<ErrorCode> promise;
+      bool done{ false };
+    };
+    auto operation = std::make_shared<Operation>();
+    operation->promise.reportStarted();
+
+    // Holds the connections, until the operation ends.
+    auto* context = new QObject(&owner);
+    const auto complete = [operation, context](std::optional<ErrorCode> const result) {
+      if (operation->done) {
+        return;
+      }
+      operation->done = true;
+      if (result) {
+        operation->promise.reportResult(*result);
+      } else {
+        operation->promise.reportCanceled();
+      }
+      operation->promise.reportFinished();
+      context->deleteLater();
+    };
+    QObject::connect(&owner, finished, context, [complete]() {
+      complete(ErrorCode::NoError);
+    });
+    QObject::connect(&owner, failed, context, [complete](ErrorCode const error) {
+      complete(error);
+    });
+    QObject::connect(&owner, cancelled, context, [complete]() {
+      complete(std::nullopt);
+    });
+
+    // Canceling the future cancels the operation.
+    auto* watcher = new QFutureWatcher<ErrorCode>(context);
+    QObject::connect(watcher, &QFutureWatcher<ErrorCode>::canceled, context, [this, operation, complete]() {
+      if (!operation->done) {
+        owner.cancel();
+        complete(std::nullopt);
+      }
+    });
+    watcher->setFuture(operation->promise.future());
+
+    start();
+    if (!operation->done && state != runningState) {
+      complete(resultIfNotStarted());
+    }
+    return operation->promise.future();
+  }
+
+  bool sharedCacheUsable(const UpdateInfo& update) const {
+    const auto& json = update.json;
+    return !sharedCacheDirectory.isEmpty() && json.checksumType != QtDownloader::ChecksumType::NoChecksum
+           && !json.checksum.isEmpty();
+  }
+
+  // Takes the installer from the shared cache instead of downloading it, then calls onFinished() with true.
+  // Any process may write to the cache directory, so the file is hashed once before being recorded as verified.
+  // Runs in a worker thread: the cache may be locked by another process, or need a copy from another volume.
+  void retrieveInstallerFromSharedCache(UpdateInfo& update, std::function<void(bool const retrieved)> onFinished) {
+    cancelSharedCacheRetrieval();
+    if (!sharedCacheUsable(update)) {
+      onFinished(false);
+      return;
+    }
+
+    const auto& json = update.json;
+    const auto installerPath = QDir(downloadsDir).absoluteFilePath(json.installerUrl.fileName());
+    auto* watcher = new QFutureWatcher<bool>(&owner);
+    sharedCacheWatcher = watcher;
+    QObject::connect(watcher, &QFutureWatcher<bool>::finished, &owner,
+      [this, watcher, &update, installerPath, onFinished = std::move(onFinished)]() {
+        watcher->deleteLater();
+        sharedCacheWatcher = nullptr;
+        const auto retrieved = watcher->result();
+        if (retrieved) {
+#if UPDATER_ENABLE_DEBUG
+          qCDebug(CATEGORY_UPDATER) << "Installer retrieved from the shared cache @" << installerPath;
+#endif
+          update.installer = QFileInfo(installerPath);
+          recordInstallerVerification(update);
+        }
+        onFinished(retrieved);
+      });
+    watcher->setFuture(QtConcurrent::run(
+      [cacheDir = sharedCacheDirectory, downloadsDir = downloadsDir, installerPath, checksum = json.checksum,
+        checksumType = json.checksumType]() {
+        const auto key = sharedcache::key(checksum, checksumType);
+        if (!QDir().mkpath(downloadsDir) || !sharedcache::retrieve(cacheDir, key, installerPath)) {
+          return false;
+        }
+        if (!QtDownloader::verifyFileChecksum(
+              installerPath, checksum, checksumType, QtDownloader::InvalidChecksumBehavior::KeepFile)) {
+          // Not what its name says: it is removed, so that a verified installer can be stored instead.
+          QFile::remove(installerPath);
+          sharedcache::remove(cacheDir, key);
+          return false;
+        }
+        return true;
+      }));
+  }
+
+  // The worker can't be interrupted: its result is ignored. Returns true if a retrieval was running.
+  bool cancelSharedCacheRetrieval() {
+    if (!sharedCacheWatcher) {
+      return false;
+    }
+    QObject::disconnect(sharedCacheWatcher, nullptr, &owner, nullptr);
+    sharedCacheWatcher->deleteLater();
+    sharedCacheWatcher = nullptr;
+    return true;
+  }
+
+  void storeInstallerInSharedCache(const UpdateInfo& update) const {
+    if (!sharedCacheUsable(update) || !update.installerAlreadyVerified()) {
+      return;
+    }
+
+    const auto& json = update.json;
+    if (!sharedcache::store(sharedCacheDirectory, sharedcache::key(json.checksum, json.checksumType),
+          update.installer.absoluteFilePath(), sharedCacheSizeLimit)) {
+#if UPDATER_ENABLE_DEBUG
+      qCDebug(CATEGORY_UPDATER) << "Cannot store the installer in the shared cache";
+#endif
+    }
+  }
+
+  // Shares the verified installer with the peers of the local network.
+  void updatePeerSharing() {
+    const auto update = mostRecentUpdate();
+    if (!peerOptions.enabled || !update || !update->readyToInstall() || !update->installerAlreadyVerified()
+        || update->json.checksumType == QtDownloader::ChecksumType::NoChecksum) {
+      peerNetwork.unshareAll();
+      return;
+    }
+
+    const auto& json = update->json;
+    peerNetwork.share(sharedcache::key(json.checksum, json.checksumType), update->installer.absoluteFilePath(),
+      peerOptions.discoveryPort);
+  }
+
+  // Any machine of the local network may answer the discovery: the file of a peer is only accepted if a forgery
+  // would need a SHA-256 collision, with a SHA-256 checksum or with the block manifest.
+  bool peerSourceAllowed(const UpdateJSON& json) const {
+    const auto strongChecksum = (json.checksumType == QtDownloader::ChecksumType::SHA256
+                                  || json.checksumType == QtDownloader::ChecksumType::SHA256_TREE)
+                                && !json.checksum.isEmpty();
+    return strongChecksum || installerBlockManifest.isValid();
+  }
+
+  // The installer URL and its mirrors. Mirrors must have the same file name, as the file is named after the URL.
+  static QVector<UpdateJSON::Mirror> installerMirrors(const UpdateJSON& json) {
+    QVector<UpdateJSON::Mirror> result{ { json.installerUrl, 1. } };
+    for (const auto& mirror : json.mirrors) {
+      if (mirror.url == json.installerUrl) {
+        result.first().weight = mirror.weight;
+      } else if (mirror.url.fileName() == json.installerUrl.fileName()) {
+        result.append(mirror);
+      }
+    }
+    return result;
+  }
+
+  QString fastestMirrorSettingsKey() const {
+    return QString(SETTINGS_KEY_FASTESTMIRROR) + '/' + mirrors::networkId();
+  }
+
+  void saveFastestMirror(const QUrl& url) const {
+    QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+      settingsParameters.application);
+    saveSetting(settings, fastestMirrorSettingsKey(), url.toString());
+  }
+
+  // Selects the mirror to download the installer from: the one that was the fastest on this network, or else
+  // the first one to send data. Calls back with the other mirrors, to fail over to.
+  void selectInstallerMirror(
+    QtDownloader& source, const std::function<void(const QUrl&, const QVector<QUrl>&)>& onSelected) {
+    const auto candidates = installerMirrors(onlineUpdateInfo.json);
+    const auto select = [candidates, onSelected](const QUrl& url) {
+      onSelected(url, mirrors::fallbacks(candidates, url));
+    };
+    if (candidates.size() == 1) {
+      select(candidates.first().url);
+      return;
+    }
+
+    QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+      settingsParameters.application);
+    const auto fastestMirror = QUrl(loadSetting<QString>(settings, fastestMirrorSettingsKey()));
+    QVector<QUrl> racedUrls;
+    for (const auto& candidate : candidates) {
+      if (candidate.url == fastestMirror) {
+        select(fastestMirror);
+        return;
+      }
+      if (candidate.weight > 0.) {
+        racedUrls.append(candidate.url);
+      }
+    }
+
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Racing" << racedUrls.size() << "installer mirrors...";
+#endif
+    mirrors::race(racedUrls, source.networkAccessManager(), owner, MIRROR_RACE_TIMEOUT,
+      [candidates, select](const QUrl& url) {
+        select(url.isValid() ? url : mirrors::pickWeighted(candidates));
+      });
+  }
+
+  // Downloads the block manifest of the online installer, if any, then calls 'onFetched' (with NoError, unless
+  // cancelled). The manifest is optional: the installer is downloaded without it if it can't be used.
+  void fetchInstallerBlockManifest(
+    QtDownloader& source, const std::function<void(QtDownloader::ErrorCode const)>& onFetched) {
+    installerBlockManifest = {};
+    const auto& blockManifestUrl = onlineUpdateInfo.json.blockManifestUrl;
+    if (blockManifestUrl.isEmpty()) {
+      onFetched(QtDownloader::ErrorCode::NoError);
+      return;
+    }
+
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Downloading block manifest @" << blockManifestUrl.toString() << "...";
+#endif
+    source.downloadData(
+      blockManifestUrl,
+      [this, onFetched](QtDownloader::ErrorCode const errorCode, const QByteArray& data) {
+        if (errorCode == QtDownloader::ErrorCode::Cancelled) {
+          onFetched(errorCode);
+          return;
+        }
+
+        auto manifest = errorCode == QtDownloader::ErrorCode::NoError ? QtDownloader::BlockManifest::fromJSON(data)
+                                                                      : QtDownloader::BlockManifest{};
+        // With a tree hash checksum, the manifest must match the checksum.
+        const auto& json = onlineUpdateInfo.json;
+        if (manifest.isValid() && json.checksumType == QtDownloader::ChecksumType::SHA256_TREE
+            && manifest.rootHash().toHex() != json.checksum.toLower()) {
+          manifest = {};
+        }
+#if UPDATER_ENABLE_DEBUG
+        if (!manifest.isValid()) {
+          qCDebug(CATEGORY_UPDATER) << "Block manifest is unavailable or invalid";
+        }
+#endif
+        installerBlockManifest = manifest;
+        onFetched(QtDownloader::ErrorCode::NoError);
+      },
+      nullptr, checkTimeout);
+  }
+
+  // Downloads the installer from a peer of the local network that has it, if any. Falls back to the server if
+  // no peer answers, or if the peer fails or sends an invalid file.
+  void downloadInstallerFile(QtDownloader& source, const std::function<bool()>& isCancelled,
+    const QtDownloader::FileFinishedCallback& onFinished, const QtDownloader::ProgressCallback& onProgress) {
+    const auto& json = onlineUpdateInfo.json;
+    // The download may start after a peer discovery: the prefetch may have been paused meanwhile.
+    const auto startDownload = [this, &source](const QUrl& url,
+                                 const QtDownloader::FileFinishedCallback& onDownloadFinished,
+                                 const QtDownloader::ProgressCallback& onDownloadProgress) {
+      source.setBlockManifest(installerBlockManifest);
+      source.downloadFile(url, downloadsDir, onDownloadFinished, onDownloadProgress, checkTimeout);
+      if (&source == &prefetchDownloader) {
+        updatePrefetchPause();
+      }
+    };
+    // The mirror that sent the end of the installer is used first for the next downloads on this network.
+    const auto fromServer = [this, &source, startDownload, isCancelled, onFinished, onProgress]() {
+      selectInstallerMirror(source,
+        [this, &source, startDownload, isCancelled, onFinished, onProgress](
+          const QUrl& url, const QVector<QUrl>& fallbackUrls) {
+          if (isCancelled()) {
+            onFinished(QtDownloader::ErrorCode::Cancelled, {});
+            return;
+          }
+#if UPDATER_ENABLE_DEBUG
+          if (!fallbackUrls.isEmpty()) {
+            qCDebug(CATEGORY_UPDATER) << "Installer mirror selected @" << url.toString();
+          }
+#endif
+          source.setMirrorUrls(fallbackUrls);
+          startDownload(
+            url,
+            [this, &source, hasMirrors = !fallbackUrls.isEmpty(), onFinished](
+              QtDownloader::ErrorCode const errorCode, const QString& filePath) {
+              if (errorCode == QtDownloader::ErrorCode::NoError && hasMirrors) {
+                saveFastestMirror(source.transferMetrics().url);
+              }
+              onFinished(errorCode, filePath);
+            },
+            onProgress);
+        });
+    };
+    if (!peerOptions.enabled || !peerSourceAllowed(json)) {
+      fromServer();
+      return;
+    }
+
+    const auto key = sharedcache::key(json.checksum, json.checksumType);
+    peerNetwork.find(key, peerOptions.discoveryAddress, peerOptions.discoveryPort, peerOptions.discoveryTimeout,
+      [this, startDownload, isCancelled, fromServer, onFinished, onProgress](const QUrl& peerUrl) {
+        if (isCancelled()) {
+          onFinished(QtDownloader::ErrorCode::Cancelled, {});
+          return;
+        }
+        if (!peerUrl.isValid()) {
+          fromServer();
+          return;
+        }
+
+#if UPDATER_ENABLE_DEBUG
+        qCDebug(CATEGORY_UPDATER) << "Downloading installer from a peer @" << peerUrl.toString() << "...";
+#endif
+        startDownload(
+          peerUrl,
+          [this, fromServer, onFinished](QtDownloader::ErrorCode const errorCode, const QString& filePath) {
+            if (errorCode == QtDownloader::ErrorCode::Cancelled) {
+              onFinished(errorCode, filePath);
+              return;
+            }
+            if (errorCode != QtDownloader::ErrorCode::NoError) {
+#if UPDATER_ENABLE_DEBUG
+              qCDebug(CATEGORY_UPDATER) << "Installer from the peer is unavailable";
+#endif
+              fromServer();
+              return;
+            }
+
+            onlineUpdateInfo.installer = QFileInfo(filePath);
+            onlineUpdateInfo.verifiedInstaller = {};
+            verifyInstaller(onlineUpdateInfo,
+              [this, fromServer, onFinished, filePath](std::optional<bool> const checksumIsValid) {
+                if (!checksumIsValid) {
+                  onFinished(QtDownloader::ErrorCode::Cancelled, filePath);
+                } else if (*checksumIsValid) {
+                  installerVerifiedFromPeer = true;
+                  onFinished(QtDownloader::ErrorCode::NoError, filePath);
+                } else {
+#if UPDATER_ENABLE_DEBUG
+                  qCDebug(CATEGORY_UPDATER) << "Installer from the peer is invalid";
+#endif
+                  fromServer();
+                }
+              });
+          },
+          onProgress);
+      });
+  }
+
+  // The cache is also written when the binary cache is disabled if the installer is verified, to remember it.
+  void saveCache(const UpdateInfo& update) const {
+    if (!update.isValid() || (!binaryCacheEnabled && !update.installerAlreadyVerified())) {
+      return;
+    }
+
+    UpdateCache cache;
+    cache.json = update.json;
+    cache.changelog = FileStamp::fromFile(update.changelog.absoluteFilePath());
+    if (update.installerAlreadyVerified()) {
+      cache.installer = update.verifiedInstaller;
+      cache.verifiedChecksum = update.json.checksum.toLower();
+    } else {
+      cache.installer = FileStamp::fromFile(update.installer.absoluteFilePath());
+    }
+
+    if (!cache.saveToFile(downloadsDir)) {
+#if UPDATER_ENABLE_DEBUG
+      qCDebug(CATEGORY_UPDATER) << "Cannot write update cache";
+#endif
+    }
+  }
+
+  // Keeps the changelog of the previously downloaded update in memory, if the server can send only what's newer.
+  void keepPreviousChangelog() {
+    previousChangelogVersion = {};
+    previousChangelog.clear();
+
+    if (!onlineUpdateInfo.json.changelogDelta || !localUpdateInfo.readyToDisplayChangelog()) {
+      return;
+    }
+
+    const auto currentVersionNumber = QVersionNumber::fromString(currentVersion);
+    const auto& localVersion = localUpdateInfo.json.version;
+    const auto isBetween = QVersionNumber::compare(currentVersionNumber, localVersion) < 0
+                           && QVersionNumber::compare(localVersion, onlineUpdateInfo.json.version) < 0;
+    if (!isBetween) {
+      return;
+    }
+
+    QFile file(localUpdateInfo.changelog.absoluteFilePath());
+    if (file.open(QIODevice::ReadOnly)) {
+      previousChangelog = file.readAll();
+      previousChangelogVersion = localVersion;
+    }
+  }
+
+  QUrl changelogUrl() const {
+    auto url = onlineUpdateInfo.json.changelogUrl;
+    if (onlineUpdateInfo.json.changelogDelta && !url.isEmpty()) {
+      const auto since = previousChangelogVersion.isNull() ? currentVersion : previousChangelogVersion.toString();
+      QUrlQuery query(url);
+      query.removeAllQueryItems(CHANGELOG_QUERY_SINCE);
+      query.addQueryItem(CHANGELOG_QUERY_SINCE, since);
+      url.setQuery(query);
+    }
+    return url;
+  }
+
+  // Merges the downloaded fragment with the previous changelog, in a worker thread, then finishes the download.
+  void mergeChangelog(const QString& filePath, bool const prefetched = false) {
+    if (previousChangelog.isEmpty()) {
+      onDownloadChangelogFinished(filePath, prefetched);
+      return;
+    }
+
+    const auto previous = previousChangelog;
+    const auto sinceVersion = QVersionNumber::fromString(currentVersion);
+    previousChangelog.clear();
+    previousChangelogVersion = {};
+
+    auto* watcher = new QFutureWatcher<void>(&owner);
+    changelogMergeWatcher = watcher;
+    changelogMergePrefetched = prefetched;
+    QObject::connect(watcher, &QFutureWatcher<void>::finished, &owner, [this, watcher, filePath, prefetched]() {
+      watcher->deleteLater();
+      changelogMergeWatcher = nullptr;
+      onDownloadChangelogFinished(filePath, prefetched);
+    });
+    watcher->setFuture(QtConcurrent::run([filePath, previous, sinceVersion]() {
+      QFile file(filePath);
+      if (!file.open(QIODevice::ReadOnly)) {
+        return;
+      }
+      const auto fragment = QString::fromUtf8(file.readAll());
+      file.close();
+
+      const auto older = changelog::filterSince(QString::fromUtf8(previous), sinceVersion);
+      QSaveFile mergedFile(filePath);
+      if (mergedFile.open(QIODevice::WriteOnly)) {
+        mergedFile.write(changelog::merge(fragment, older).toUtf8());
+        fileutils::commitDurably(mergedFile);
+      }
+    }));
+  }
+
+  // Stops waiting for the merge of the changelog: the download won't finish. Returns false if no merge is running.
+  bool cancelChangelogMerge() {
+    if (!changelogMergeWatcher) {
+      return false;
+    }
+
+    // The worker only writes the downloaded file, which is not used anymore.
+    QObject::disconnect(changelogMergeWatcher, nullptr, &owner, nullptr);
+    changelogMergeWatcher->deleteLater();
+    changelogMergeWatcher = nullptr;
+    if (changelogMergePrefetched) {
+      setPrefetchStage(PrefetchStage::None);
+    }
+    return true;
+  }
+
+  void loadHostStatistics(QSettings& settings) {
+    settings.beginGroup(SETTINGS_GROUP_HOSTSTATISTICS);
+    for (const auto& key : settings.childKeys()) {
+      const auto values = settings.value(key).toString().split(',');
+      if (values.size() != 2) {
+        continue;
+      }
+      QtDownloader::HostStatistics statistics;
+      statistics.timeToFirstByte = values.at(0).toDouble();
+      statistics.consecutiveFailures = values.at(1).toInt();
+      hostStatistics->insert(QString::fromUtf8(QByteArray::fromPercentEncoding(key.toLatin1())), statistics);
+    }
+    settings.endGroup();
+  }
+
+  void saveHostStatistics(const QString& host) const {
+    if (!hostStatistics->contains(host)) {
+      return;
+    }
+
+    const auto& statistics = hostStatistics->value(host);
+    QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+      settingsParameters.application);
+    settings.beginGroup(SETTINGS_GROUP_HOSTSTATISTICS);
+    settings.setValue(QString::fromLatin1(host.toUtf8().toPercentEncoding()),
+      QString::number(statistics.timeToFirstByte) + ',' + QString::number(statistics.consecutiveFailures));
+    settings.endGroup();
+  }
+
+  // Percentile of the previous check durations, or the initial delay if not enough checks are measured.
+  int hedgingDelay() const {
+    if (checkDurations.size() < HEDGING_MIN_SAMPLES) {
+      return hedgingOptions.initialDelay;
+    }
+
+    auto sortedDurations = checkDurations;
+    std::sort(sortedDurations.begin(), sortedDurations.end());
+    const auto percentile = std::clamp(hedgingOptions.percentile, 0., 1.);
+    const auto rank = static_cast<int>(std::ceil(percentile * sortedDurations.size())) - 1;
+    const auto duration = sortedDurations.at(std::clamp(rank, 0, sortedDurations.size() - 1));
+    return static_cast<int>(std::clamp<qint64>(
+      duration, hedgingOptions.minDelay, std::max(hedgingOptions.minDelay, hedgingOptions.maxDelay)));
+  }
+
+  void recordCheckDuration(qint64 const duration) {
+    if (duration < 0) {
+      return;
+    }
+
+    checkDurations.append(duration);
+    while (checkDurations.size() > CHECK_DURATION_SAMPLES) {
+      checkDurations.removeFirst();
+    }
+
+    QStringList values;
+    for (const auto value : checkDurations) {
+      values.append(QString::number(value));
+    }
+    QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+      settingsParameters.application);
+    saveSetting(settings, SETTINGS_KEY_CHECKDURATIONS, values.join(','));
+  }
+
+  // The server URL may also be a local path or a file: URL, to the appcast or to a directory that contains it
+  // (e.g. a file share or a removable drive, for machines without network access).
+  static QUrl appcastUrl(const QString& url) {
+    auto result = QDir::isAbsolutePath(url) ? QUrl::fromLocalFile(url) : QUrl(url);
+    if (result.isLocalFile() && QFileInfo(result.toLocalFile()).isDir()) {
+      result = QUrl::fromLocalFile(QDir(result.toLocalFile()).absoluteFilePath(LOCAL_APPCAST_FILE_NAME));
+    }
+    return result;
+  }
+
+  // Sends the appcast request. With hedging, a second request is sent if it is slower than usual.
+  void requestAppcast() {
+    const auto requestId = ++checkRequestId;
+    pendingCheckRequests = 1;
+    checkClock.start();
+    downloader.downloadData(
+      appcastUrl(serverUrl),
+      [this, requestId](QtDownloader::ErrorCode const errorCode, const QByteArray& data) {
+        onAppcastReply(downloader, requestId, errorCode, data);
+      },
+      [this](int const percentage) {
+        emit owner.checkForUpdateProgressChanged(percentage);
+      },
+      checkTimeout);
+
+    if (hedgingOptions.enabled && pendingCheckRequests > 0) {
+      hedgeTimer.start(hedgingDelay());
+    }
+  }
+
+  void sendHedgedAppcastRequest() {
+    if (state != State::CheckingForUpdate || pendingCheckRequests == 0 || hedgeDownloader.isDownloading()) {
+      return;
+    }
+
+    const auto& alternateServerUrls = hedgingOptions.alternateServerUrls;
+    const auto url = alternateServerUrls.isEmpty()
+                       ? serverUrl
+                       : alternateServerUrls.at(nextAlternateServerUrl++ % alternateServerUrls.size());
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Checking for updates is slow: hedging @" << url << "...";
+#endif
+    ++pendingCheckRequests;
+    hedgeDownloader.downloadData(
+      appcastUrl(url),
+      [this, requestId = checkRequestId](QtDownloader::ErrorCode const errorCode, const QByteArray& data) {
+        onAppcastReply(hedgeDownloader, requestId, errorCode, data);
+      },
+      nullptr, checkTimeout);
+  }
+
+  // The first valid answer is used, and the other request is cancelled.
+  void onAppcastReply(
+    QtDownloader& source, int const requestId, QtDownloader::ErrorCode const errorCode, const QByteArray& data) {
+    if (requestId != checkRequestId) {
+      return;
+    }
+
+    --pendingCheckRequests;
+    const auto cancelled = errorCode == QtDownloader::ErrorCode::Cancelled;
+    const auto valid = errorCode == QtDownloader::ErrorCode::NoError && UpdateJSON{ data }.isValid();
+    if (!valid && !cancelled && pendingCheckRequests > 0) {
+      // The other request may still answer.
+      return;
+    }
+
+    ++checkRequestId;
+    pendingCheckRequests = 0;
+    hedgeTimer.stop();
+    for (auto* other : { &downloader, &hedgeDownloader }) {
+      if (other != &source && other->isDownloading()) {
+        other->cancel();
+      }
+    }
+    if (valid) {
+      // When the second request wins, the first one lasted at least until then.
+      recordCheckDuration(&source == &downloader ? source.transferMetrics().totalTime : checkClock.elapsed());
+    }
+
+    notifyTransferMetrics(source);
+    if (errorCode != QtDownloader::ErrorCode::NoError) {
+      emit owner.checkForUpdateOnlineFailed();
+    }
+    onCheckForUpdateFinished(data, source.transferMetrics().url, cancelled, mapError(errorCode));
+  }
+
+  void notifyTransferMetrics() {
+    notifyTransferMetrics(downloader);
+  }
+
+  void notifyTransferMetrics(const QtDownloader& source) {
+    const auto& metrics = source.transferMetrics();
+    if (source.timeoutPolicy().enabled) {
+      saveHostStatistics(metrics.url.host());
+    }
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Transfer @" << metrics.url.toString() << "-" << metrics.bytesDecoded << "bytes in"
+                              << metrics.totalTime << "ms - TTFB:" << metrics.timeToFirstByte << "ms";
+#endif
+    emit owner.transferMetricsAvailable(metrics);
   }
 
   void notifyUpdateAvailable(const bool newUpdateAvailable) {
@@ -469,7 +1518,7 @@ struct QtUpdater::Impl {
     emit owner.updateAvailabilityChanged();
   };
 
-  void onCheckForUpdateFinished(const QByteArray& data, bool cancelled, ErrorCode errorCode) {
+  void onCheckForUpdateFinished(const QByteArray& data, const QUrl& sourceUrl, bool cancelled, ErrorCode errorCode) {
     if (cancelled) {
       onlineUpdateInfo = {};
       localUpdateInfo = {};
@@ -479,8 +1528,9 @@ struct QtUpdater::Impl {
     }
 
     // Save online info.
-    const auto downloadedJSON = UpdateJSON{ data };
-    onlineUpdateInfo = UpdateInfo{ downloadedJSON, {}, {}, {} };
+    auto downloadedJSON = UpdateJSON{ data };
+    downloadedJSON.resolveUrls(sourceUrl);
+    onlineUpdateInfo = UpdateInfo{ downloadedJSON, {}, {} };
 
     // Check for previously downloaded update, locally.
 #if UPDATER_ENABLE_DEBUG
@@ -494,79 +1544,394 @@ struct QtUpdater::Impl {
     const auto update = mostRecentUpdate();
     if (!update) {
 #if UPDATER_ENABLE_DEBUG
-      qDebug(CATEGORY_UPDATER) << "No update available";
+      qDebug(CATEGORY_UPDATER) << "No update available";
+#endif
+      emit owner.checkForUpdateFailed(errorCode);
+      notifyUpdateAvailable(false);
+      return;
+    }
+
+    // If the most recent is the one from the server,
+    // wipe existing files because there are obsolete.
+    if (update == &onlineUpdateInfo) {
+      keepPreviousChangelog();
+      oclero::clearDirectoryContent(downloadsDir);
+
+      // Write downloaded JSON to disk.
+      const auto [success, saveJSONFilePath] = update->json.saveToFile(downloadsDir);
+      if (!success) {
+        emit owner.checkForUpdateFailed(ErrorCode::DiskError);
+        notifyUpdateAvailable(false);
+        return;
+      }
+
+      QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+        settingsParameters.application);
+      saveSetting(settings, SETTINGS_KEY_LASTUPDATEJSON, saveJSONFilePath);
+      saveCache(*update);
+    }
+
+    // Compare version numbers.
+    const auto currentVersionNumber = QVersionNumber::fromString(currentVersion);
+    const auto& newVersion = update->json.version;
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Current:" << currentVersion << "- Latest:" << newVersion;
+#endif
+
+    // An update is available if the version is superior to the previous one.
+    const auto newUpdateAvailable = QVersionNumber::compare(currentVersionNumber, newVersion) < 0;
+
+    // Signals for GUI.
+    notifyUpdateAvailable(newUpdateAvailable);
+
+    if (newUpdateAvailable) {
+      startPrefetch();
+    }
+  }
+
+  void onDownloadChangelogFinished(const QString& filePath, bool const prefetched = false) {
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Changelog downloaded @" << filePath;
+#endif
+    // A check for update started meanwhile.
+    if (prefetched && prefetchStage != PrefetchStage::Changelog) {
+      return;
+    }
+
+    onlineUpdateInfo.changelog = QFileInfo(filePath);
+    saveCache(onlineUpdateInfo);
+
+    // Content will be notified with latestChangelogChanged() once decoded.
+    resetChangelog();
+    loadChangelog(onlineUpdateInfo.changelog.absoluteFilePath());
+
+    if (!prefetched || prefetchPromoted) {
+      setState(State::Idle);
+      emit owner.changelogDownloadFinished();
+    }
+    emit owner.changelogAvailableChanged();
+
+    if (prefetched) {
+      prefetchNext();
+    }
+  }
+
+  // The download (or the prefetch) lasts until the installer is verified, in a worker thread.
+  // Silent when the installer is prefetched, unless the user asked for it meanwhile: it is only notified as available.
+  void onDownloadInstallerFinished(const QString& filePath, bool const prefetched = false) {
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Installer downloaded @" << filePath;
+#endif
+    onlineUpdateInfo.installer = QFileInfo(filePath);
+    const auto onVerified = [this, prefetched](std::optional<bool> const checksumIsValid) {
+      const auto notifyDownload = !prefetched || prefetchPromoted;
+      if (prefetched) {
+        setPrefetchStage(PrefetchStage::None);
+      }
+      // Cancelled: the state is already Idle.
+      if (!checksumIsValid) {
+        if (notifyDownload) {
+          emit owner.installerDownloadCancelled();
+        }
+        return;
+      }
+      if (notifyDownload) {
+        setState(State::Idle);
+      }
+
+      if (!*checksumIsValid) {
+        if (notifyDownload) {
+          emit owner.installerDownloadFailed(ErrorCode::ChecksumError);
+        }
+        return;
+      }
+#if UPDATER_ENABLE_DEBUG
+      qCDebug(CATEGORY_UPDATER) << "Checksum is valid";
+#endif
+      saveCache(onlineUpdateInfo);
+      storeInstallerInSharedCache(onlineUpdateInfo);
+
+      if (notifyDownload) {
+        emit owner.installerDownloadFinished();
+      }
+      emit owner.installerAvailableChanged();
+    };
+
+    if (std::exchange(installerVerifiedFromPeer, false)) {
+      onVerified(true);
+      return;
+    }
+    onlineUpdateInfo.verifiedInstaller = {};
+    verifyInstaller(onlineUpdateInfo, onVerified);
+  }
+
+  void onInstallerDownloadResult(QtDownloader::ErrorCode const errorCode, const QString& filePath) {
+    if (errorCode == QtDownloader::ErrorCode::NoError) {
+      onDownloadInstallerFinished(filePath);
+      return;
+    }
+
+    setState(State::Idle);
+    if (errorCode == QtDownloader::ErrorCode::Cancelled) {
+      emit owner.installerDownloadCancelled();
+    } else {
+      emit owner.installerDownloadFailed(mapError(errorCode));
+    }
+  }
+
+  void onInstallerDownloadProgress(const QtDownloader& source, int const percentage) {
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Downloading installer..." << percentage << "%";
+#endif
+    emit owner.installerDownloadProgressChanged(percentage);
+    const auto& progress = source.progress();
+    emit owner.installerDownloadProgressDetailsChanged(
+      progress.bytesReceived, progress.bytesTotal, progress.bytesPerSecond, progress.remainingTime);
+  }
+
+  // Downloads the installer in the DownloadingInstaller state, unless another updater already put it in the
+  // shared cache.
+  void downloadInstaller() {
+    const auto& url = onlineUpdateInfo.json.installerUrl;
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Downloading installer @" << url.toString() << "...";
+#endif
+
+    if (!url.isValid()) {
+      setState(State::Idle);
+      emit owner.installerDownloadFailed(ErrorCode::UrlError);
+      return;
+    }
+    const auto download = [this]() {
+      downloadInstallerFile(
+        downloader,
+        [this]() {
+          return state != State::DownloadingInstaller;
+        },
+        [this](QtDownloader::ErrorCode const errorCode, const QString& filePath) {
+          notifyTransferMetrics();
+          onInstallerDownloadResult(errorCode, filePath);
+        },
+        [this](int const percentage) {
+          onInstallerDownloadProgress(downloader, percentage);
+        });
+    };
+
+    // Maybe already downloaded by another updater.
+    retrieveInstallerFromSharedCache(onlineUpdateInfo, [this, download](bool const retrieved) {
+      if (retrieved) {
+        setState(State::Idle);
+        emit owner.installerDownloadFinished();
+        emit owner.installerAvailableChanged();
+        return;
+      }
+
+      fetchInstallerBlockManifest(downloader, [this, download](QtDownloader::ErrorCode const errorCode) {
+        if (errorCode == QtDownloader::ErrorCode::Cancelled) {
+          setState(State::Idle);
+          emit owner.installerDownloadCancelled();
+          return;
+        }
+        download();
+      });
+    });
+  }
+
+  void setPrefetchStage(PrefetchStage const stage) {
+    const auto wasPrefetching = prefetchStage != PrefetchStage::None;
+    prefetchStage = stage;
+    if (stage == PrefetchStage::None) {
+      prefetchPromoted = false;
+      busyProbe.stop();
+      eventLoopBusy = false;
+    } else if (!busyProbe.isActive()) {
+      lastBusyProbeTime = busyClock.elapsed();
+      busySamples = 0;
+      busyProbe.start();
+    }
+
+    if (wasPrefetching != (stage != PrefetchStage::None)) {
+      emit owner.prefetchingChanged();
+    }
+  }
+
+  // Starts downloading the changelog, then the installer, in the background, if an update is available.
+  void startPrefetch() {
+    if (!prefetchEnabled || prefetchStage != PrefetchStage::None || !onlineUpdateInfo.isValid()
+        || updateAvailability() != UpdateAvailability::Available) {
+      return;
+    }
+    prefetchNext();
+  }
+
+  void prefetchNext() {
+    prefetchPromoted = false;
+    const auto changelogNeeded = !onlineUpdateInfo.readyToDisplayChangelog() && changelogUrl().isValid()
+                                 && state != State::DownloadingChangelog;
+    const auto installerNeeded = !onlineUpdateInfo.readyToInstall() && onlineUpdateInfo.json.installerUrl.isValid()
+                                 && state != State::DownloadingInstaller;
+    if (changelogNeeded) {
+      prefetchChangelog();
+    } else if (installerNeeded) {
+      prefetchInstaller();
+    } else {
+      setPrefetchStage(PrefetchStage::None);
+    }
+  }
+
+  void prefetchChangelog() {
+#if UPDATER_ENABLE_DEBUG
+    qCDebug(CATEGORY_UPDATER) << "Prefetching changelog...";
 #endif
-      emit owner.checkForUpdateFailed(errorCode);
-      notifyUpdateAvailable(false);
-      return;
-    }
+    setPrefetchStage(PrefetchStage::Changelog);
+    prefetchDownloader.setBandwidthLimit(prefetchBandwidthLimit);
+    prefetchDownloader.downloadFile(
+      changelogUrl(), downloadsDir,
+      [this](QtDownloader::ErrorCode const errorCode, const QString& filePath) {
+        notifyTransferMetrics(prefetchDownloader);
+        if (errorCode == QtDownloader::ErrorCode::NoError) {
+          mergeChangelog(filePath, true);
+          return;
+        }
 
-    // If the most recent is the one from the server,
-    // wipe existing files because there are obsolete.
-    if (update == &onlineUpdateInfo) {
-      oclero::clearDirectoryContent(downloadsDir);
+        // A failed prefetch is silent, unless the user asked for the changelog meanwhile.
+        const auto promoted = prefetchPromoted;
+        setPrefetchStage(PrefetchStage::None);
+        if (promoted) {
+          setState(State::Idle);
+          if (errorCode == QtDownloader::ErrorCode::Cancelled) {
+            emit owner.changelogDownloadCancelled();
+          } else {
+            emit owner.changelogDownloadFailed(mapError(errorCode));
+          }
+        }
+      },
+      [this](int const percentage) {
+        if (prefetchPromoted) {
+          emit owner.changelogDownloadProgressChanged(percentage);
+        }
+      },
+      checkTimeout);
+    updatePrefetchPause();
+  }
 
-      // Write downloaded JSON to disk.
-      const auto [success, saveJSONFilePath] = update->json.saveToFile(downloadsDir);
-      if (!success) {
-        emit owner.checkForUpdateFailed(ErrorCode::DiskError);
-        notifyUpdateAvailable(false);
+  void prefetchInstaller() {
+    setPrefetchStage(PrefetchStage::Installer);
+    retrieveInstallerFromSharedCache(onlineUpdateInfo, [this](bool const retrieved) {
+      if (!retrieved) {
+        downloadPrefetchedInstaller();
         return;
       }
 
-      QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
-        settingsParameters.application);
-      saveSetting(settings, SETTINGS_KEY_LASTUPDATEJSON, saveJSONFilePath);
-    }
+      const auto promoted = prefetchPromoted;
+      setPrefetchStage(PrefetchStage::None);
+      if (promoted) {
+        setState(State::Idle);
+        emit owner.installerDownloadFinished();
+      }
+      emit owner.installerAvailableChanged();
+    });
+  }
 
-    // Compare version numbers.
-    const auto currentVersionNumber = QVersionNumber::fromString(currentVersion);
-    const auto& newVersion = update->json.version;
+  void downloadPrefetchedInstaller() {
 #if UPDATER_ENABLE_DEBUG
-    qCDebug(CATEGORY_UPDATER) << "Current:" << currentVersion << "- Latest:" << newVersion;
+    qCDebug(CATEGORY_UPDATER) << "Prefetching installer...";
 #endif
+    // The user may have asked for the installer while it was looked for in the shared cache.
+    prefetchDownloader.setBandwidthLimit(prefetchPromoted ? 0 : prefetchBandwidthLimit);
+    const auto onFinished = [this](QtDownloader::ErrorCode const errorCode, const QString& filePath) {
+      notifyTransferMetrics(prefetchDownloader);
+      // Still prefetched while the installer is verified: cancelPrefetch() stops the verification.
+      if (errorCode == QtDownloader::ErrorCode::NoError) {
+        onDownloadInstallerFinished(filePath, true);
+        return;
+      }
 
-    // An update is available if the version is superior to the previous one.
-    const auto newUpdateAvailable = QVersionNumber::compare(currentVersionNumber, newVersion) < 0;
+      const auto promoted = prefetchPromoted;
+      setPrefetchStage(PrefetchStage::None);
+      if (promoted) {
+        onInstallerDownloadResult(errorCode, filePath);
+      }
+    };
+    fetchInstallerBlockManifest(prefetchDownloader, [this, onFinished](QtDownloader::ErrorCode const errorCode) {
+      if (errorCode == QtDownloader::ErrorCode::Cancelled) {
+        onFinished(errorCode, {});
+        return;
+      }
 
-    // Signals for GUI.
-    notifyUpdateAvailable(newUpdateAvailable);
+      downloadInstallerFile(
+        prefetchDownloader,
+        [this]() {
+          return prefetchStage != PrefetchStage::Installer;
+        },
+        onFinished,
+        [this](int const percentage) {
+          if (prefetchPromoted) {
+            onInstallerDownloadProgress(prefetchDownloader, percentage);
+          }
+        });
+    });
   }
 
-  void onDownloadChangelogFinished(const QString& filePath) {
+  // Makes the prefetch of the file visible to the user, as if it was a regular download. Returns false if
+  // this file is not being prefetched.
+  bool promotePrefetch(PrefetchStage const stage) {
+    if (prefetchStage != stage || prefetchPromoted) {
+      return false;
+    }
+
 #if UPDATER_ENABLE_DEBUG
-    qCDebug(CATEGORY_UPDATER) << "Changelog downloaded @" << filePath;
+    qCDebug(CATEGORY_UPDATER) << "Prefetch requested by the user";
 #endif
-    onlineUpdateInfo.changelog = QFileInfo(filePath);
-
-    setState(State::Idle);
-    emit owner.changelogDownloadFinished();
-    emit owner.changelogAvailableChanged();
-    emit owner.latestChangelogChanged();
+    prefetchPromoted = true;
+    prefetchDownloader.setBandwidthLimit(0);
+    updatePrefetchPause();
+    return true;
   }
 
-  void onDownloadInstallerFinished(const QString& filePath) {
-#if UPDATER_ENABLE_DEBUG
-    qCDebug(CATEGORY_UPDATER) << "Installer downloaded @" << filePath;
-#endif
-    onlineUpdateInfo.installer = QFileInfo(filePath);
+  void cancelPrefetch() {
+    if (prefetchStage == PrefetchStage::None) {
+      return;
+    }
 
-    const auto checksumIsValid =
-      QtDownloader::verifyFileChecksum(filePath, onlineUpdateInfo.json.checksum, onlineUpdateInfo.json.checksumType);
-    setState(State::Idle);
+    if (prefetchStage == PrefetchStage::Installer) {
+      cancelSharedCacheRetrieval();
+      cancelVerification();
+    }
+    setPrefetchStage(PrefetchStage::None);
+    prefetchDownloader.cancel();
+  }
 
-    if (!checksumIsValid) {
+  // The prefetch is paused when the application asks for it, or when the event loop is busy.
+  void updatePrefetchPause() {
+    const auto shouldPause = !prefetchPromoted && (prefetchPaused || eventLoopBusy);
+    if (shouldPause && !prefetchDownloader.isPaused()) {
 #if UPDATER_ENABLE_DEBUG
-      qCDebug(CATEGORY_UPDATER) << "Checksum is invalid";
+      qCDebug(CATEGORY_UPDATER) << "Prefetch paused";
 #endif
-      emit owner.installerDownloadFailed(ErrorCode::ChecksumError);
-      return;
-    }
+      prefetchDownloader.pause();
+    } else if (!shouldPause && prefetchDownloader.isPaused()) {
 #if UPDATER_ENABLE_DEBUG
-    qCDebug(CATEGORY_UPDATER) << "Checksum is valid";
+      qCDebug(CATEGORY_UPDATER) << "Prefetch resumed";
 #endif
-    emit owner.installerDownloadFinished();
-    emit owner.installerAvailableChanged();
+      prefetchDownloader.resume();
+    }
+  }
+
+  // Late timers in a row mean that the event loop is busy (e.g. the application is doing some work in the main
+  // thread). Pausing drops the connection, so isolated lags are ignored.
+  void onBusyProbe() {
+    const auto now = busyClock.elapsed();
+    const auto lag = now - lastBusyProbeTime - PREFETCH_BUSY_PROBE_INTERVAL;
+    lastBusyProbeTime = now;
+    busySamples = lag > PREFETCH_BUSY_LAG ? busySamples + 1 : 0;
+    if (busySamples >= PREFETCH_BUSY_SAMPLES) {
+      lastBusyTime = now;
+      eventLoopBusy = true;
+    } else if (eventLoopBusy && now - lastBusyTime >= PREFETCH_IDLE_DELAY) {
+      eventLoopBusy = false;
+    }
+    updatePrefetchPause();
   }
 };
 
@@ -586,6 +1951,8 @@ QtUpdater::ErrorCode mapError(QtDownloader::ErrorCode error) {
       return QtUpdater::ErrorCode::DiskError;
     case QtDownloader::ErrorCode::NetworkError:
       return QtUpdater::ErrorCode::NetworkError;
+    case QtDownloader::ErrorCode::BlockVerificationFailed:
+      return QtUpdater::ErrorCode::ChecksumError;
     default:
       return QtUpdater::ErrorCode::UnknownError;
   }
@@ -647,6 +2014,7 @@ void QtUpdater::setServerUrl(const QString& serverUrl) {
     emit serverUrlChanged();
 
     // Reset data.
+    _impl->cancelPrefetch();
     _impl->localUpdateInfo = {};
     _impl->onlineUpdateInfo = {};
     _impl->timer.stop();
@@ -667,6 +2035,17 @@ const QString& QtUpdater::currentVersion() const {
   return _impl->currentVersion;
 }
 
+void QtUpdater::setCurrentVersion(const QString& version) {
+  if (version != _impl->currentVersion) {
+    const auto previousAvailability = _impl->updateAvailability();
+    _impl->currentVersion = version;
+    emit currentVersionChanged();
+    if (_impl->updateAvailability() != previousAvailability) {
+      emit updateAvailabilityChanged();
+    }
+  }
+}
+
 const QDateTime& QtUpdater::currentVersionDate() const {
   return _impl->currentVersionDate;
 }
@@ -693,10 +2072,18 @@ QDateTime QtUpdater::latestVersionDate() const {
 
 const QString& QtUpdater::latestChangelog() const {
   static const QString fallback;
-  if (const auto update = const_cast<UpdateInfo*>(_impl->mostRecentUpdate())) {
-    return update->getChangelogContent();
+  const auto update = _impl->mostRecentUpdate();
+  if (!update || !update->readyToDisplayChangelog()) {
+    return fallback;
+  }
+
+  // Never block: if not loaded yet, start loading and return an empty string until latestChangelogChanged().
+  const auto path = update->changelog.absoluteFilePath();
+  if (path != _impl->changelogContentPath) {
+    _impl->loadChangelog(path);
+    return fallback;
   }
-  return fallback;
+  return _impl->changelogContent;
 }
 
 QtUpdater::State QtUpdater::state() const {
@@ -734,10 +2121,110 @@ void QtUpdater::setCheckTimeout(int timeout) {
   }
 }
 
+QtUpdater::Status QtUpdater::status() const {
+  Status result;
+  result.state = state();
+  result.updateAvailability = updateAvailability();
+  result.changelogAvailable = changelogAvailable();
+  result.installerAvailable = installerAvailable();
+  result.currentVersion = currentVersion();
+  result.currentVersionDate = currentVersionDate();
+  result.latestVersion = latestVersion();
+  result.latestVersionDate = latestVersionDate();
+  result.latestChangelog = latestChangelog();
+  return result;
+}
+
+void QtUpdater::requestStatus() {
+  emit statusChanged(status());
+}
+
+bool QtUpdater::prefetchEnabled() const {
+  return _impl->prefetchEnabled;
+}
+
+void QtUpdater::setPrefetchEnabled(bool enabled) {
+  if (enabled != _impl->prefetchEnabled) {
+    _impl->prefetchEnabled = enabled;
+    emit prefetchEnabledChanged();
+
+    if (enabled) {
+      _impl->startPrefetch();
+    } else if (!_impl->prefetchPromoted) {
+      _impl->cancelPrefetch();
+    }
+  }
+}
+
+qint64 QtUpdater::prefetchBandwidthLimit() const {
+  return _impl->prefetchBandwidthLimit;
+}
+
+void QtUpdater::setPrefetchBandwidthLimit(qint64 bytesPerSecond) {
+  if (bytesPerSecond != _impl->prefetchBandwidthLimit) {
+    _impl->prefetchBandwidthLimit = bytesPerSecond;
+    if (_impl->prefetchStage != Impl::PrefetchStage::None && !_impl->prefetchPromoted) {
+      _impl->prefetchDownloader.setBandwidthLimit(bytesPerSecond);
+    }
+    emit prefetchBandwidthLimitChanged();
+  }
+}
+
+bool QtUpdater::prefetchPaused() const {
+  return _impl->prefetchPaused;
+}
+
+void QtUpdater::setPrefetchPaused(bool paused) {
+  if (paused != _impl->prefetchPaused) {
+    _impl->prefetchPaused = paused;
+    _impl->updatePrefetchPause();
+    emit prefetchPausedChanged();
+  }
+}
+
+bool QtUpdater::prefetching() const {
+  return _impl->prefetchStage != Impl::PrefetchStage::None;
+}
+
 QtUpdater::InstallMode QtUpdater::installMode() const {
   return _impl->installMode;
 }
 
+const std::shared_ptr<QtInstallStrategy>& QtUpdater::installStrategy() const {
+  return _impl->installStrategy;
+}
+
+void QtUpdater::setInstallStrategy(const std::shared_ptr<QtInstallStrategy>& strategy) {
+  _impl->installStrategy = strategy;
+}
+
+const QtDownloader::TimeoutPolicy& QtUpdater::timeoutPolicy() const {
+  return _impl->downloader.timeoutPolicy();
+}
+
+void QtUpdater::setTimeoutPolicy(const QtDownloader::TimeoutPolicy& policy) {
+  _impl->downloader.setTimeoutPolicy(policy);
+  _impl->prefetchDownloader.setTimeoutPolicy(policy);
+  _impl->hedgeDownloader.setTimeoutPolicy(policy);
+}
+
+const QtDownloader::ProgressPolicy& QtUpdater::progressPolicy() const {
+  return _impl->downloader.progressPolicy();
+}
+
+void QtUpdater::setProgressPolicy(const QtDownloader::ProgressPolicy& policy) {
+  _impl->downloader.setProgressPolicy(policy);
+  _impl->prefetchDownloader.setProgressPolicy(policy);
+  _impl->hedgeDownloader.setProgressPolicy(policy);
+}
+
+void QtUpdater::setNetworkAccessManager(QNetworkAccessManager* manager) {
+  auto* const usedManager = manager ? manager : &_impl->networkAccessManager;
+  _impl->downloader.setNetworkAccessManager(usedManager);
+  _impl->prefetchDownloader.setNetworkAccessManager(usedManager);
+  _impl->hedgeDownloader.setNetworkAccessManager(usedManager);
+}
+
 void QtUpdater::setInstallMode(QtUpdater::InstallMode installMode) {
   if (installMode != _impl->installMode) {
     _impl->installMode = installMode;
@@ -756,14 +2243,127 @@ void QtUpdater::setInstallerDestinationDir(const QString& path) {
   }
 }
 
+bool QtUpdater::binaryCacheEnabled() const {
+  return _impl->binaryCacheEnabled;
+}
+
+void QtUpdater::setBinaryCacheEnabled(bool enabled) {
+  if (enabled != _impl->binaryCacheEnabled) {
+    _impl->binaryCacheEnabled = enabled;
+    emit binaryCacheEnabledChanged();
+  }
+}
+
+const QtUpdater::PeerOptions& QtUpdater::peerOptions() const {
+  return _impl->peerOptions;
+}
+
+void QtUpdater::setPeerOptions(const PeerOptions& options) {
+  _impl->peerOptions = options;
+  _impl->peerNetwork.unshareAll();
+  _impl->updatePeerSharing();
+}
+
+const QtUpdater::HedgingOptions& QtUpdater::hedgingOptions() const {
+  return _impl->hedgingOptions;
+}
+
+void QtUpdater::setHedgingOptions(const HedgingOptions& options) {
+  _impl->hedgingOptions = options;
+}
+
+const QString& QtUpdater::sharedCacheDirectory() const {
+  return _impl->sharedCacheDirectory;
+}
+
+void QtUpdater::setSharedCacheDirectory(const QString& path) {
+  if (path != _impl->sharedCacheDirectory) {
+    _impl->sharedCacheDirectory = path;
+    emit sharedCacheDirectoryChanged();
+  }
+}
+
+qint64 QtUpdater::sharedCacheSizeLimit() const {
+  return _impl->sharedCacheSizeLimit;
+}
+
+void QtUpdater::setSharedCacheSizeLimit(qint64 bytes) {
+  if (bytes != _impl->sharedCacheSizeLimit) {
+    _impl->sharedCacheSizeLimit = bytes;
+    emit sharedCacheSizeLimitChanged();
+  }
+}
+
+bool QtUpdater::paranoidVerification() const {
+  return _impl->paranoidVerification;
+}
+
+void QtUpdater::setParanoidVerification(bool enabled) {
+  if (enabled != _impl->paranoidVerification) {
+    _impl->paranoidVerification = enabled;
+    emit paranoidVerificationChanged();
+  }
+}
+
+qint64 QtUpdater::changelogSizeLimit() const {
+  return _impl->changelogSizeLimit;
+}
+
+void QtUpdater::setChangelogSizeLimit(qint64 bytes) {
+  if (bytes != _impl->changelogSizeLimit) {
+    _impl->changelogSizeLimit = bytes;
+    _impl->resetChangelog();
+    emit changelogSizeLimitChanged();
+    emit latestChangelogChanged();
+  }
+}
+
+bool QtUpdater::changelogSinceCurrentVersion() const {
+  return _impl->changelogSinceCurrentVersion;
+}
+
+void QtUpdater::setChangelogSinceCurrentVersion(bool enabled) {
+  if (enabled != _impl->changelogSinceCurrentVersion) {
+    _impl->changelogSinceCurrentVersion = enabled;
+    _impl->resetChangelog();
+    emit changelogSinceCurrentVersionChanged();
+    emit latestChangelogChanged();
+  }
+}
+
 void QtUpdater::cancel() {
   const auto currentState = state();
   if (currentState == State::Idle || currentState == State::InstallingUpdate)
     return;
 
+  // The changelog may be downloaded, and being merged with the previous one.
+  const auto mergeCancelled = currentState == State::DownloadingChangelog && _impl->cancelChangelogMerge();
+  // The installer may be retrieved from the shared cache, for a download or a promoted prefetch.
+  const auto retrievalCancelled =
+    currentState == State::DownloadingInstaller && _impl->cancelSharedCacheRetrieval();
+  if (retrievalCancelled && _impl->prefetchStage == Impl::PrefetchStage::Installer) {
+    _impl->setPrefetchStage(Impl::PrefetchStage::None);
+  }
+  // The hash stops at the next block. The installer is left as is. A downloaded installer is also verified
+  // before the download finishes.
+  if (currentState == State::VerifyingInstaller || currentState == State::DownloadingInstaller) {
+    _impl->cancelVerification();
+  }
+
   _impl->downloader.cancel();
+  _impl->hedgeDownloader.cancel();
+  if (_impl->prefetchPromoted) {
+    _impl->prefetchDownloader.cancel();
+  }
   _impl->state = State::Idle;
   emit stateChanged();
+
+  if (mergeCancelled) {
+    emit changelogDownloadCancelled();
+  }
+  if (retrievalCancelled) {
+    emit installerDownloadCancelled();
+  }
 }
 
 #pragma endregion
@@ -787,6 +2387,9 @@ void QtUpdater::forceCheckForUpdate() {
     return;
   }
 
+  // The downloaded files may be obsolete after the check.
+  _impl->cancelPrefetch();
+
   // Reset data.
   _impl->localUpdateInfo = {};
   _impl->onlineUpdateInfo = {};
@@ -803,23 +2406,10 @@ void QtUpdater::forceCheckForUpdate() {
   emit checkForUpdateStarted();
 
 #if UPDATER_ENABLE_DEBUG
-  qCDebug(CATEGORY_UPDATER) << "Checking for updates @" << url.toString() << "...";
+  qCDebug(CATEGORY_UPDATER) << "Checking for updates @" << _impl->serverUrl << "...";
 #endif
 
-  _impl->downloader.downloadData(
-    _impl->serverUrl,
-    [this](QtDownloader::ErrorCode const errorCode, const QByteArray& data) {
-      if (errorCode != QtDownloader::ErrorCode::NoError) {
-        emit checkForUpdateOnlineFailed();
-      }
-      const auto cancelled = errorCode == QtDownloader::ErrorCode::Cancelled;
-      const auto mappedErrorCode = mapError(errorCode);
-      _impl->onCheckForUpdateFinished(data, cancelled, mappedErrorCode);
-    },
-    [this](int const percentage) {
-      emit checkForUpdateProgressChanged(percentage);
-    },
-    _impl->checkTimeout);
+  _impl->requestAppcast();
 }
 
 void QtUpdater::downloadChangelog() {
@@ -827,6 +2417,13 @@ void QtUpdater::downloadChangelog() {
     return;
   }
 
+  // The changelog is already being downloaded in the background.
+  if (_impl->promotePrefetch(Impl::PrefetchStage::Changelog)) {
+    _impl->setState(State::DownloadingChangelog);
+    emit changelogDownloadStarted();
+    return;
+  }
+
   // Check if local changelog.
   if (!_impl->onlineUpdateInfo.isValid()) {
     if (_impl->localUpdateInfo.readyToDisplayChangelog()) {
@@ -837,7 +2434,7 @@ void QtUpdater::downloadChangelog() {
 
   _impl->setState(State::DownloadingChangelog);
   emit changelogDownloadStarted();
-  const auto& url = _impl->onlineUpdateInfo.json.changelogUrl;
+  const auto url = _impl->changelogUrl();
 
 #if UPDATER_ENABLE_DEBUG
   qCDebug(CATEGORY_UPDATER) << "Downloading changelog @" << url.toString() << "...";
@@ -852,8 +2449,9 @@ void QtUpdater::downloadChangelog() {
   _impl->downloader.downloadFile(
     url, dir,
     [this](QtDownloader::ErrorCode const errorCode, const QString& filePath) {
+      _impl->notifyTransferMetrics();
       if (errorCode == QtDownloader::ErrorCode::NoError) {
-        _impl->onDownloadChangelogFinished(filePath);
+        _impl->mergeChangelog(filePath);
       } else if (errorCode == QtDownloader::ErrorCode::Cancelled) {
         _impl->setState(State::Idle);
         emit changelogDownloadCancelled();
@@ -873,6 +2471,13 @@ void QtUpdater::downloadInstaller() {
     return;
   }
 
+  // The installer is already being downloaded in the background: it is not throttled anymore.
+  if (_impl->promotePrefetch(Impl::PrefetchStage::Installer)) {
+    _impl->setState(State::DownloadingInstaller);
+    emit installerDownloadStarted();
+    return;
+  }
+
   // Priority is given to server updates.
   if (!_impl->onlineUpdateInfo.isValid()) {
     // However, there might be a previously downloaded update, locally.
@@ -885,37 +2490,103 @@ void QtUpdater::downloadInstaller() {
   _impl->setState(State::DownloadingInstaller);
   emit installerDownloadStarted();
 
-  const auto& url = _impl->onlineUpdateInfo.json.installerUrl;
-
-#if UPDATER_ENABLE_DEBUG
-  qCDebug(CATEGORY_UPDATER) << "Downloading installer @" << url.toString() << "...";
-#endif
-
-  if (!url.isValid()) {
-    _impl->setState(State::Idle);
-    emit installerDownloadFailed(ErrorCode::UrlError);
+  // Already downloaded in the background: only verified again if it changed since, and downloaded again if invalid.
+  if (_impl->onlineUpdateInfo.readyToInstall()) {
+    _impl->verifyInstaller(_impl->onlineUpdateInfo, [this](std::optional<bool> const checksumIsValid) {
+      // Cancelled: the state is already Idle.
+      if (!checksumIsValid) {
+        emit installerDownloadCancelled();
+      } else if (*checksumIsValid) {
+        _impl->setState(State::Idle);
+        emit installerDownloadFinished();
+        emit installerAvailableChanged();
+      } else {
+        _impl->downloadInstaller();
+      }
+    });
     return;
   }
-  const auto& dir = _impl->downloadsDir;
-  _impl->downloader.downloadFile(
-    url, dir,
-    [this](QtDownloader::ErrorCode const errorCode, const QString& filePath) {
-      _impl->setState(State::Idle);
-      if (errorCode == QtDownloader::ErrorCode::NoError) {
-        _impl->onDownloadInstallerFinished(filePath);
-      } else if (errorCode == QtDownloader::ErrorCode::Cancelled) {
-        emit installerDownloadCancelled();
+  _impl->downloadInstaller();
+}
+
+QFuture<QtUpdater::ErrorCode> QtUpdater::checkForUpdateAsync(bool const force) {
+  if (state() != State::Idle || _impl->serverUrl.isEmpty()) {
+    return Impl::finishedFuture(std::nullopt);
+  }
+
+  return _impl->trackOperation(
+    [this, force]() {
+      if (force) {
+        forceCheckForUpdate();
       } else {
-        emit installerDownloadFailed(mapError(errorCode));
+        checkForUpdate();
       }
     },
-    [this](int const percentage) {
+    State::CheckingForUpdate, &QtUpdater::checkForUpdateFinished, &QtUpdater::checkForUpdateFailed,
+    &QtUpdater::checkForUpdateCancelled,
+    // Not started because the last check is recent enough.
+    []() -> std::optional<ErrorCode> {
+      return ErrorCode::NoError;
+    });
+}
+
+QFuture<QtUpdater::ErrorCode> QtUpdater::downloadChangelogAsync() {
+  if (state() != State::Idle) {
+    return Impl::finishedFuture(std::nullopt);
+  }
+
+  return _impl->trackOperation(
+    [this]() {
+      downloadChangelog();
+    },
+    State::DownloadingChangelog, &QtUpdater::changelogDownloadFinished, &QtUpdater::changelogDownloadFailed,
+    &QtUpdater::changelogDownloadCancelled,
+    // Nothing to download: succeeds only if there is a local changelog.
+    [this]() -> std::optional<ErrorCode> {
+      if (_impl->localUpdateInfo.readyToDisplayChangelog()) {
+        return ErrorCode::NoError;
+      }
+      return std::nullopt;
+    });
+}
+
+QFuture<QtUpdater::ErrorCode> QtUpdater::downloadInstallerAsync() {
+  if (state() != State::Idle) {
+    return Impl::finishedFuture(std::nullopt);
+  }
+
+  return _impl->trackOperation(
+    [this]() {
+      downloadInstaller();
+    },
+    State::DownloadingInstaller, &QtUpdater::installerDownloadFinished, &QtUpdater::installerDownloadFailed,
+    &QtUpdater::installerDownloadCancelled,
+    // Nothing to download: succeeds only if there is a local installer.
+    [this]() -> std::optional<ErrorCode> {
+      if (_impl->localUpdateInfo.readyToInstall()) {
+        return ErrorCode::NoError;
+      }
+      return std::nullopt;
+    });
+}
+
+QFuture<QtUpdater::ErrorCode> QtUpdater::verifyInstallerAsync() {
+  // A prefetched installer may replace the file while it is hashed.
+  if (state() != State::Idle || !_impl->installerAvailable()
+      || _impl->prefetchStage == Impl::PrefetchStage::Installer) {
+    return Impl::finishedFuture(std::nullopt);
+  }
+
+  // Should not be null because 'installerAvailable()' returned 'true'.
+  auto* const update = _impl->mostRecentUpdate();
+  if (!_impl->installerNeedsVerification(*update)) {
+    return Impl::finishedFuture(ErrorCode::NoError);
+  }
+
 #if UPDATER_ENABLE_DEBUG
-      qCDebug(CATEGORY_UPDATER) << "Downloading installer..." << percentage << "%";
+  qCDebug(CATEGORY_UPDATER) << "Verifying checksum in the background...";
 #endif
-      emit installerDownloadProgressChanged(percentage);
-    },
-    _impl->checkTimeout);
+  return _impl->verifyInstallerInBackground(*update);
 }
 
 void QtUpdater::installUpdate(const bool dry) {
@@ -929,7 +2600,9 @@ void QtUpdater::installUpdate(const bool dry) {
     emit installationFailed(error);
   };
 
-  if (state() != State::Idle || !_impl->installerAvailable()) {
+  // A prefetched installer may still be verified.
+  if (state() != State::Idle || !_impl->installerAvailable()
+      || _impl->prefetchStage == Impl::PrefetchStage::Installer) {
     raiseError(ErrorCode::UnknownError, "Installer not available");
     return;
   }
@@ -947,75 +2620,57 @@ void QtUpdater::installUpdate(const bool dry) {
     return;
   }
 
-  // Verify checksum before installing.
-  if (update->json.checksumType != QtDownloader::ChecksumType::NoChecksum) {
+  // Verify checksum before installing (skipped if the installer was already verified and is unchanged).
 #if UPDATER_ENABLE_DEBUG
-    qCDebug(CATEGORY_UPDATER) << "Verifying checksum...";
+  qCDebug(CATEGORY_UPDATER) << "Verifying checksum...";
 #endif
-    if (!QtDownloader::verifyFileChecksum(
-          update->installer.absoluteFilePath(), update->json.checksum, update->json.checksumType)) {
+  _impl->verifyInstaller(*update, [this, update, dry, raiseError](std::optional<bool> const checksumIsValid) {
+    // The installation can't be cancelled.
+    if (!checksumIsValid) {
+      return;
+    }
+    if (!*checksumIsValid) {
       raiseError(ErrorCode::ChecksumError, "Checksum is invalid");
+      _impl->setState(State::Idle);
       return;
-    } else {
-#if UPDATER_ENABLE_DEBUG
-      qCDebug(CATEGORY_UPDATER) << "Checksum is valid";
-#endif
     }
-  }
-
-  // For the tests, we don't stop the application.
-  if (dry) {
-    _impl->setState(State::Idle);
-    emit installationFinished();
-    return;
-  }
-
-  // Start installer in a separate process.
-  if (_impl->installMode == InstallMode::ExecuteFile) {
 #if UPDATER_ENABLE_DEBUG
-    qCDebug(CATEGORY_UPDATER) << "Starting installer...";
-#endif
-    auto installerProcessSuccess = false;
-#if defined(Q_OS_WIN)
-    installerProcessSuccess = QProcess::startDetached(update->installer.absoluteFilePath(), {});
-#elif defined(Q_OS_MAC)
-    installerProcessSuccess = QProcess::startDetached("open", { update->installer.absoluteFilePath() });
-#else
-    raiseError(ErrorCode::InstallerExecutionError, "OS not supported");
+    qCDebug(CATEGORY_UPDATER) << "Checksum is valid";
 #endif
-    if (!installerProcessSuccess) {
-      raiseError(ErrorCode::InstallerExecutionError, "Failed to start uninstaller");
+
+    // For the tests, we don't stop the application.
+    if (dry) {
       _impl->setState(State::Idle);
+      emit installationFinished();
       return;
     }
-#if UPDATER_ENABLE_DEBUG
-    qCDebug(CATEGORY_UPDATER) << "Installer started";
-#endif
 
-    // Quit the app.
-    if (_impl->installMode == InstallMode::ExecuteFile) {
-#if UPDATER_ENABLE_DEBUG
-      qCDebug(CATEGORY_UPDATER) << "App will quit to let the installer do the update";
-#endif
-      QCoreApplication::quit();
+    // The install strategy replaces the behavior of the install mode.
+    auto strategy = _impl->installStrategy;
+    if (!strategy) {
+      if (_impl->installMode == InstallMode::ExecuteFile) {
+        strategy = std::make_shared<QtExecuteFileInstallStrategy>();
+      } else {
+        strategy = std::make_shared<QtMoveFileInstallStrategy>(_impl->installerDestinationDir);
+      }
     }
-  } else if (_impl->installMode == InstallMode::MoveFileToDir && !_impl->installerDestinationDir.isEmpty()) {
+
 #if UPDATER_ENABLE_DEBUG
-    qCDebug(CATEGORY_UPDATER) << "Moving file...";
+    qCDebug(CATEGORY_UPDATER) << "Installing" << update->installer.absoluteFilePath() << "...";
 #endif
-    const auto installerPath = update->installer.absoluteFilePath();
-    const auto fileName = update->installer.fileName();
-    const auto movedInstallerPath = _impl->installerDestinationDir + '/' + fileName;
-    if (!QFile::copy(installerPath, movedInstallerPath)) {
-      raiseError(ErrorCode::DiskError, "Can't copy file to new destination");
-    }
-    if (!QFile::remove(installerPath)) {
-      raiseError(ErrorCode::DiskError, "Can't remove temporary file");
-    }
-  }
-
-  _impl->setState(State::Idle);
-  emit installationFinished();
+    // Finished by Impl::onInstallFinished(). The progress is notified in the updater's thread.
+    const auto context = QtInstallStrategy::Context{ update->installer.absoluteFilePath(), update->json.version };
+    _impl->installWatcher.setFuture(QtConcurrent::run([this, strategy, context]() {
+      return strategy->install(context, [this](int const percentage) {
+        QMetaObject::invokeMethod(
+          this,
+          [this, percentage]() {
+            emit installationProgressChanged(percentage);
+          },
+          Qt::QueuedConnection);
+      });
+    }));
+  });
 }
 
 #pragma endregion
@@ -0,0 +1,131 @@
+#include "SharedCache.hpp"
+#include "FileUtils.hpp"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QMetaEnum>
+
+#include <algorithm>
+#include <vector>
+
+namespace oclero::sharedcache {
+namespace {
+constexpr auto LOCK_FILE_NAME = ".lock";
+// Other processes only hold the lock while linking or copying a file.
+constexpr auto LOCK_TIMEOUT = 30000;
+// Empty file whose modification time is the last use of the cached file. The cached file itself is not touched,
+// as its links elsewhere would look modified.
+constexpr auto LAST_USE_SUFFIX = ".used";
+
+QString cachePath(const QString& cacheDirPath, const QString& name) {
+  return QDir(cacheDirPath).absoluteFilePath(name);
+}
+
+void markAsUsed(const QString& cachedFilePath) {
+  QFile file(cachedFilePath + LAST_USE_SUFFIX);
+  if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+  }
+}
+
+QDateTime lastUse(const QFileInfo& cachedFile) {
+  const QFileInfo marker(cachedFile.absoluteFilePath() + LAST_USE_SUFFIX);
+  return marker.exists() ? marker.lastModified() : cachedFile.lastModified();
+}
+
+void evict(const QString& cacheDirPath, const QString& keptKey, qint64 const sizeLimit) {
+  if (sizeLimit <= 0) {
+    return;
+  }
+
+  struct Entry {
+    QFileInfo file;
+    QDateTime lastUse;
+  };
+  std::vector<Entry> entries;
+  auto totalSize = qint64{ 0 };
+  for (const auto& file : QDir(cacheDirPath).entryInfoList(QDir::Files | QDir::Hidden)) {
+    const auto name = file.fileName();
+    if (name == LOCK_FILE_NAME || name.endsWith(LAST_USE_SUFFIX)) {
+      continue;
+    }
+    totalSize += file.size();
+    if (name != keptKey) {
+      entries.push_back({ file, lastUse(file) });
+    }
+  }
+
+  // Least recently used first.
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.lastUse < b.lastUse;
+  });
+  for (const auto& entry : entries) {
+    if (totalSize <= sizeLimit) {
+      break;
+    }
+    const auto path = entry.file.absoluteFilePath();
+    if (QFile::remove(path)) {
+      QFile::remove(path + LAST_USE_SUFFIX);
+      totalSize -= entry.file.size();
+    }
+  }
+}
+} // namespace
+
+QString key(const QString& checksum, QtDownloader::ChecksumType const checksumType) {
+  const auto typeName = QString::fromLatin1(QMetaEnum::fromType<QtDownloader::ChecksumType>().valueToKey(
+    static_cast<int>(checksumType)));
+  return typeName.toLower() + '-' + checksum.toLower();
+}
+
+bool retrieve(const QString& cacheDirPath, const QString& key, const QString& destinationPath) {
+  if (!QDir(cacheDirPath).exists()) {
+    return false;
+  }
+
+  QLockFile lock(cachePath(cacheDirPath, LOCK_FILE_NAME));
+  if (!lock.tryLock(LOCK_TIMEOUT)) {
+    return false;
+  }
+
+  const auto cachedFilePath = cachePath(cacheDirPath, key);
+  if (!QFileInfo::exists(cachedFilePath) || !fileutils::linkOrCopyFile(cachedFilePath, destinationPath)) {
+    return false;
+  }
+  markAsUsed(cachedFilePath);
+  return true;
+}
+
+bool remove(const QString& cacheDirPath, const QString& key) {
+  QLockFile lock(cachePath(cacheDirPath, LOCK_FILE_NAME));
+  if (!lock.tryLock(LOCK_TIMEOUT)) {
+    return false;
+  }
+
+  const auto cachedFilePath = cachePath(cacheDirPath, key);
+  QFile::remove(cachedFilePath + LAST_USE_SUFFIX);
+  return QFile::remove(cachedFilePath);
+}
+
+bool store(const QString& cacheDirPath, const QString& key, const QString& filePath, qint64 const sizeLimit) {
+  if (!QDir().mkpath(cacheDirPath)) {
+    return false;
+  }
+
+  QLockFile lock(cachePath(cacheDirPath, LOCK_FILE_NAME));
+  if (!lock.tryLock(LOCK_TIMEOUT)) {
+    return false;
+  }
+
+  const auto cachedFilePath = cachePath(cacheDirPath, key);
+  if (!QFileInfo::exists(cachedFilePath) && !fileutils::linkOrCopyFile(filePath, cachedFilePath)) {
+    return false;
+  }
+  markAsUsed(cachedFilePath);
+  evict(cacheDirPath, key, sizeLimit);
+  return true;
+}
+} // namespace oclero::sharedcache
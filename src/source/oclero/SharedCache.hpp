@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QString>
+
+#include <oclero/QtDownloader.hpp>
+
+namespace oclero::sharedcache {
+/**
+ * @brief Name of a file in the cache: its content is identified by its checksum.
+ */
+QString key(const QString& checksum, QtDownloader::ChecksumType const checksumType);
+
+/**
+ * @brief Hard-links (or copies) the cached file to the destination, and marks it as recently used.
+ * The destination may share its content with the cache: it must be unshared (fileutils::unshareFile()) before
+ * being changed in place, as the install strategies do.
+ * The cache directory may be shared by several processes: accesses are serialized with a lock file.
+ * @return False if the file is not in the cache, or can't be retrieved.
+ */
+bool retrieve(const QString& cacheDirPath, const QString& key, const QString& destinationPath);
+
+/**
+ * @brief Removes a file from the cache, e.g. if its content doesn't match its key.
+ */
+bool remove(const QString& cacheDirPath, const QString& key);
+
+/**
+ * @brief Hard-links (or copies) an already verified file to the cache, then removes the least recently used
+ * files until the cache size is below the limit (0 means no limit). The new file is never removed.
+ */
+bool store(const QString& cacheDirPath, const QString& key, const QString& filePath, qint64 const sizeLimit);
+} // namespace oclero::sharedcache
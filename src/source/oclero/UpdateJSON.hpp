@@ -0,0 +1,259 @@
+#pragma once
+
+#include <oclero/QtDownloader.hpp>
+#include <oclero/FileUtils.hpp>
+
+#include <oclero/QtEnumUtils.hpp>
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QUrl>
+#include <QVector>
+#include <QVersionNumber>
+
+#include <algorithm>
+#include <tuple>
+
+namespace oclero {
+constexpr auto JSON_DATETIME_FORMAT = "dd/MM/yyyy";
+constexpr auto JSON_TAG_CHECKSUM = "checksum";
+constexpr auto JSON_TAG_CHECKSUM_TYPE = "checksumType";
+constexpr auto JSON_TAG_DATE = "date";
+constexpr auto JSON_TAG_INSTALLER_URL = "installerUrl";
+constexpr auto JSON_TAG_CHANGELOG_URL = "changelogUrl";
+constexpr auto JSON_TAG_CHANGELOG_DELTA = "changelogDelta";
+constexpr auto JSON_TAG_VERSION = "version";
+constexpr auto JSON_TAG_BLOCK_MANIFEST_URL = "blockManifestUrl";
+constexpr auto JSON_TAG_MIRRORS = "mirrors";
+constexpr auto JSON_TAG_MIRROR_URL = "url";
+constexpr auto JSON_TAG_MIRROR_WEIGHT = "weight";
+
+/**
+ * @brief Update information sent by the server (the appcast).
+ */
+struct UpdateJSON {
+  /**
+   * @brief Other URL of the installer. The weight is the relative share of the clients that use the mirror
+   * when none of them could be measured. Mirrors with a null weight are only used when the others fail.
+   */
+  struct Mirror {
+    QUrl url;
+    double weight{ 1. };
+  };
+
+  QVersionNumber version;
+  QUrl installerUrl;
+  QUrl changelogUrl;
+  QByteArray checksum;
+  QtDownloader::ChecksumType checksumType{ QtDownloader::ChecksumType::NoChecksum };
+  QDateTime date;
+  // The server can send only the changelog sections newer than a version, with the 'since' query parameter.
+  bool changelogDelta{ false };
+  // Optional SHA-256 digests of the installer blocks, to detect corrupted blocks while downloading.
+  QUrl blockManifestUrl;
+  // Optional mirrors of the installer, as strings or objects with fields "url" and "weight".
+  QVector<Mirror> mirrors;
+
+  UpdateJSON() = default;
+
+  UpdateJSON(const QByteArray& data) {
+    const auto jsonDocument = QJsonDocument::fromJson(data);
+    if (!jsonDocument.isNull() && jsonDocument.isObject()) {
+      const auto jsonObject = jsonDocument.object();
+      if (!jsonObject.isEmpty()) {
+        if (jsonObject.contains(JSON_TAG_VERSION)) {
+          version = QVersionNumber::fromString(jsonObject[JSON_TAG_VERSION].toString());
+        }
+
+        if (jsonObject.contains(JSON_TAG_CHANGELOG_URL)) {
+          changelogUrl = QUrl(jsonObject[JSON_TAG_CHANGELOG_URL].toString());
+        }
+
+        if (jsonObject.contains(JSON_TAG_INSTALLER_URL)) {
+          installerUrl = QUrl(jsonObject[JSON_TAG_INSTALLER_URL].toString());
+        }
+
+        if (jsonObject.contains(JSON_TAG_CHECKSUM)) {
+          checksum = jsonObject[JSON_TAG_CHECKSUM].toString().toUtf8();
+        }
+
+        if (jsonObject.contains(JSON_TAG_CHECKSUM_TYPE)) {
+          checksumType =
+            enumFromString<QtDownloader::ChecksumType>(jsonObject[JSON_TAG_CHECKSUM_TYPE].toString().toUpper());
+        }
+
+        if (jsonObject.contains(JSON_TAG_DATE)) {
+          date = QDateTime::fromString(jsonObject[JSON_TAG_DATE].toString(), JSON_DATETIME_FORMAT);
+        }
+
+        if (jsonObject.contains(JSON_TAG_CHANGELOG_DELTA)) {
+          changelogDelta = jsonObject[JSON_TAG_CHANGELOG_DELTA].toBool();
+        }
+
+        if (jsonObject.contains(JSON_TAG_BLOCK_MANIFEST_URL)) {
+          blockManifestUrl = QUrl(jsonObject[JSON_TAG_BLOCK_MANIFEST_URL].toString());
+        }
+
+        if (jsonObject.contains(JSON_TAG_MIRRORS)) {
+          for (const auto& value : jsonObject[JSON_TAG_MIRRORS].toArray()) {
+            Mirror mirror;
+            if (value.isObject()) {
+              const auto mirrorObject = value.toObject();
+              mirror.url = QUrl(mirrorObject[JSON_TAG_MIRROR_URL].toString());
+              mirror.weight = mirrorObject[JSON_TAG_MIRROR_WEIGHT].toDouble(1.);
+            } else {
+              mirror.url = QUrl(value.toString());
+            }
+            mirrors.append(mirror);
+          }
+        }
+      }
+    }
+  }
+
+  // Relative URLs are relative to the appcast, e.g. when the installer is next to it in a directory.
+  void resolveUrls(const QUrl& appcastUrl) {
+    const auto resolve = [&appcastUrl](QUrl& url) {
+      if (!url.isEmpty() && url.isRelative()) {
+        url = appcastUrl.resolved(url);
+      }
+    };
+    resolve(installerUrl);
+    resolve(changelogUrl);
+    resolve(blockManifestUrl);
+    for (auto& mirror : mirrors) {
+      resolve(mirror.url);
+    }
+  }
+
+  bool isValid() const {
+    const auto validVersionNumber = !version.isNull();
+    if (!validVersionNumber)
+      return false;
+
+    const auto validInstallerUrl = installerUrl.isEmpty() || installerUrl.isValid();
+    if (!validInstallerUrl)
+      return false;
+
+    const auto validChangelogUrl = changelogUrl.isEmpty() || changelogUrl.isValid();
+    if (!validChangelogUrl)
+      return false;
+
+    const auto validBlockManifestUrl = blockManifestUrl.isEmpty() || blockManifestUrl.isValid();
+    if (!validBlockManifestUrl)
+      return false;
+
+    const auto validMirrors = std::all_of(mirrors.cbegin(), mirrors.cend(), [](const Mirror& mirror) {
+      return mirror.url.isValid() && mirror.weight >= 0.;
+    });
+    if (!validMirrors)
+      return false;
+
+    const auto validDate = date.isValid();
+    if (!validDate)
+      return false;
+
+    auto validChecksum = true;
+    if (checksumType != QtDownloader::ChecksumType::NoChecksum) {
+      auto qtAlgorithm = QCryptographicHash::Md5;
+      switch (checksumType) {
+        case QtDownloader::ChecksumType::MD5:
+          qtAlgorithm = QCryptographicHash::Algorithm::Md5;
+          break;
+        case QtDownloader::ChecksumType::SHA1:
+          qtAlgorithm = QCryptographicHash::Algorithm::Sha1;
+          break;
+        case QtDownloader::ChecksumType::SHA256:
+        case QtDownloader::ChecksumType::SHA256_TREE:
+          qtAlgorithm = QCryptographicHash::Algorithm::Sha256;
+          break;
+        default:
+          break;
+      }
+
+      validChecksum = !checksum.isEmpty() && checksum.size() == 2 * QCryptographicHash::hashLength(qtAlgorithm);
+    }
+    if (!validChecksum)
+      return false;
+
+    return true;
+  }
+
+  QByteArray toJSON() const {
+    if (!isValid()) {
+      return QByteArray();
+    }
+
+    // Create JSON object.
+    QJsonObject jsonObject({
+      { JSON_TAG_VERSION, version.toString() },
+      { JSON_TAG_INSTALLER_URL, installerUrl.toString() },
+      { JSON_TAG_CHANGELOG_URL, changelogUrl.toString() },
+      { JSON_TAG_CHECKSUM, checksum.constData() },
+      { JSON_TAG_CHECKSUM_TYPE, enumToString(checksumType).toLower() },
+      { JSON_TAG_DATE, date.toString(JSON_DATETIME_FORMAT) },
+    });
+    if (changelogDelta) {
+      jsonObject.insert(JSON_TAG_CHANGELOG_DELTA, true);
+    }
+    if (!blockManifestUrl.isEmpty()) {
+      jsonObject.insert(JSON_TAG_BLOCK_MANIFEST_URL, blockManifestUrl.toString());
+    }
+    if (!mirrors.isEmpty()) {
+      QJsonArray mirrorArray;
+      for (const auto& mirror : mirrors) {
+        mirrorArray.append(QJsonObject{
+          { JSON_TAG_MIRROR_URL, mirror.url.toString() },
+          { JSON_TAG_MIRROR_WEIGHT, mirror.weight },
+        });
+      }
+      jsonObject.insert(JSON_TAG_MIRRORS, mirrorArray);
+    }
+
+    return QJsonDocument(jsonObject).toJson(QJsonDocument::JsonFormat::Compact);
+  }
+
+  std::tuple<bool, QString> saveToFile(const QString& dirPath) const {
+    if (!isValid()) {
+      return { false, {} };
+    }
+
+    const auto filename = QFileInfo(installerUrl.fileName()).completeBaseName();
+    const auto filePath = dirPath + '/' + filename + ".json";
+
+    // Create directory if not existing yet.
+    QDir const dir(dirPath);
+    if (!dir.exists()) {
+      if (!dir.mkpath(".")) {
+        return { false, {} };
+      }
+    }
+
+    const auto data = toJSON();
+    if (data.isEmpty()) {
+      return { false, {} };
+    }
+
+    // Write file atomically: an existing JSON file is replaced only once the new one is complete.
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+      return { false, {} };
+    }
+
+    file.write(data);
+    if (!fileutils::commitDurably(file)) {
+      return { false, {} };
+    }
+
+    return { true, filePath };
+  }
+};
+} // namespace oclero
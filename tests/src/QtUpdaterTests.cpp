@@ -1,13 +1,46 @@
 #include "QtUpdaterTests.hpp"
+#include "TestServer.hpp"
 
 #include <httplib.h>
+#include <oclero/FileUtils.hpp>
+#include <oclero/QtDownloader.hpp>
+#include <oclero/QtInstallStrategy.hpp>
+#include <oclero/QtUpdateAgent.hpp>
+#include <oclero/QtUpdateAgentServer.hpp>
+#include <oclero/QtUpdateController.hpp>
 #include <oclero/QtUpdater.hpp>
+#include <oclero/UpdateJSON.hpp>
 
 #include <QCryptographicHash>
 #include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStorageInfo>
+#include <QTemporaryDir>
+#include <QThread>
 #include <QTest>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <optional>
 #include <thread>
+#include <vector>
+
+#if !defined(Q_OS_WIN)
+#  include <sys/stat.h>
+#endif
 
 using namespace oclero;
 
@@ -28,6 +61,9 @@ constexpr auto CONTENT_TYPE_MD = "text/markdown";
 
 constexpr auto DUMMY_INSTALLER_DATA = "This is just dummy data to simulate an installer file";
 
+// Written by runPeerSharer() once the installer is shared.
+constexpr auto PEER_SHARER_READY = "ready";
+
 // Dummy markdown changelog.
 constexpr auto DUMMY_CHANGELOG = R"(# Changelog
 ## MyApp 2.0.0
@@ -50,19 +86,89 @@ constexpr auto APPCAST_TEMPLATE = R"({
 
 static const QString SERVER_URL_FOR_CLIENT = "http://" + QString(SERVER_URL) + ':' + QString::number(SERVER_PORT);
 
-QString getInstallerChecksum(const char* data) {
-  QByteArray installerData(data);
+QString getInstallerChecksum(const QByteArray& installerData) {
   QCryptographicHash hash(QCryptographicHash::Algorithm::Md5);
   hash.addData(installerData);
   const auto installerHash = hash.result().toHex();
   return installerHash;
 }
 
-QString getAppCast(const QString& version) {
-  static const auto checksum = getInstallerChecksum(DUMMY_INSTALLER_DATA);
+QString getAppCast(const QString& version, const QString& checksum) {
   const auto todayDate = QDate::currentDate().toString("dd/MM/yyyy");
   return QString(APPCAST_TEMPLATE).arg(version).arg(todayDate).arg(checksum).arg(SERVER_URL_FOR_CLIENT);
 }
+
+QString getAppCast(const QString& version) {
+  static const auto checksum = getInstallerChecksum(DUMMY_INSTALLER_DATA);
+  return getAppCast(version, checksum);
+}
+
+// Same appcast, with a SHA-256 checksum.
+QByteArray getSha256AppCast(const QString& version, const QByteArray& installerData) {
+  auto appCast = QJsonDocument::fromJson(getAppCast(version).toUtf8()).object();
+  appCast.insert("checksum", QString(QCryptographicHash::hash(installerData, QCryptographicHash::Sha256).toHex()));
+  appCast.insert("checksumType", "sha256");
+  return QJsonDocument(appCast).toJson(QJsonDocument::JsonFormat::Compact);
+}
+
+QByteArray getLargeInstallerData(int size) {
+  QByteArray result(size, Qt::Uninitialized);
+  for (auto i = 0; i < size; ++i) {
+    result[i] = static_cast<char>(i % 251);
+  }
+  return result;
+}
+
+QByteArray getBlockManifest(const QByteArray& data, int blockSize) {
+  QJsonArray blocks;
+  for (auto offset = 0; offset < data.size(); offset += blockSize) {
+    blocks.append(
+      QString(QCryptographicHash::hash(data.mid(offset, blockSize), QCryptographicHash::Algorithm::Sha256).toHex()));
+  }
+  const auto manifest = QJsonObject{
+    { "size", data.size() },
+    { "blockSize", blockSize },
+    { "blocks", blocks },
+  };
+  return QJsonDocument(manifest).toJson(QJsonDocument::JsonFormat::Compact);
+}
+
+QByteArray getAppCastWithBlockManifest(const QString& version, const QByteArray& installerData) {
+  auto appCast = QJsonDocument::fromJson(getAppCast(version, getInstallerChecksum(installerData)).toUtf8()).object();
+  appCast.insert("blockManifestUrl", SERVER_URL_FOR_CLIENT + "/installer.manifest");
+  return QJsonDocument(appCast).toJson(QJsonDocument::JsonFormat::Compact);
+}
+
+// Creates a .tar.gz archive containing "bin/version.txt". Returns an empty path if tar is not available.
+QString getArchivePath(const QString& dir, const QString& version) {
+  const auto contentDir = dir + "/content-" + version;
+  QDir().mkpath(contentDir + "/bin");
+  QFile file(contentDir + "/bin/version.txt");
+  if (!file.open(QIODevice::WriteOnly)) {
+    return {};
+  }
+  file.write(version.toUtf8());
+  file.close();
+
+  const auto archivePath = dir + "/MyApp-" + version + ".tar.gz";
+  const auto exitCode = QProcess::execute("tar", { "-czf", archivePath, "-C", contentDir, "." });
+  return exitCode == 0 ? archivePath : QString{};
+}
+
+QString getInstallerPath(const QString& version) {
+  return QString("/installer-%1.0.exe").arg(version);
+}
+
+// Identifies the content of a file, whatever its path (inode). Always 0 on Windows.
+quint64 getFileId(const QString& filePath) {
+#if defined(Q_OS_WIN)
+  Q_UNUSED(filePath);
+  return 0;
+#else
+  struct stat status;
+  return ::stat(QFile::encodeName(filePath).constData(), &status) == 0 ? static_cast<quint64>(status.st_ino) : 0;
+#endif
+}
 } // namespace
 
 void Tests::test_emptyServerUrl() {
@@ -361,6 +467,10 @@ void Tests::test_validChangelogUrl() {
     error = true;
     downloadedChangelog = true;
   });
+  auto loadedChangelog = false;
+  QObject::connect(&updater, &QtUpdater::latestChangelogChanged, this, [&loadedChangelog]() {
+    loadedChangelog = true;
+  });
   updater.downloadChangelog();
   if (!QTest::qWaitFor(
         [&downloadedChangelog]() {
@@ -378,8 +488,17 @@ void Tests::test_validChangelogUrl() {
   }
 
   const auto changelogAvailable = updater.changelogAvailable();
-  const auto& latestChangelog = updater.latestChangelog();
   QVERIFY(changelogAvailable);
+
+  // Changelog is decoded asynchronously.
+  if (!QTest::qWaitFor(
+        [&loadedChangelog]() {
+          return loadedChangelog;
+        },
+        updater.checkTimeout())) {
+    QFAIL("Too late.");
+  }
+  const auto& latestChangelog = updater.latestChangelog();
   QVERIFY(latestChangelog == DUMMY_CHANGELOG);
 }
 
@@ -451,6 +570,241 @@ void Tests::test_invalidChangelogUrl() {
   QVERIFY(latestChangelog.isEmpty());
 }
 
+void Tests::test_changelogOptions() {
+  constexpr auto changelog = R"(# Changelog
+## MyApp 2.0.0
+- New Feature 2
+## MyApp 1.5.0
+- New Feature 1
+## MyApp 1.0.0
+- Fix bug 1
+)";
+
+  // Server.
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve(QString("/changelog-%1.0.md").arg(LATEST_VERSION), changelog, CONTENT_TYPE_MD);
+  QVERIFY(server.start());
+
+  // Configure updater: only the sections newer than the current version are kept.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+  updater.setCurrentVersion(CURRENT_VERSION);
+  updater.setChangelogSinceCurrentVersion(true);
+
+  auto downloaded = false;
+  auto changelogChanges = 0;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+    updater.downloadChangelog();
+  });
+  QObject::connect(&updater, &QtUpdater::changelogDownloadFinished, this, [&downloaded]() {
+    downloaded = true;
+  });
+  QObject::connect(&updater, &QtUpdater::latestChangelogChanged, this, [&changelogChanges]() {
+    ++changelogChanges;
+  });
+  updater.forceCheckForUpdate();
+  QVERIFY(QTest::qWaitFor(
+    [&downloaded]() {
+      return downloaded;
+    },
+    updater.checkTimeout()));
+
+  // The changelog is decoded asynchronously.
+  QVERIFY(QTest::qWaitFor(
+    [&updater]() {
+      return !updater.latestChangelog().isEmpty();
+    },
+    updater.checkTimeout()));
+  QCOMPARE(updater.latestChangelog(),
+    QString("# Changelog\n## MyApp 2.0.0\n- New Feature 2\n## MyApp 1.5.0\n- New Feature 1"));
+
+  // Changing an option notifies the change, then the changelog is decoded again: it is empty until then.
+  updater.setChangelogSinceCurrentVersion(false);
+  changelogChanges = 0;
+  updater.setChangelogSizeLimit(30);
+  QCOMPARE(changelogChanges, 1);
+  QVERIFY(updater.latestChangelog().isEmpty());
+  QVERIFY(QTest::qWaitFor(
+    [&changelogChanges]() {
+      return changelogChanges == 2;
+    },
+    updater.checkTimeout()));
+
+  // Only the head of the file is read, up to its last complete line.
+  QCOMPARE(updater.latestChangelog(), QString("# Changelog\n## MyApp 2.0.0\n"));
+}
+
+void Tests::test_changelogDelta() {
+  // Server.
+  std::string sinceParameter;
+  httplib::Server server;
+  server.Get(APPCAST_QUERY_REGEX, [](const httplib::Request&, httplib::Response& response) {
+    auto appCast = QJsonDocument::fromJson(getAppCast(LATEST_VERSION).toUtf8()).object();
+    appCast.insert("changelogDelta", true);
+    response.set_content(QJsonDocument(appCast).toJson().toStdString(), CONTENT_TYPE_JSON);
+  });
+  server.Get(CHANGELOG_QUERY_REGEX, [&sinceParameter](const httplib::Request& request, httplib::Response& response) {
+    sinceParameter = request.get_param_value("since");
+    response.set_content(DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  });
+
+  // Start server in a thread.
+  auto t = std::thread([&server]() {
+    if (!server.listen(SERVER_HOST, SERVER_PORT)) {
+      server.stop();
+      QFAIL("Can't start server");
+    }
+  });
+
+  // Configure updater.
+  QtUpdater updater(SERVER_URL_FOR_CLIENT);
+
+  // Check for updates, then download changelog.
+  auto done = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::changelogDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::changelogDownloadFailed, this, [&done]() {
+    done = true;
+  });
+  updater.forceCheckForUpdate();
+  if (!QTest::qWaitFor(
+        [&done]() {
+          return done;
+        },
+        updater.checkTimeout())) {
+    QFAIL("Too late.");
+  }
+  done = false;
+  updater.downloadChangelog();
+  if (!QTest::qWaitFor(
+        [&done]() {
+          return done;
+        },
+        updater.checkTimeout())) {
+    QFAIL("Too late.");
+  }
+  server.stop();
+  t.join();
+
+  // The client should only ask for what's newer than its version.
+  QVERIFY(updater.changelogAvailable());
+  QVERIFY(sinceParameter == CURRENT_VERSION);
+}
+
+void Tests::test_changelogMerge() {
+  constexpr auto previousVersion = "1.5.0";
+  constexpr auto previousChangelog = R"(# Changelog
+## MyApp 1.5.0
+- New Feature 1
+## MyApp 1.0.0
+- Fix bug 1
+)";
+  constexpr auto changelogFragment = R"(## MyApp 2.0.0
+- New Feature 2
+)";
+
+  // Server.
+  TestServer server(SERVER_PORT);
+  server.serve(QString("/changelog-%1.0.md").arg(previousVersion), previousChangelog, CONTENT_TYPE_MD);
+  server.serve(getInstallerPath(previousVersion), DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  server.serve(QString("/changelog-%1.0.md").arg(LATEST_VERSION), changelogFragment, CONTENT_TYPE_MD);
+  QVERIFY(server.start());
+
+  auto deltaAppCast = QJsonDocument::fromJson(getAppCast(LATEST_VERSION).toUtf8()).object();
+  deltaAppCast.insert("changelogDelta", true);
+
+  // Downloads the previous update, then the changelog fragment of the latest one.
+  const auto downloadChangelogDelta = [this, &server, &deltaAppCast, previousVersion](
+                                        const QString& dirPath, bool const cancelDuringMerge) {
+    server.serve("/", getAppCast(previousVersion).toUtf8(), CONTENT_TYPE_JSON);
+    {
+      QtUpdater updater(server.url());
+      updater.setTemporaryDirectoryPath(dirPath);
+      updater.setCurrentVersion(CURRENT_VERSION);
+      auto done = false;
+      QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+        updater.downloadChangelog();
+      });
+      QObject::connect(&updater, &QtUpdater::changelogDownloadFinished, &updater, [&updater]() {
+        updater.downloadInstaller();
+      });
+      QObject::connect(&updater, &QtUpdater::installerDownloadFinished, &updater, [&done]() {
+        done = true;
+      });
+      updater.forceCheckForUpdate();
+      if (!QTest::qWaitFor(
+            [&done]() {
+              return done;
+            },
+            updater.checkTimeout())) {
+        return QtUpdater::ErrorCode::UnknownError;
+      }
+    }
+
+    server.serve("/", QJsonDocument(deltaAppCast).toJson(), CONTENT_TYPE_JSON);
+    QtUpdater updater(server.url());
+    updater.setTemporaryDirectoryPath(dirPath);
+    updater.setCurrentVersion(CURRENT_VERSION);
+    auto result = std::optional<QtUpdater::ErrorCode>{};
+    auto finished = false;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater, cancelDuringMerge]() {
+      // The merge starts when the fragment is downloaded, right after its metrics are available.
+      if (cancelDuringMerge) {
+        QObject::connect(
+          &updater, &QtUpdater::transferMetricsAvailable, &updater,
+          [&updater]() {
+            updater.cancel();
+          },
+          Qt::QueuedConnection);
+      }
+      updater.downloadChangelog();
+    });
+    QObject::connect(&updater, &QtUpdater::changelogDownloadFinished, this, [&result, &finished]() {
+      result = QtUpdater::ErrorCode::NoError;
+      finished = true;
+    });
+    QObject::connect(&updater, &QtUpdater::changelogDownloadFailed, this, [&result](auto const error) {
+      result = error;
+    });
+    QObject::connect(&updater, &QtUpdater::changelogDownloadCancelled, this, [&result]() {
+      result = QtUpdater::ErrorCode::NoError;
+    });
+    updater.forceCheckForUpdate();
+    if (!QTest::qWaitFor(
+          [&result]() {
+            return result.has_value();
+          },
+          updater.checkTimeout())) {
+      return QtUpdater::ErrorCode::UnknownError;
+    }
+
+    // Let a cancelled merge end: the download must not finish anyway.
+    QTest::qWait(200);
+    if (finished == cancelDuringMerge) {
+      return QtUpdater::ErrorCode::UnknownError;
+    }
+    return *result;
+  };
+
+  // The fragment is merged with the sections of the previous changelog newer than the current version.
+  QTemporaryDir temporaryDir;
+  QCOMPARE(downloadChangelogDelta(temporaryDir.path(), false), QtUpdater::ErrorCode::NoError);
+  QFile changelogFile(temporaryDir.path() + QString("/changelog-%1.0.md").arg(LATEST_VERSION));
+  QVERIFY(changelogFile.open(QIODevice::ReadOnly));
+  QCOMPARE(QString::fromUtf8(changelogFile.readAll()),
+    QString("## MyApp 2.0.0\n- New Feature 2\n## MyApp 1.5.0\n- New Feature 1"));
+
+  // Canceling during the merge cancels the download.
+  QTemporaryDir otherTemporaryDir;
+  QCOMPARE(downloadChangelogDelta(otherTemporaryDir.path(), true), QtUpdater::ErrorCode::NoError);
+}
+
 void Tests::test_validInstallerUrl() {
   // Server.
   httplib::Server server;
@@ -652,3 +1006,2050 @@ void Tests::test_cancel() {
 
   QVERIFY(cancelled);
 }
+
+void Tests::test_binaryCache() {
+  // Server.
+  httplib::Server server;
+  server.Get(APPCAST_QUERY_REGEX, [](const httplib::Request&, httplib::Response& response) {
+    const auto appCast = getAppCast(LATEST_VERSION);
+    response.set_content(appCast.toStdString(), CONTENT_TYPE_JSON);
+  });
+  server.Get(CHANGELOG_QUERY_REGEX, [](const httplib::Request&, httplib::Response& response) {
+    response.set_content(DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  });
+  server.Get(INSTALLER_QUERY_REGEX, [](const httplib::Request&, httplib::Response& response) {
+    response.set_content(DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  });
+
+  // Start server in a thread.
+  auto t = std::thread([&server]() {
+    if (!server.listen(SERVER_HOST, SERVER_PORT)) {
+      server.stop();
+      QFAIL("Can't start server");
+    }
+  });
+
+  // Configure updater.
+  QtUpdater updater(SERVER_URL_FOR_CLIENT);
+  updater.setBinaryCacheEnabled(true);
+
+  // Check for updates, then download the whole bundle.
+  auto done = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::changelogDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  const auto wait = [&done, &updater]() {
+    return QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+  };
+
+  updater.forceCheckForUpdate();
+  if (!wait()) {
+    QFAIL("Too late.");
+  }
+  done = false;
+  updater.downloadChangelog();
+  if (!wait()) {
+    QFAIL("Too late.");
+  }
+  done = false;
+  updater.downloadInstaller();
+  if (!wait()) {
+    QFAIL("Too late.");
+  }
+  server.stop();
+  t.join();
+
+  QVERIFY(updater.installerAvailable());
+  const auto downloadsDir = updater.temporaryDirectoryPath();
+  QVERIFY(QFile::exists(downloadsDir + "/update.cache"));
+
+  // Without the JSON file, only the cache can tell about the downloaded update.
+  QVERIFY(QFile::remove(downloadsDir + "/installer-" + LATEST_VERSION + ".0.json"));
+
+  // Alter the installer in place, keeping its size and modification time: only hashing it can notice.
+  const auto installerPath = downloadsDir + getInstallerPath(LATEST_VERSION);
+  const auto lastModified = QFileInfo(installerPath).lastModified();
+  {
+    QFile installerFile(installerPath);
+    QVERIFY(installerFile.open(QIODevice::ReadWrite));
+    QByteArray alteredData(DUMMY_INSTALLER_DATA);
+    std::reverse(alteredData.begin(), alteredData.end());
+    installerFile.write(alteredData);
+    installerFile.flush();
+    QVERIFY(installerFile.setFileTime(lastModified, QFileDevice::FileModificationTime));
+  }
+
+  // A new updater should find the bundle from the cache, even without server.
+  QtUpdater warmUpdater(SERVER_URL_FOR_CLIENT);
+  warmUpdater.setBinaryCacheEnabled(true);
+  auto warmChecked = false;
+  QObject::connect(&warmUpdater, &QtUpdater::checkForUpdateFinished, this, [&warmChecked]() {
+    warmChecked = true;
+  });
+  warmUpdater.forceCheckForUpdate();
+  if (!QTest::qWaitFor(
+        [&warmChecked]() {
+          return warmChecked;
+        },
+        warmUpdater.checkTimeout())) {
+    QFAIL("Too late.");
+  }
+
+  QVERIFY(warmUpdater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+  QVERIFY(warmUpdater.latestVersion() == LATEST_VERSION);
+  QVERIFY(warmUpdater.installerAvailable());
+
+  // Install update (synchronous): the altered installer is not hashed again, since the cache tells it was
+  // verified and its stamp did not change.
+  auto installationFailed = false;
+  QObject::connect(&warmUpdater, &QtUpdater::installationFailed, this, [&installationFailed]() {
+    installationFailed = true;
+  });
+  warmUpdater.installUpdate(/*dry*/ true);
+  QVERIFY(!installationFailed);
+}
+
+void Tests::test_persistedVerification() {
+  // Server.
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  const auto changelogPath = QString("/changelog-%1.0.md").arg(LATEST_VERSION);
+  auto server = std::make_unique<TestServer>(SERVER_PORT);
+  server->serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  server->serve(changelogPath, DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  server->serve(installerPath, DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  QVERIFY(server->start());
+
+  // Download the whole bundle, with the binary cache disabled.
+  QTemporaryDir temporaryDir;
+  {
+    QtUpdater updater(server->url());
+    updater.setTemporaryDirectoryPath(temporaryDir.path());
+    auto done = false;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+      updater.downloadChangelog();
+    });
+    QObject::connect(&updater, &QtUpdater::changelogDownloadFinished, &updater, [&updater]() {
+      updater.downloadInstaller();
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFinished, &updater, [&done]() {
+      done = true;
+    });
+    updater.forceCheckForUpdate();
+    QVERIFY(QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout()));
+    QVERIFY(updater.installerAvailable());
+  }
+  const auto serverUrl = server->url();
+  server.reset();
+
+  // The verification is persisted in the cache anyway.
+  QVERIFY(QFile::exists(temporaryDir.filePath("update.cache")));
+
+  // Alter the installer in place, keeping its size and modification time: only hashing it can notice.
+  const auto installerFilePath = temporaryDir.path() + installerPath;
+  const auto lastModified = QFileInfo(installerFilePath).lastModified();
+  {
+    QFile installerFile(installerFilePath);
+    QVERIFY(installerFile.open(QIODevice::ReadWrite));
+    QByteArray alteredData(DUMMY_INSTALLER_DATA);
+    std::reverse(alteredData.begin(), alteredData.end());
+    installerFile.write(alteredData);
+    installerFile.flush();
+    QVERIFY(installerFile.setFileTime(lastModified, QFileDevice::FileModificationTime));
+  }
+
+  // A new updater finds the downloaded bundle, without server.
+  QtUpdater updater(serverUrl);
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+  auto checked = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&checked]() {
+    checked = true;
+  });
+  updater.forceCheckForUpdate();
+  QVERIFY(QTest::qWaitFor(
+    [&checked]() {
+      return checked;
+    },
+    updater.checkTimeout()));
+  QVERIFY(updater.installerAvailable());
+
+  auto installationError = QtUpdater::ErrorCode::NoError;
+  auto installationFinished = false;
+  QObject::connect(&updater, &QtUpdater::installationFailed, this, [&installationError](auto const error) {
+    installationError = error;
+  });
+  QObject::connect(&updater, &QtUpdater::installationFinished, this, [&installationFinished]() {
+    installationFinished = true;
+  });
+
+  // The installer is not hashed again, so the alteration goes unnoticed.
+  updater.installUpdate(/*dry*/ true);
+  QVERIFY(installationFinished);
+  QCOMPARE(installationError, QtUpdater::ErrorCode::NoError);
+
+  // Paranoid verification always hashes the installer before installing it, in a worker thread.
+  installationFinished = false;
+  updater.setParanoidVerification(true);
+  updater.installUpdate(/*dry*/ true);
+  QCOMPARE(updater.state(), QtUpdater::State::InstallingUpdate);
+  QVERIFY(QTest::qWaitFor(
+    [&installationError]() {
+      return installationError != QtUpdater::ErrorCode::NoError;
+    },
+    updater.checkTimeout()));
+  QVERIFY(!installationFinished);
+  QCOMPARE(installationError, QtUpdater::ErrorCode::ChecksumError);
+  QCOMPARE(updater.state(), QtUpdater::State::Idle);
+}
+
+void Tests::test_verifyFileChecksum() {
+  QTemporaryDir temporaryDir;
+  const auto filePath = temporaryDir.filePath("installer.exe");
+  const auto data = getLargeInstallerData(1024 * 1024);
+  QFile file(filePath);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write(data);
+  file.close();
+
+  // Valid checksum: progress is reported up to the file size.
+  auto processed = qint64{ 0 };
+  auto total = qint64{ 0 };
+  const auto valid = QtDownloader::verifyFileChecksum(filePath, getInstallerChecksum(data),
+    QtDownloader::ChecksumType::MD5, QtDownloader::InvalidChecksumBehavior::RemoveFile,
+    [&processed, &total](qint64 const bytesProcessed, qint64 const bytesTotal, double const) {
+      processed = bytesProcessed;
+      total = bytesTotal;
+    });
+  QVERIFY(valid);
+  QCOMPARE(total, qint64{ data.size() });
+  QCOMPARE(processed, total);
+
+  // Tree hash, over several blocks (the last one being partial).
+  const auto treeFilePath = temporaryDir.filePath("tree-installer.exe");
+  const auto treeData = getLargeInstallerData(static_cast<int>(2 * QtDownloader::TreeHashBlockSize + 1000));
+  QFile treeFile(treeFilePath);
+  QVERIFY(treeFile.open(QIODevice::WriteOnly));
+  treeFile.write(treeData);
+  treeFile.close();
+
+  QCryptographicHash rootHash(QCryptographicHash::Algorithm::Sha256);
+  for (auto offset = 0; offset < treeData.size(); offset += QtDownloader::TreeHashBlockSize) {
+    const auto block = treeData.mid(offset, QtDownloader::TreeHashBlockSize);
+    rootHash.addData(QCryptographicHash::hash(block, QCryptographicHash::Algorithm::Sha256));
+  }
+  QVERIFY(QtDownloader::verifyFileChecksum(
+    treeFilePath, rootHash.result().toHex(), QtDownloader::ChecksumType::SHA256_TREE));
+  QVERIFY(!QtDownloader::verifyFileChecksum(treeFilePath,
+    QCryptographicHash::hash(treeData, QCryptographicHash::Algorithm::Sha256).toHex(),
+    QtDownloader::ChecksumType::SHA256_TREE));
+
+  // Cancelled: the verification fails without hashing, and the file is kept.
+  auto progressCount = 0;
+  const auto cancelled = QtDownloader::verifyFileChecksum(
+    filePath, getInstallerChecksum(data), QtDownloader::ChecksumType::MD5,
+    QtDownloader::InvalidChecksumBehavior::RemoveFile,
+    [&progressCount](qint64 const, qint64 const, double const) {
+      ++progressCount;
+    },
+    []() {
+      return true;
+    });
+  QVERIFY(!cancelled);
+  QCOMPARE(progressCount, 0);
+  QVERIFY(QFile::exists(filePath));
+
+  // Invalid checksum: the file is removed.
+  const auto invalid = QtDownloader::verifyFileChecksum(filePath, getInstallerChecksum(DUMMY_INSTALLER_DATA),
+    QtDownloader::ChecksumType::MD5, QtDownloader::InvalidChecksumBehavior::RemoveFile);
+  QVERIFY(!invalid);
+  QVERIFY(!QFile::exists(filePath));
+}
+
+void Tests::test_slowServer() {
+  // Server that answers after the updater has given up.
+  TestServer server(SERVER_PORT);
+  FaultProfile profile;
+  profile.latency = std::chrono::milliseconds(2000);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON, profile);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QtUpdater updater(server.url());
+  updater.setCheckTimeout(500);
+
+  auto done = false;
+  auto failed = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFailed, this, [&done, &failed]() {
+    failed = true;
+    done = true;
+  });
+  updater.forceCheckForUpdate();
+  if (!QTest::qWaitFor(
+        [&done]() {
+          return done;
+        },
+        5000)) {
+    QFAIL("Too late.");
+  }
+
+  QVERIFY(failed);
+}
+
+void Tests::test_serverError() {
+  // Server that is temporarily unavailable.
+  TestServer server(SERVER_PORT);
+  FaultProfile profile;
+  profile.errorStatus = 503;
+  profile.retryAfter = 1;
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON, profile);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QtUpdater updater(server.url());
+
+  auto done = false;
+  auto failed = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFailed, this, [&done, &failed]() {
+    failed = true;
+    done = true;
+  });
+  updater.forceCheckForUpdate();
+  if (!QTest::qWaitFor(
+        [&done]() {
+          return done;
+        },
+        updater.checkTimeout())) {
+    QFAIL("Too late.");
+  }
+
+  QVERIFY(failed);
+  QCOMPARE(server.requestCount("/"), 1);
+}
+
+void Tests::test_droppedInstallerDownload() {
+  // Server that closes the connection in the middle of the installer.
+  const auto installerData = getLargeInstallerData(256 * 1024);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION, getInstallerChecksum(installerData)).toUtf8(), CONTENT_TYPE_JSON);
+  FaultProfile profile;
+  profile.dropAtOffset = 100 * 1024;
+  server.serve(getInstallerPath(LATEST_VERSION), installerData, CONTENT_TYPE_EXE, profile);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+
+  auto done = false;
+  auto error = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFailed, this, [&done, &error]() {
+    error = true;
+    done = true;
+  });
+  const auto wait = [&done, &updater]() {
+    return QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+  };
+
+  updater.forceCheckForUpdate();
+  QVERIFY(wait());
+  QVERIFY(updater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+
+  done = false;
+  updater.downloadInstaller();
+  QVERIFY(wait());
+
+  QVERIFY(error);
+  QVERIFY(!updater.installerAvailable());
+}
+
+void Tests::test_throttledInstallerDownload() {
+  // Server with a limited bandwidth, that sends the installer in chunks.
+  const auto installerData = getLargeInstallerData(64 * 1024);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION, getInstallerChecksum(installerData)).toUtf8(), CONTENT_TYPE_JSON);
+  FaultProfile profile;
+  profile.bytesPerSecond = 64 * 1024;
+  profile.chunked = true;
+  server.serve(getInstallerPath(LATEST_VERSION), installerData, CONTENT_TYPE_EXE, profile);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+
+  auto done = false;
+  auto error = false;
+  auto progressCount = 0;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFailed, this, [&done, &error]() {
+    error = true;
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadProgressChanged, this, [&progressCount]() {
+    progressCount++;
+  });
+  const auto wait = [&done, &updater]() {
+    return QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+  };
+
+  updater.forceCheckForUpdate();
+  QVERIFY(wait());
+  QVERIFY(updater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+
+  QElapsedTimer timer;
+  timer.start();
+  done = false;
+  updater.downloadInstaller();
+  QVERIFY(wait());
+
+  QVERIFY(!error);
+  QVERIFY(updater.installerAvailable());
+  // The transfer lasts about one second, so progress is notified several times.
+  QVERIFY(timer.elapsed() >= 500);
+  QVERIFY(progressCount > 1);
+}
+
+void Tests::test_progressPolicy() {
+  // Server with a limited bandwidth: the transfer lasts about one second.
+  const auto installerData = getLargeInstallerData(128 * 1024);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION, getInstallerChecksum(installerData)).toUtf8(), CONTENT_TYPE_JSON);
+  FaultProfile profile;
+  profile.bytesPerSecond = 128 * 1024;
+  server.serve(getInstallerPath(LATEST_VERSION), installerData, CONTENT_TYPE_EXE, profile);
+  QVERIFY(server.start());
+
+  struct Notification {
+    int percentage{ 0 };
+    qint64 bytesReceived{ 0 };
+    qint64 bytesTotal{ -1 };
+    double bytesPerSecond{ 0. };
+    qint64 remainingTime{ -1 };
+  };
+
+  // Downloads the installer with the policy, and returns the progress notifications.
+  const auto downloadInstaller = [this, &server](const QtDownloader::ProgressPolicy& policy) {
+    QTemporaryDir temporaryDir;
+    QtUpdater updater(server.url());
+    updater.setTemporaryDirectoryPath(temporaryDir.path());
+    updater.setProgressPolicy(policy);
+
+    auto done = false;
+    QVector<Notification> notifications;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+      updater.downloadInstaller();
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+      done = true;
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadProgressChanged, this,
+      [&notifications](int const percentage) {
+        notifications.append({ percentage });
+      });
+    QObject::connect(&updater, &QtUpdater::installerDownloadProgressDetailsChanged, this,
+      [&notifications](qint64 const bytesReceived, qint64 const bytesTotal, double const bytesPerSecond,
+        qint64 const remainingTime) {
+        auto& notification = notifications.last();
+        notification.bytesReceived = bytesReceived;
+        notification.bytesTotal = bytesTotal;
+        notification.bytesPerSecond = bytesPerSecond;
+        notification.remainingTime = remainingTime;
+      });
+    updater.forceCheckForUpdate();
+    QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+    return done ? notifications : QVector<Notification>{};
+  };
+
+  // Notifications are separated by the minimum interval.
+  auto policy = QtDownloader::ProgressPolicy{};
+  policy.minInterval = 1000;
+  policy.minDelta = 1;
+  auto notifications = downloadInstaller(policy);
+  QVERIFY(!notifications.isEmpty());
+  QVERIFY(notifications.size() <= 4);
+
+  // Then by the minimum delta.
+  policy.minInterval = 0;
+  policy.minDelta = 25;
+  notifications = downloadInstaller(policy);
+  QVERIFY(!notifications.isEmpty());
+  QVERIFY(notifications.size() <= 4);
+  for (auto i = 1; i < notifications.size() - 1; ++i) {
+    QVERIFY(notifications.at(i).percentage - notifications.at(i - 1).percentage >= policy.minDelta);
+  }
+
+  // The details grow with the percentage, and 100% is always notified, with the whole size received.
+  for (auto i = 1; i < notifications.size(); ++i) {
+    QVERIFY(notifications.at(i).percentage > notifications.at(i - 1).percentage);
+    QVERIFY(notifications.at(i).bytesReceived >= notifications.at(i - 1).bytesReceived);
+  }
+  for (const auto& notification : notifications) {
+    QCOMPARE(notification.bytesTotal, qint64{ installerData.size() });
+  }
+  const auto& last = notifications.last();
+  QCOMPARE(last.percentage, 100);
+  QCOMPARE(last.bytesReceived, qint64{ installerData.size() });
+  QCOMPARE(last.remainingTime, qint64{ 0 });
+  QVERIFY(last.bytesPerSecond > 0.);
+}
+
+void Tests::test_transferMetrics() {
+  // Server that answers the installer late, and fails to send the changelog.
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  const auto changelogPath = QString("/changelog-%1.0.md").arg(LATEST_VERSION);
+  const auto installerData = getLargeInstallerData(64 * 1024);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION, getInstallerChecksum(installerData)).toUtf8(), CONTENT_TYPE_JSON);
+  FaultProfile installerProfile;
+  installerProfile.latency = std::chrono::milliseconds(200);
+  server.serve(installerPath, installerData, CONTENT_TYPE_EXE, installerProfile);
+  FaultProfile changelogProfile;
+  changelogProfile.errorStatus = 503;
+  server.serve(changelogPath, DUMMY_CHANGELOG, CONTENT_TYPE_MD, changelogProfile);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+
+  auto done = false;
+  QVector<QtDownloader::TransferMetrics> allMetrics;
+  QObject::connect(&updater, &QtUpdater::transferMetricsAvailable, this,
+    [&allMetrics](const QtDownloader::TransferMetrics& metrics) {
+      allMetrics.append(metrics);
+    });
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+    updater.downloadInstaller();
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, &updater, [&updater]() {
+    updater.downloadChangelog();
+  });
+  QObject::connect(&updater, &QtUpdater::changelogDownloadFailed, this, [&done]() {
+    done = true;
+  });
+  updater.forceCheckForUpdate();
+  QVERIFY(QTest::qWaitFor(
+    [&done]() {
+      return done;
+    },
+    updater.checkTimeout()));
+
+  // One for each request, in order.
+  QCOMPARE(allMetrics.size(), 3);
+
+  // Successful download.
+  const auto& installerMetrics = allMetrics.at(1);
+  QCOMPARE(installerMetrics.url.path(), installerPath);
+  QVERIFY(installerMetrics.timeToFirstByte >= 200);
+  QVERIFY(installerMetrics.timeToFirstByte <= installerMetrics.totalTime);
+  QCOMPARE(installerMetrics.secureConnectionTime, qint64{ -1 }); // Not TLS.
+  QCOMPARE(installerMetrics.bytesDecoded, qint64{ installerData.size() });
+  QVERIFY(installerMetrics.bytesOnWire >= installerData.size());
+  QVERIFY(installerMetrics.averageBytesPerSecond > 0.);
+  QVERIFY(installerMetrics.peakBytesPerSecond >= installerMetrics.averageBytesPerSecond);
+  QCOMPARE(installerMetrics.retries, 0);
+  QCOMPARE(installerMetrics.failovers, 0);
+  QCOMPARE(installerMetrics.httpStatusCode, 200);
+  QCOMPARE(installerMetrics.error, QtDownloader::ErrorCode::NoError);
+  QCOMPARE(installerMetrics.networkError, 0);
+  QVERIFY(installerMetrics.errorString.isEmpty());
+
+  // Failed download.
+  const auto& changelogMetrics = allMetrics.at(2);
+  QCOMPARE(changelogMetrics.url.path(), changelogPath);
+  QVERIFY(changelogMetrics.timeToFirstByte >= 0);
+  QCOMPARE(changelogMetrics.httpStatusCode, 503);
+  QVERIFY(changelogMetrics.error != QtDownloader::ErrorCode::NoError);
+  QCOMPARE(changelogMetrics.networkError, static_cast<int>(QNetworkReply::ServiceUnavailableError));
+  QVERIFY(!changelogMetrics.errorString.isEmpty());
+}
+
+void Tests::test_blockManifestRepair() {
+  // Server that corrupts one byte of the second block, once.
+  constexpr auto blockSize = 64 * 1024;
+  const auto installerData = getLargeInstallerData(4 * blockSize);
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCastWithBlockManifest(LATEST_VERSION, installerData), CONTENT_TYPE_JSON);
+  server.serve("/installer.manifest", getBlockManifest(installerData, blockSize), CONTENT_TYPE_JSON);
+  FaultProfile profile;
+  profile.corruptAtOffset = blockSize + 100;
+  profile.corruptCount = 1;
+  server.serve(installerPath, installerData, CONTENT_TYPE_EXE, profile);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+
+  auto done = false;
+  auto error = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFailed, this, [&done, &error]() {
+    error = true;
+    done = true;
+  });
+  const auto wait = [&done, &updater]() {
+    return QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+  };
+
+  updater.forceCheckForUpdate();
+  QVERIFY(wait());
+  QVERIFY(updater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+
+  done = false;
+  updater.downloadInstaller();
+  QVERIFY(wait());
+
+  // Only the corrupted block is downloaded again.
+  QVERIFY(!error);
+  QVERIFY(updater.installerAvailable());
+  const auto rangeHeaders = server.rangeHeaders(installerPath);
+  QCOMPARE(rangeHeaders.size(), 2);
+  QVERIFY(rangeHeaders.at(0).isEmpty());
+  QCOMPARE(rangeHeaders.at(1), QString("bytes=%1-%2").arg(blockSize).arg(2 * blockSize - 1));
+}
+
+void Tests::test_blockManifestMismatch() {
+  // Server with a manifest that doesn't match the installer.
+  constexpr auto blockSize = 64 * 1024;
+  const auto installerData = getLargeInstallerData(16 * blockSize);
+  auto otherData = installerData;
+  std::reverse(otherData.begin(), otherData.end());
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCastWithBlockManifest(LATEST_VERSION, installerData), CONTENT_TYPE_JSON);
+  server.serve("/installer.manifest", getBlockManifest(otherData, blockSize), CONTENT_TYPE_JSON);
+  server.serve(installerPath, installerData, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+
+  auto done = false;
+  auto error = QtUpdater::ErrorCode::NoError;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFailed, this, [&done, &error](QtUpdater::ErrorCode e) {
+    error = e;
+    done = true;
+  });
+  const auto wait = [&done, &updater]() {
+    return QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+  };
+
+  updater.forceCheckForUpdate();
+  QVERIFY(wait());
+  QVERIFY(updater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+
+  done = false;
+  updater.downloadInstaller();
+  QVERIFY(wait());
+
+  // The download is aborted without trying to repair the blocks.
+  QCOMPARE(error, QtUpdater::ErrorCode::ChecksumError);
+  QVERIFY(!updater.installerAvailable());
+  QCOMPARE(server.requestCount(installerPath), 1);
+}
+
+void Tests::test_blockManifestScope() {
+  constexpr auto blockSize = 64 * 1024;
+  const auto installerData = getLargeInstallerData(4 * blockSize);
+  auto otherData = installerData;
+  std::reverse(otherData.begin(), otherData.end());
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  const auto changelogPath = QString("/changelog-%1.0.md").arg(LATEST_VERSION);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCastWithBlockManifest(LATEST_VERSION, installerData), CONTENT_TYPE_JSON);
+  server.serve("/installer.manifest", getBlockManifest(installerData, blockSize), CONTENT_TYPE_JSON);
+  server.serve(installerPath, installerData, CONTENT_TYPE_EXE);
+  server.serve(changelogPath, DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  QVERIFY(server.start());
+
+  // The manifest of the installer is not used to verify the changelog downloaded afterwards.
+  {
+    QTemporaryDir temporaryDir;
+    QtUpdater updater(server.url());
+    updater.setTemporaryDirectoryPath(temporaryDir.path());
+
+    auto done = false;
+    auto error = QtUpdater::ErrorCode::NoError;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+      updater.downloadInstaller();
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFinished, &updater, [&updater]() {
+      updater.downloadChangelog();
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFailed, this, [&done, &error](auto const e) {
+      error = e;
+      done = true;
+    });
+    QObject::connect(&updater, &QtUpdater::changelogDownloadFinished, this, [&done]() {
+      done = true;
+    });
+    QObject::connect(&updater, &QtUpdater::changelogDownloadFailed, this, [&done, &error](auto const e) {
+      error = e;
+      done = true;
+    });
+    updater.forceCheckForUpdate();
+    QVERIFY(QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout()));
+    QCOMPARE(error, QtUpdater::ErrorCode::NoError);
+    QVERIFY(updater.installerAvailable());
+    QVERIFY(updater.changelogAvailable());
+  }
+
+  // The prefetched installer is verified with the manifest too: it doesn't match the installer here.
+  server.serve("/installer.manifest", getBlockManifest(otherData, blockSize), CONTENT_TYPE_JSON);
+  {
+    QTemporaryDir temporaryDir;
+    QtUpdater updater(server.url());
+    updater.setTemporaryDirectoryPath(temporaryDir.path());
+    updater.setPrefetchEnabled(true);
+
+    auto checked = false;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&checked]() {
+      checked = true;
+    });
+    updater.forceCheckForUpdate();
+    QVERIFY(QTest::qWaitFor(
+      [&checked, &updater]() {
+        return checked && updater.changelogAvailable() && !updater.prefetching();
+      },
+      updater.checkTimeout()));
+    QVERIFY(!updater.installerAvailable());
+  }
+}
+
+void Tests::test_durableFiles() {
+  QTemporaryDir temporaryDir;
+  QDir const dir(temporaryDir.path());
+  const auto readFile = [](const QString& filePath) {
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray{};
+  };
+
+  // A committed file replaces the previous one, without leaving a temporary file.
+  const auto filePath = dir.absoluteFilePath("file.txt");
+  for (const auto& data : { QByteArray("first"), QByteArray("second") }) {
+    QSaveFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data);
+    QVERIFY(fileutils::commitDurably(file));
+  }
+  QCOMPARE(readFile(filePath), QByteArray("second"));
+  QCOMPARE(dir.entryList(QDir::Files), QStringList{ "file.txt" });
+
+  // A cancelled write keeps the previous file.
+  {
+    QSaveFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("third");
+    file.cancelWriting();
+    QVERIFY(!fileutils::commitDurably(file));
+  }
+  QCOMPARE(readFile(filePath), QByteArray("second"));
+  QCOMPARE(dir.entryList(QDir::Files), QStringList{ "file.txt" });
+
+  // A renamed file is complete, and the destination is never replaced.
+  const auto partialFilePath = dir.absoluteFilePath("file.part");
+  const auto renamedFilePath = dir.absoluteFilePath("renamed.txt");
+  {
+    QFile file(partialFilePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("renamed");
+    QVERIFY(fileutils::renameDurably(file, renamedFilePath));
+    QVERIFY(!file.isOpen());
+  }
+  QVERIFY(!QFile::exists(partialFilePath));
+  QCOMPARE(readFile(renamedFilePath), QByteArray("renamed"));
+  {
+    QFile file(filePath);
+    QVERIFY(!fileutils::renameDurably(file, renamedFilePath));
+  }
+  QCOMPARE(readFile(filePath), QByteArray("second"));
+  QCOMPARE(readFile(renamedFilePath), QByteArray("renamed"));
+
+  // The appcast is saved atomically, and replaces the previous one.
+  const auto jsonDir = dir.absoluteFilePath("json");
+  auto appCast = QJsonDocument::fromJson(getAppCast(CURRENT_VERSION).toUtf8()).object();
+  appCast.insert("installerUrl", SERVER_URL_FOR_CLIENT + "/installer.exe");
+  const auto [firstSaved, firstJSONFilePath] = UpdateJSON{ QJsonDocument(appCast).toJson() }.saveToFile(jsonDir);
+  QVERIFY(firstSaved);
+  appCast.insert("version", LATEST_VERSION);
+  const auto [saved, jsonFilePath] = UpdateJSON{ QJsonDocument(appCast).toJson() }.saveToFile(jsonDir);
+  QVERIFY(saved);
+  QCOMPARE(jsonFilePath, firstJSONFilePath);
+  QCOMPARE(UpdateJSON{ readFile(jsonFilePath) }.version, QVersionNumber::fromString(LATEST_VERSION));
+  QCOMPARE(QDir(jsonDir).entryList(QDir::Files), QStringList{ "installer.json" });
+}
+
+void Tests::test_moveInstallerToDir() {
+  // Server.
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve(getInstallerPath(LATEST_VERSION), DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QTemporaryDir temporaryDir;
+  QTemporaryDir destinationDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+  updater.setInstallMode(QtUpdater::InstallMode::MoveFileToDir);
+  updater.setInstallerDestinationDir(destinationDir.path());
+
+  auto done = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  const auto wait = [&done, &updater]() {
+    return QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+  };
+
+  updater.forceCheckForUpdate();
+  QVERIFY(wait());
+  done = false;
+  updater.downloadInstaller();
+  QVERIFY(wait());
+
+  // Install update: the installer is moved to the destination directory, in a worker thread.
+  auto installationFinished = false;
+  auto installationFailed = false;
+  QObject::connect(&updater, &QtUpdater::installationFinished, this, [&installationFinished]() {
+    installationFinished = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installationFailed, this, [&installationFailed]() {
+    installationFailed = true;
+  });
+  updater.installUpdate();
+  QVERIFY(!installationFinished);
+  QCOMPARE(updater.state(), QtUpdater::State::InstallingUpdate);
+  QVERIFY(QTest::qWaitFor(
+    [&installationFinished, &installationFailed]() {
+      return installationFinished || installationFailed;
+    },
+    updater.checkTimeout()));
+  QVERIFY(installationFinished);
+  QVERIFY(!installationFailed);
+  QCOMPARE(updater.state(), QtUpdater::State::Idle);
+
+  const auto installerFileName = getInstallerPath(LATEST_VERSION).mid(1);
+  QVERIFY(!QFile::exists(temporaryDir.filePath(installerFileName)));
+  QFile movedInstaller(destinationDir.filePath(installerFileName));
+  QVERIFY(movedInstaller.open(QIODevice::ReadOnly));
+  QCOMPARE(movedInstaller.readAll(), QByteArray(DUMMY_INSTALLER_DATA));
+}
+
+void Tests::test_copyMethods() {
+  QTemporaryDir temporaryDir;
+  const auto data = getLargeInstallerData(1024 * 1024);
+  const auto createFile = [&data](const QString& filePath) {
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+  };
+  const auto readFile = [](const QString& filePath) {
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray{};
+  };
+  auto progressCount = 0;
+  auto lastProgress = qint64{ 0 };
+  const auto onProgress = [&progressCount, &lastProgress](qint64 const bytesCopied, qint64 const bytesTotal) {
+    Q_UNUSED(bytesTotal);
+    ++progressCount;
+    lastProgress = bytesCopied;
+  };
+
+  const auto sourcePath = temporaryDir.filePath("source.bin");
+  QVERIFY(createFile(sourcePath));
+
+  // Reflink clone or in-kernel copy (Linux only), else streamed copy.
+  const auto clonedPath = temporaryDir.filePath("cloned.bin");
+  const auto cloneMethod = fileutils::copyFile(sourcePath, clonedPath, onProgress);
+  QVERIFY(cloneMethod.has_value());
+#if defined(Q_OS_LINUX)
+  QVERIFY(cloneMethod == fileutils::MoveMethod::Clone);
+#else
+  QVERIFY(cloneMethod == fileutils::MoveMethod::Copy);
+#endif
+  QCOMPARE(readFile(clonedPath), data);
+  QVERIFY(progressCount > 0);
+  QCOMPARE(lastProgress, qint64{ data.size() });
+
+  // Streamed copy, replacing the destination.
+  progressCount = 0;
+  lastProgress = 0;
+  QVERIFY(createFile(temporaryDir.filePath("copied.bin")));
+  const auto copyMethod = fileutils::copyFile(sourcePath, temporaryDir.filePath("copied.bin"), onProgress, false);
+  QVERIFY(copyMethod == fileutils::MoveMethod::Copy);
+  QCOMPARE(readFile(temporaryDir.filePath("copied.bin")), data);
+  QVERIFY(progressCount > 0);
+  QCOMPARE(lastProgress, qint64{ data.size() });
+  QVERIFY(QFile::exists(sourcePath));
+
+  // Same volume: renamed.
+  const auto renamedPath = temporaryDir.filePath("renamed.bin");
+  QVERIFY(fileutils::moveFile(clonedPath, renamedPath) == fileutils::MoveMethod::Rename);
+  QVERIFY(!QFile::exists(clonedPath));
+  QCOMPARE(readFile(renamedPath), data);
+
+  // Another volume: copied, then the source is removed.
+  const auto otherVolumePath = QStringLiteral("/dev/shm");
+  if (!QFileInfo(otherVolumePath).isWritable()
+      || QStorageInfo(otherVolumePath).rootPath() == QStorageInfo(temporaryDir.path()).rootPath()) {
+    QSKIP("No other writable volume");
+  }
+  QTemporaryDir otherVolumeDir(otherVolumePath + "/QtUpdaterTests-XXXXXX");
+  QVERIFY(otherVolumeDir.isValid());
+  const auto movedPath = otherVolumeDir.filePath("moved.bin");
+  const auto moveMethod = fileutils::moveFile(renamedPath, movedPath);
+  QVERIFY(moveMethod.has_value());
+  QVERIFY(moveMethod != fileutils::MoveMethod::Rename);
+  QVERIFY(!QFile::exists(renamedPath));
+  QCOMPARE(readFile(movedPath), data);
+}
+
+void Tests::test_appImageInstallStrategy() {
+  QTemporaryDir temporaryDir;
+  const auto appImagePath = temporaryDir.filePath("MyApp.AppImage");
+  const auto downloadedPath = temporaryDir.filePath("MyApp-2.0.0.AppImage");
+  for (const auto& [path, content] : { std::make_pair(appImagePath, "old"), std::make_pair(downloadedPath, "new") }) {
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(content);
+  }
+
+  QtAppImageInstallStrategy strategy(appImagePath);
+  const auto result = strategy.install({ downloadedPath, QVersionNumber(2, 0, 0) }, nullptr);
+  QVERIFY(result == QtInstallStrategy::Result::Success);
+
+  // The AppImage is replaced, and executable.
+  QVERIFY(!QFile::exists(downloadedPath));
+  QFile appImage(appImagePath);
+  QVERIFY(appImage.permissions() & QFileDevice::ExeOwner);
+  QVERIFY(appImage.open(QIODevice::ReadOnly));
+  QCOMPARE(appImage.readAll(), QByteArray("new"));
+
+  // The AppImage can't be written.
+  QFile downloadedFile(downloadedPath);
+  QVERIFY(downloadedFile.open(QIODevice::WriteOnly));
+  downloadedFile.write("newer");
+  downloadedFile.close();
+  QtAppImageInstallStrategy invalidStrategy(temporaryDir.filePath("missing/MyApp.AppImage"));
+  QVERIFY(invalidStrategy.install({ downloadedPath, QVersionNumber(3, 0, 0) }, nullptr)
+          == QtInstallStrategy::Result::DiskError);
+  QVERIFY(QFile::exists(downloadedPath));
+}
+
+void Tests::test_archiveInstallStrategy() {
+#if defined(Q_OS_WIN)
+  QSKIP("Symbolic links are not supported on Windows");
+#else
+  // Create an archive for each version.
+  QTemporaryDir temporaryDir;
+  const auto createArchive = [&temporaryDir](const QString& version) {
+    return getArchivePath(temporaryDir.path(), version);
+  };
+  const auto readVersion = [](const QString& installDir) {
+    QFile file(installDir + "/current/bin/version.txt");
+    return file.open(QIODevice::ReadOnly) ? QString::fromUtf8(file.readAll()) : QString{};
+  };
+
+  const auto archive1 = createArchive("1.0.0");
+  const auto archive2 = createArchive("2.0.0");
+  if (archive1.isEmpty() || archive2.isEmpty()) {
+    QSKIP("tar is not available");
+  }
+
+  const auto installDir = temporaryDir.filePath("install");
+  QtArchiveInstallStrategy strategy(installDir);
+
+  QVERIFY(strategy.install({ archive1, QVersionNumber(1, 0, 0) }, nullptr) == QtInstallStrategy::Result::Success);
+  QCOMPARE(readVersion(installDir), QString("1.0.0"));
+
+  // The link now points to the new version, and the previous one is kept.
+  QVERIFY(strategy.install({ archive2, QVersionNumber(2, 0, 0) }, nullptr) == QtInstallStrategy::Result::Success);
+  QCOMPARE(readVersion(installDir), QString("2.0.0"));
+  QCOMPARE(QFileInfo(installDir + "/current").symLinkTarget(), QFileInfo(installDir + "/2.0.0").absoluteFilePath());
+  QVERIFY(QFileInfo::exists(installDir + "/1.0.0/bin/version.txt"));
+  QVERIFY(!QFileInfo::exists(installDir + "/2.0.0.staging"));
+
+  // Same version again: the directory the link points to is kept, and the oldest version is removed.
+  QVERIFY(strategy.install({ archive2, QVersionNumber(2, 0, 0) }, nullptr) == QtInstallStrategy::Result::Success);
+  QCOMPARE(readVersion(installDir), QString("2.0.0"));
+  QCOMPARE(QFileInfo(installDir + "/current").symLinkTarget(), QFileInfo(installDir + "/2.0.0-1").absoluteFilePath());
+  QVERIFY(QFileInfo::exists(installDir + "/2.0.0/bin/version.txt"));
+  QVERIFY(!QFileInfo::exists(installDir + "/1.0.0"));
+
+  // Going back to a removed version.
+  QVERIFY(strategy.install({ archive1, QVersionNumber(1, 0, 0) }, nullptr) == QtInstallStrategy::Result::Success);
+  QCOMPARE(readVersion(installDir), QString("1.0.0"));
+  QCOMPARE(QFileInfo(installDir + "/current").symLinkTarget(), QFileInfo(installDir + "/1.0.0").absoluteFilePath());
+  QVERIFY(QFileInfo::exists(installDir + "/2.0.0-1/bin/version.txt"));
+  QVERIFY(!QFileInfo::exists(installDir + "/2.0.0"));
+
+  // An invalid archive can't be extracted: the installation is untouched.
+  const auto invalidArchive = temporaryDir.filePath("invalid.tar.gz");
+  QFile invalidArchiveFile(invalidArchive);
+  QVERIFY(invalidArchiveFile.open(QIODevice::WriteOnly));
+  invalidArchiveFile.write(DUMMY_INSTALLER_DATA);
+  invalidArchiveFile.close();
+  QVERIFY(
+    strategy.install({ invalidArchive, QVersionNumber(3, 0, 0) }, nullptr) == QtInstallStrategy::Result::Failure);
+  QCOMPARE(readVersion(installDir), QString("1.0.0"));
+  QVERIFY(!QFileInfo::exists(installDir + "/3.0.0"));
+  QVERIFY(!QFileInfo::exists(installDir + "/3.0.0.staging"));
+
+  // The installation directory can't be created.
+  QtArchiveInstallStrategy invalidStrategy(invalidArchive + "/install");
+  QVERIFY(
+    invalidStrategy.install({ archive1, QVersionNumber(1, 0, 0) }, nullptr) == QtInstallStrategy::Result::DiskError);
+#endif
+}
+
+void Tests::test_streamingExtraction() {
+#if defined(Q_OS_WIN)
+  QSKIP("Extraction relies on tar");
+#else
+  QTemporaryDir temporaryDir;
+  const auto archivePath = getArchivePath(temporaryDir.path(), LATEST_VERSION);
+  if (archivePath.isEmpty()) {
+    QSKIP("tar is not available");
+  }
+  const auto otherArchivePath = getArchivePath(temporaryDir.path(), "1.0.0");
+  QVERIFY(!otherArchivePath.isEmpty());
+  const auto readArchive = [](const QString& path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray{};
+  };
+  const auto readVersion = [](const QString& dir) {
+    QFile file(dir + "/bin/version.txt");
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray{};
+  };
+  const auto archiveData = readArchive(archivePath);
+  const auto otherArchiveData = readArchive(otherArchivePath);
+
+  // Server. The throttled archive lets a block mismatch abort the transfer before its end.
+  constexpr auto blockSize = 16;
+  TestServer server(SERVER_PORT);
+  server.serve("/MyApp.tar.gz", archiveData, "application/gzip");
+  server.serve("/MyApp-1.0.0.tar.gz", otherArchiveData, "application/gzip");
+  FaultProfile throttledProfile;
+  throttledProfile.bytesPerSecond = 8 * blockSize;
+  server.serve("/MyApp-throttled.tar.gz", archiveData, "application/gzip", throttledProfile);
+  QVERIFY(server.start());
+  auto url = QUrl(server.url() + "/MyApp.tar.gz");
+
+  QtDownloader downloader;
+  const auto download = [&downloader, &url](const QString& localDir) {
+    auto done = false;
+    auto result = QtDownloader::ErrorCode::NoError;
+    downloader.downloadFile(url, localDir, [&done, &result](QtDownloader::ErrorCode const error, const QString&) {
+      result = error;
+      done = true;
+    });
+    QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      QtDownloader::DefaultTimeout);
+    return result;
+  };
+
+  // The archive is extracted and verified while it is downloaded.
+  const auto installDir = temporaryDir.filePath("install/" + QString(LATEST_VERSION));
+  downloader.setExtractionOptions({ true, getInstallerChecksum(archiveData), QtDownloader::ChecksumType::MD5 });
+  QCOMPARE(download(installDir), QtDownloader::ErrorCode::NoError);
+  QFile versionFile(installDir + "/bin/version.txt");
+  QVERIFY(versionFile.open(QIODevice::ReadOnly));
+  QCOMPARE(versionFile.readAll(), QByteArray(LATEST_VERSION));
+  QVERIFY(!QFileInfo::exists(installDir + ".staging"));
+  QVERIFY(!QFileInfo::exists(temporaryDir.filePath("install/MyApp.tar.gz")));
+
+  // With an invalid checksum, the extracted content is discarded.
+  const auto otherDir = temporaryDir.filePath("install/other");
+  downloader.setExtractionOptions({ true, QString(32, '0'), QtDownloader::ChecksumType::MD5 });
+  QCOMPARE(download(otherDir), QtDownloader::ErrorCode::FileDoesNotExistOrIsCorrupted);
+  QVERIFY(!QFileInfo::exists(otherDir));
+  QVERIFY(!QFileInfo::exists(otherDir + ".staging"));
+
+  // The previous content is replaced once the new one is complete.
+  url = QUrl(server.url() + "/MyApp-1.0.0.tar.gz");
+  downloader.setExtractionOptions({ true, getInstallerChecksum(otherArchiveData), QtDownloader::ChecksumType::MD5 });
+  QCOMPARE(download(installDir), QtDownloader::ErrorCode::NoError);
+  QCOMPARE(readVersion(installDir), QByteArray("1.0.0"));
+  QVERIFY(!QFileInfo::exists(installDir + ".staging"));
+  QVERIFY(!QFileInfo::exists(installDir + ".previous"));
+
+  // A block mismatch aborts the transfer, and is reported as such. The previous content is kept.
+  auto otherData = archiveData;
+  std::reverse(otherData.begin(), otherData.end());
+  url = QUrl(server.url() + "/MyApp-throttled.tar.gz");
+  downloader.setExtractionOptions({ true, getInstallerChecksum(archiveData), QtDownloader::ChecksumType::MD5 });
+  downloader.setBlockManifest(QtDownloader::BlockManifest::fromJSON(getBlockManifest(otherData, blockSize)));
+  QCOMPARE(download(installDir), QtDownloader::ErrorCode::BlockVerificationFailed);
+  QCOMPARE(readVersion(installDir), QByteArray("1.0.0"));
+  QVERIFY(!QFileInfo::exists(installDir + ".staging"));
+#endif
+}
+
+void Tests::test_prefetch() {
+  // Server.
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve("/changelog-" + QString(LATEST_VERSION) + ".0.md", DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  server.serve(getInstallerPath(LATEST_VERSION), DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+  updater.setPrefetchEnabled(true);
+
+  auto checked = false;
+  auto downloadStarted = false;
+  auto stateChangedDuringPrefetch = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&checked]() {
+    checked = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadStarted, this, [&downloadStarted]() {
+    downloadStarted = true;
+  });
+  QObject::connect(&updater, &QtUpdater::stateChanged, this, [&updater, &checked, &stateChangedDuringPrefetch]() {
+    if (checked && updater.state() != QtUpdater::State::Idle) {
+      stateChangedDuringPrefetch = true;
+    }
+  });
+
+  updater.forceCheckForUpdate();
+  QVERIFY(QTest::qWaitFor(
+    [&checked]() {
+      return checked;
+    },
+    updater.checkTimeout()));
+  QVERIFY(updater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+
+  // The changelog and the installer are downloaded without any visible download.
+  QVERIFY(QTest::qWaitFor(
+    [&updater]() {
+      return updater.installerAvailable() && !updater.prefetching();
+    },
+    updater.checkTimeout()));
+  QVERIFY(updater.changelogAvailable());
+  QVERIFY(!downloadStarted);
+  QVERIFY(!stateChangedDuringPrefetch);
+
+  // Asking for the installer doesn't download it again.
+  auto downloadFinished = false;
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&downloadFinished]() {
+    downloadFinished = true;
+  });
+  updater.downloadInstaller();
+  QVERIFY(downloadFinished);
+  QCOMPARE(server.requestCount(getInstallerPath(LATEST_VERSION)), 1);
+}
+
+void Tests::test_prefetchPromotion() {
+  // Server.
+  const auto installerData = getLargeInstallerData(1024 * 1024);
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION, getInstallerChecksum(installerData)).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve("/changelog-" + QString(LATEST_VERSION) + ".0.md", DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  server.serve(installerPath, installerData, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Configure updater, with a prefetch that would last more than ten seconds.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+  updater.setPrefetchEnabled(true);
+  updater.setPrefetchBandwidthLimit(64 * 1024);
+
+  auto done = false;
+  auto error = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFailed, this, [&done, &error]() {
+    error = true;
+    done = true;
+  });
+  const auto wait = [&done, &updater]() {
+    return QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+  };
+
+  updater.forceCheckForUpdate();
+  QVERIFY(wait());
+  QVERIFY(updater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+
+  // The changelog is prefetched first, then the installer.
+  QVERIFY(QTest::qWaitFor(
+    [&updater]() {
+      return updater.changelogAvailable();
+    },
+    updater.checkTimeout()));
+  QVERIFY(updater.prefetching());
+
+  // The user asks for the installer: the background download continues at full speed.
+  QElapsedTimer timer;
+  timer.start();
+  done = false;
+  updater.downloadInstaller();
+  QCOMPARE(updater.state(), QtUpdater::State::DownloadingInstaller);
+  QVERIFY(wait());
+  QVERIFY(!error);
+  QVERIFY(updater.installerAvailable());
+  QVERIFY(timer.elapsed() < 10000);
+  QCOMPARE(server.requestCount(installerPath), 1);
+}
+
+void Tests::test_prefetchBusyEventLoop() {
+  // Server.
+  const auto installerData = getLargeInstallerData(512 * 1024);
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION, getInstallerChecksum(installerData)).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve("/changelog-" + QString(LATEST_VERSION) + ".0.md", DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  server.serve(installerPath, installerData, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Configure updater, with a prefetch that lasts about eight seconds.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+  updater.setPrefetchEnabled(true);
+  updater.setPrefetchBandwidthLimit(64 * 1024);
+
+  updater.forceCheckForUpdate();
+  QVERIFY(QTest::qWaitFor(
+    [&server, &installerPath]() {
+      return server.requestCount(installerPath) == 1;
+    },
+    updater.checkTimeout()));
+
+  // Isolated slow events don't pause the prefetch.
+  for (auto i = 0; i < 3; ++i) {
+    QThread::msleep(300);
+    QTest::qWait(300);
+  }
+  QVERIFY(updater.prefetching());
+  QCOMPARE(server.requestCount(installerPath), 1);
+
+  // A busy event loop pauses it. It resumes where it stopped once the event loop is idle again.
+  QElapsedTimer busyTimer;
+  busyTimer.start();
+  while (busyTimer.elapsed() < 1500) {
+    QThread::msleep(150);
+    QCoreApplication::processEvents();
+  }
+  QVERIFY(QTest::qWaitFor(
+    [&updater]() {
+      return updater.installerAvailable() && !updater.prefetching();
+    },
+    20000));
+  QCOMPARE(server.requestCount(installerPath), 2);
+  QVERIFY(server.rangeHeaders(installerPath).last().startsWith("bytes="));
+}
+
+void Tests::test_workerThread() {
+  // Server.
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve("/changelog-" + QString(LATEST_VERSION) + ".0.md", DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  server.serve(getInstallerPath(LATEST_VERSION), DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Updater in a worker thread, controller in this thread.
+  QTemporaryDir temporaryDir;
+  QThread workerThread;
+  auto* updater = new QtUpdater(server.url());
+  updater->setTemporaryDirectoryPath(temporaryDir.path());
+  updater->moveToThread(&workerThread);
+  QObject::connect(&workerThread, &QThread::finished, updater, &QObject::deleteLater);
+  workerThread.start();
+
+  QtUpdateController controller(*updater);
+  const auto waitForState = [&controller, updater](QtUpdateController::State const state) {
+    return QTest::qWaitFor(
+      [&controller, state]() {
+        return controller.state() == state;
+      },
+      updater->checkTimeout());
+  };
+
+  // Network and disk work happen in the worker thread.
+  std::atomic_bool workerThreadUsed{ false };
+  std::atomic_bool otherThreadUsed{ false };
+  QObject::connect(updater, &QtUpdater::transferMetricsAvailable, updater,
+    [&workerThreadUsed, &otherThreadUsed, &workerThread]() {
+      if (QThread::currentThread() == &workerThread) {
+        workerThreadUsed = true;
+      } else {
+        otherThreadUsed = true;
+      }
+    });
+
+  controller.forceCheckForUpdate();
+  QVERIFY(waitForState(QtUpdateController::State::CheckingSuccess));
+  QCOMPARE(controller.latestVersion(), QString(LATEST_VERSION));
+
+  controller.downloadUpdate();
+  QVERIFY(waitForState(QtUpdateController::State::DownloadingSuccess));
+  QVERIFY(workerThreadUsed);
+  QVERIFY(!otherThreadUsed);
+
+  workerThread.quit();
+  QVERIFY(workerThread.wait());
+}
+
+void Tests::test_asyncApi() {
+  // Server.
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve("/changelog-" + QString(LATEST_VERSION) + ".0.md", DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  server.serve(getInstallerPath(LATEST_VERSION), DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Configure updater.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+  updater.setParanoidVerification(true);
+  const auto wait = [&updater](const QFuture<QtUpdater::ErrorCode>& future) {
+    return QTest::qWaitFor(
+      [&future]() {
+        return future.isFinished();
+      },
+      updater.checkTimeout());
+  };
+
+  // Canceling the future cancels the operation.
+  auto check = updater.checkForUpdateAsync(true);
+  QCOMPARE(updater.state(), QtUpdater::State::CheckingForUpdate);
+  check.cancel();
+  QVERIFY(wait(check));
+  QVERIFY(check.isCanceled());
+  QCOMPARE(updater.state(), QtUpdater::State::Idle);
+
+  check = updater.checkForUpdateAsync(true);
+  QVERIFY(wait(check));
+  QVERIFY(!check.isCanceled());
+  QCOMPARE(check.result(), QtUpdater::ErrorCode::NoError);
+  QVERIFY(updater.updateAvailability() == QtUpdater::UpdateAvailability::Available);
+
+  // Only one operation at a time.
+  const auto changelog = updater.downloadChangelogAsync();
+  const auto busy = updater.downloadInstallerAsync();
+  QVERIFY(busy.isFinished());
+  QVERIFY(busy.isCanceled());
+  QVERIFY(wait(changelog));
+  QCOMPARE(changelog.result(), QtUpdater::ErrorCode::NoError);
+  QVERIFY(updater.changelogAvailable());
+
+  const auto installer = updater.downloadInstallerAsync();
+  QVERIFY(wait(installer));
+  QCOMPARE(installer.result(), QtUpdater::ErrorCode::NoError);
+  QVERIFY(updater.installerAvailable());
+
+  // Hashed in a worker thread. The installer can't be replaced or installed meanwhile.
+  auto verification = updater.verifyInstallerAsync();
+  QCOMPARE(updater.state(), QtUpdater::State::VerifyingInstaller);
+  const auto busyInstaller = updater.downloadInstallerAsync();
+  QVERIFY(busyInstaller.isFinished());
+  QVERIFY(busyInstaller.isCanceled());
+  QVERIFY(wait(verification));
+  QCOMPARE(verification.result(), QtUpdater::ErrorCode::NoError);
+  QCOMPARE(updater.state(), QtUpdater::State::Idle);
+  QVERIFY(updater.installerAvailable());
+
+  // Cancelling the verification keeps the installer.
+  verification = updater.verifyInstallerAsync();
+  QCOMPARE(updater.state(), QtUpdater::State::VerifyingInstaller);
+  updater.cancel();
+  QCOMPARE(updater.state(), QtUpdater::State::Idle);
+  QVERIFY(wait(verification));
+  QVERIFY(verification.isCanceled());
+  QVERIFY(updater.installerAvailable());
+
+  verification = updater.verifyInstallerAsync();
+  verification.cancel();
+  QVERIFY(QTest::qWaitFor(
+    [&updater]() {
+      return updater.state() == QtUpdater::State::Idle;
+    },
+    updater.checkTimeout()));
+  QVERIFY(verification.isCanceled());
+  QVERIFY(updater.installerAvailable());
+}
+
+void Tests::test_multipleApplications() {
+  // Server.
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  QVERIFY(server.start());
+
+  // Updaters of two other applications, with their own settings, sharing the same connections.
+  QNetworkAccessManager networkAccessManager;
+  QTemporaryDir temporaryDir;
+  const auto createUpdater = [&server, &temporaryDir, &networkAccessManager](
+                               const QString& application, const QString& currentVersion) {
+    const auto settingsParameters = QtUpdater::SettingsParameters{ QSettings::NativeFormat, QSettings::UserScope,
+      QCoreApplication::organizationName(), application };
+    auto updater = std::make_unique<QtUpdater>(server.url(), settingsParameters);
+    updater->setTemporaryDirectoryPath(QDir(temporaryDir.path()).absoluteFilePath(application));
+    updater->setCurrentVersion(currentVersion);
+    updater->setNetworkAccessManager(&networkAccessManager);
+    return updater;
+  };
+  const auto outdated = createUpdater("OutdatedApplication", CURRENT_VERSION);
+  const auto upToDate = createUpdater("UpToDateApplication", LATEST_VERSION);
+  QCOMPARE(upToDate->currentVersion(), QString(LATEST_VERSION));
+
+  auto finishedCount = 0;
+  for (const auto* updater : { outdated.get(), upToDate.get() }) {
+    QObject::connect(updater, &QtUpdater::checkForUpdateFinished, this, [&finishedCount]() {
+      ++finishedCount;
+    });
+  }
+  outdated->forceCheckForUpdate();
+  upToDate->forceCheckForUpdate();
+  QVERIFY(QTest::qWaitFor(
+    [&finishedCount]() {
+      return finishedCount == 2;
+    },
+    outdated->checkTimeout()));
+
+  QVERIFY(outdated->updateAvailability() == QtUpdater::UpdateAvailability::Available);
+  QVERIFY(upToDate->updateAvailability() == QtUpdater::UpdateAvailability::UpToDate);
+
+  // The availability follows the current version.
+  upToDate->setCurrentVersion(CURRENT_VERSION);
+  QVERIFY(upToDate->updateAvailability() == QtUpdater::UpdateAvailability::Available);
+}
+
+void Tests::test_updateAgent() {
+  // Server.
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve("/changelog-" + QString(LATEST_VERSION) + ".0.md", DUMMY_CHANGELOG, CONTENT_TYPE_MD);
+  server.serve(installerPath, DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Agent with one download at a time.
+  QTemporaryDir temporaryDir;
+  QtUpdateAgent agent(temporaryDir.path());
+  agent.setMaxConcurrentDownloads(1);
+  QVERIFY(agent.addTarget({ "first", server.url(), CURRENT_VERSION }));
+  QVERIFY(agent.addTarget({ "alias", server.url(), CURRENT_VERSION }));
+  QVERIFY(agent.addTarget({ "second", server.url(), "1.5.0" }));
+  QVERIFY(!agent.addTarget({ "first", server.url(), "1.5.0" }));
+  QVERIFY(!agent.addTarget({ {}, server.url(), "1.5.0" }));
+  QCOMPARE(agent.targetIds(), QStringList({ "alias", "first", "second" }));
+  QVERIFY(agent.targetStatus("unknown").isEmpty());
+
+  // Same server and version: same updater and same files.
+  const auto directory = [&agent](const QString& id) {
+    return agent.targetStatus(id).value("directory").toString();
+  };
+  QCOMPARE(directory("first"), directory("alias"));
+  QVERIFY(directory("first") != directory("second"));
+
+  auto maxRunningDownloads = 0;
+  QObject::connect(&agent, &QtUpdateAgent::targetStatusChanged, this, [&agent, &maxRunningDownloads]() {
+    auto runningDownloads = 0;
+    for (const auto& id : { "first", "second" }) {
+      const auto status = agent.targetStatus(id);
+      if (status.value("downloading").toBool() && !status.value("paused").toBool()) {
+        ++runningDownloads;
+      }
+    }
+    maxRunningDownloads = std::max(maxRunningDownloads, runningDownloads);
+  });
+  const auto installerAvailable = [&agent]() {
+    const auto targetIds = agent.targetIds();
+    return std::all_of(targetIds.begin(), targetIds.end(), [&agent](const QString& id) {
+      const auto status = agent.targetStatus(id);
+      return status.value("installerAvailable").toBool() && !status.value("downloading").toBool();
+    });
+  };
+
+  agent.checkForUpdates(true);
+  QVERIFY(QTest::qWaitFor(installerAvailable, 2 * QtDownloader::DefaultTimeout));
+  QCOMPARE(maxRunningDownloads, 1);
+
+  // The installer is downloaded once: the second target takes it from the shared cache.
+  QCOMPARE(server.requestCount(installerPath), 1);
+  QVERIFY(QDir(temporaryDir.filePath("shared")).exists());
+
+  // Applications query the agent over a local socket.
+  QtUpdateAgentServer agentServer(agent);
+  const auto serverName =
+    QString("%1-tests-%2").arg(QtUpdateAgentServer::DefaultName).arg(QCoreApplication::applicationPid());
+  QVERIFY(agentServer.listen(serverName));
+  const auto query = [&serverName](const QByteArray& request) {
+    // Blocking: the agent answers from this thread.
+    std::atomic_bool done{ false };
+    QByteArray answer;
+    std::thread client([&done, &answer, &request, &serverName]() {
+      answer = QtUpdateAgentServer::query(request, serverName);
+      done = true;
+    });
+    QTest::qWaitFor(
+      [&done]() {
+        return done.load();
+      },
+      2 * QtUpdateAgentServer::DefaultTimeout);
+    client.join();
+    return QJsonDocument::fromJson(answer).object();
+  };
+
+  const auto status = query(R"({"target":"second"})");
+  QCOMPARE(status.value("id").toString(), QString("second"));
+  QCOMPARE(status.value("currentVersion").toString(), QString("1.5.0"));
+  QCOMPARE(status.value("latestVersion").toString(), QString(LATEST_VERSION));
+  QVERIFY(status.value("installerAvailable").toBool());
+  QCOMPARE(query("{}").value("targets").toArray().size(), 3);
+
+  // A second agent doesn't take the name of the running one.
+  QtUpdateAgentServer otherAgentServer(agent);
+  QVERIFY(!otherAgentServer.listen(serverName));
+  QVERIFY(!otherAgentServer.errorString().isEmpty());
+  QCOMPARE(query(R"({"target":"second"})").value("id").toString(), QString("second"));
+}
+
+void Tests::test_sharedCache() {
+  // Server.
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  server.serve(installerPath, DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  QVERIFY(server.start());
+
+  // Two updaters with their own directory, and the same shared cache.
+  QTemporaryDir temporaryDir;
+  const auto sharedCacheDir = QDir(temporaryDir.path()).absoluteFilePath("shared");
+  const auto downloadInstaller = [&server, &temporaryDir, &sharedCacheDir](const QString& name) {
+    QtUpdater updater(server.url());
+    updater.setTemporaryDirectoryPath(QDir(temporaryDir.path()).absoluteFilePath(name));
+    updater.setSharedCacheDirectory(sharedCacheDir);
+
+    auto done = false;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+      updater.downloadInstaller();
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFinished, &updater, [&done]() {
+      done = true;
+    });
+    updater.forceCheckForUpdate();
+    return QTest::qWaitFor(
+             [&done]() {
+               return done;
+             },
+             updater.checkTimeout())
+           && updater.installerAvailable();
+  };
+
+  QVERIFY(downloadInstaller("first"));
+  QCOMPARE(server.requestCount(installerPath), 1);
+  QCOMPARE(QDir(sharedCacheDir).entryList(QDir::Files).size(), 2); // Installer and its last use.
+
+  // The second one takes the installer from the cache.
+  QVERIFY(downloadInstaller("second"));
+  QCOMPARE(server.requestCount(installerPath), 1);
+
+  // Installing it leaves the cached installer untouched, although the retrieved file may be a link to it.
+  const auto cachedFiles = QDir(sharedCacheDir).entryInfoList({ "*" }, QDir::Files);
+  const auto cachedInstaller = std::find_if(cachedFiles.begin(), cachedFiles.end(), [](const QFileInfo& info) {
+    return info.suffix() != "used";
+  });
+  QVERIFY(cachedInstaller != cachedFiles.end());
+  const auto cachedInstallerPath = cachedInstaller->absoluteFilePath();
+  const auto cachedPermissions = QFile::permissions(cachedInstallerPath);
+  const auto cachedFileId = getFileId(cachedInstallerPath);
+  const auto appImagePath = QDir(temporaryDir.path()).absoluteFilePath("MyApp.AppImage");
+  QtAppImageInstallStrategy strategy(appImagePath);
+  QVERIFY(strategy.install({ QDir(temporaryDir.path()).absoluteFilePath("second" + installerPath),
+                             QVersionNumber(2, 0, 0) },
+            nullptr)
+          == QtInstallStrategy::Result::Success);
+  QCOMPARE(QFile::permissions(cachedInstallerPath), cachedPermissions);
+  QCOMPARE(getFileId(cachedInstallerPath), cachedFileId);
+  QVERIFY(getFileId(appImagePath) != cachedFileId || cachedFileId == 0);
+
+  // A tampered installer is removed from the cache, and downloaded again.
+  QVERIFY(QFile::remove(cachedInstallerPath));
+  {
+    QFile file(cachedInstallerPath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("tampered");
+  }
+  QVERIFY(downloadInstaller("third"));
+  QCOMPARE(server.requestCount(installerPath), 2);
+  QFile file(cachedInstallerPath);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QCOMPARE(file.readAll(), QByteArray(DUMMY_INSTALLER_DATA));
+}
+
+void Tests::test_peerDownload() {
+#if !defined(Q_OS_LINUX)
+  QSKIP("The updaters of several processes only receive the same discovery datagram on Linux");
+#else
+  // Server: two updates with a SHA-256 checksum, and the first one again with an MD5 checksum.
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  const auto otherVersion = QString("3.0.0");
+  const auto otherInstallerPath = getInstallerPath(otherVersion);
+  const auto otherInstallerData = getLargeInstallerData(1024);
+  TestServer server(SERVER_PORT);
+  server.serve("/", getSha256AppCast(LATEST_VERSION, DUMMY_INSTALLER_DATA), CONTENT_TYPE_JSON);
+  server.serve(installerPath, DUMMY_INSTALLER_DATA, CONTENT_TYPE_EXE);
+  server.serve("/other", getSha256AppCast(otherVersion, otherInstallerData), CONTENT_TYPE_JSON);
+  server.serve(otherInstallerPath, otherInstallerData, CONTENT_TYPE_EXE);
+  server.serve("/md5", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON);
+  QVERIFY(server.start());
+
+  const auto discoveryPort = SERVER_PORT + 1;
+  QTemporaryDir temporaryDir;
+
+  // Peers in other processes, killed at the end of the test.
+  std::vector<std::unique_ptr<QProcess>> sharers;
+  const auto startSharer = [&server, &temporaryDir, &sharers, discoveryPort](
+                             const QString& appCastPath, const QString& name) {
+    auto process = std::make_unique<QProcess>();
+    process->start(QCoreApplication::applicationFilePath(),
+      { PEER_SHARER_ARGUMENT, server.url() + appCastPath, QDir(temporaryDir.path()).absoluteFilePath(name),
+        QString::number(discoveryPort) });
+    auto* const sharer = process.get();
+    sharers.push_back(std::move(process));
+    return QTest::qWaitFor(
+             [sharer]() {
+               return sharer->canReadLine() || sharer->state() == QProcess::NotRunning;
+             },
+             10000)
+           && sharer->readLine().trimmed() == PEER_SHARER_READY;
+  };
+
+  // Peer in this process.
+  QtUpdater::PeerOptions peerOptions;
+  peerOptions.enabled = true;
+  peerOptions.discoveryPort = discoveryPort;
+  peerOptions.discoveryAddress = "127.0.0.1";
+  peerOptions.discoveryTimeout = 1000;
+  const auto downloadInstaller = [&server, &temporaryDir, &peerOptions](
+                                   const QString& appCastPath, const QString& name) {
+    QtUpdater updater(server.url() + appCastPath);
+    updater.setTemporaryDirectoryPath(QDir(temporaryDir.path()).absoluteFilePath(name));
+    updater.setPeerOptions(peerOptions);
+    auto done = false;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+      updater.downloadInstaller();
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFinished, &updater, [&done]() {
+      done = true;
+    });
+    updater.forceCheckForUpdate();
+    return QTest::qWaitFor(
+             [&done]() {
+               return done;
+             },
+             updater.checkTimeout())
+           && updater.installerAvailable();
+  };
+
+  // The first process downloads from the server, then shares the installer. The second one shares another one.
+  QVERIFY(startSharer("/", "first"));
+  QCOMPARE(server.requestCount(installerPath), 1);
+  QVERIFY(startSharer("/other", "second"));
+  QCOMPARE(server.requestCount(otherInstallerPath), 1);
+
+  // The discovery reaches both processes, although they share the port: the installer comes from the first one.
+  QVERIFY(downloadInstaller("/", "third"));
+  QCOMPARE(server.requestCount(installerPath), 1);
+
+  // An MD5 checksum is too weak to trust a peer: the installer comes from the server, although a peer has it.
+  QVERIFY(startSharer("/md5", "fourth"));
+  QCOMPARE(server.requestCount(installerPath), 2);
+  QVERIFY(downloadInstaller("/md5", "fifth"));
+  QCOMPARE(server.requestCount(installerPath), 3);
+#endif
+}
+
+void Tests::test_installerMirrors() {
+  // The installer URL answers late. The first mirror answers first, but closes the connection in the middle
+  // of the installer: the download continues on the second one.
+  const auto installerData = getLargeInstallerData(256 * 1024);
+  const auto installerPath = getInstallerPath(LATEST_VERSION);
+  const auto fastMirrorPath = "/fast" + installerPath;
+  const auto slowMirrorPath = "/slow" + installerPath;
+  auto appCast =
+    QJsonDocument::fromJson(getAppCast(LATEST_VERSION, getInstallerChecksum(installerData)).toUtf8()).object();
+  appCast.insert("mirrors", QJsonArray{
+                              SERVER_URL_FOR_CLIENT + fastMirrorPath,
+                              QJsonObject{ { "url", SERVER_URL_FOR_CLIENT + slowMirrorPath }, { "weight", 2 } },
+                            });
+
+  TestServer server(SERVER_PORT);
+  server.serve("/", QJsonDocument(appCast).toJson(QJsonDocument::JsonFormat::Compact), CONTENT_TYPE_JSON);
+  FaultProfile lateProfile;
+  lateProfile.latency = std::chrono::milliseconds(1000);
+  server.serve(installerPath, installerData, CONTENT_TYPE_EXE, lateProfile);
+  FaultProfile droppingProfile;
+  droppingProfile.dropAtOffset = 100 * 1024;
+  server.serve(fastMirrorPath, installerData, CONTENT_TYPE_EXE, droppingProfile);
+  FaultProfile slowProfile;
+  slowProfile.latency = std::chrono::milliseconds(300);
+  server.serve(slowMirrorPath, installerData, CONTENT_TYPE_EXE, slowProfile);
+  QVERIFY(server.start());
+
+  // Own settings, where the fastest mirror is remembered.
+  const auto settingsParameters = QtUpdater::SettingsParameters{ QSettings::NativeFormat, QSettings::UserScope,
+    QCoreApplication::organizationName(), "MirrorsApplication" };
+  QSettings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+    settingsParameters.application)
+    .clear();
+
+  QTemporaryDir temporaryDir;
+  const auto downloadInstaller = [&server, &temporaryDir, &settingsParameters](const QString& name) {
+    QtUpdater updater(server.url(), settingsParameters);
+    updater.setTemporaryDirectoryPath(QDir(temporaryDir.path()).absoluteFilePath(name));
+    auto done = false;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+      updater.downloadInstaller();
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFinished, &updater, [&done]() {
+      done = true;
+    });
+    QObject::connect(&updater, &QtUpdater::installerDownloadFailed, &updater, [&done]() {
+      done = true;
+    });
+    updater.forceCheckForUpdate();
+    const auto finished = QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+    return finished && updater.installerAvailable();
+  };
+
+  // The mirrors are raced, then the download fails over without starting from scratch.
+  QVERIFY(downloadInstaller("first"));
+  QCOMPARE(server.requestCount(fastMirrorPath), 2);
+  const auto slowRangeHeaders = server.rangeHeaders(slowMirrorPath);
+  QCOMPARE(slowRangeHeaders.size(), 2);
+  QCOMPARE(slowRangeHeaders.at(0), QString("bytes=0-0"));
+  QVERIFY(slowRangeHeaders.at(1).startsWith("bytes="));
+  QVERIFY(slowRangeHeaders.at(1) != QString("bytes=0-"));
+  // The download reuses a connection of the check or of the race, instead of opening a new one.
+  const auto fastClientPorts = server.clientPorts(fastMirrorPath);
+  QCOMPARE(fastClientPorts.size(), 2);
+  const auto previousClientPorts =
+    server.clientPorts("/") + server.clientPorts(installerPath) + server.clientPorts(slowMirrorPath).mid(0, 1);
+  QVERIFY(fastClientPorts.at(1) == fastClientPorts.at(0) || previousClientPorts.contains(fastClientPorts.at(1)));
+
+  // The mirror that sent the end of the installer is remembered for this network: no race.
+  QVERIFY(downloadInstaller("second"));
+  QCOMPARE(server.requestCount(fastMirrorPath), 2);
+  QCOMPARE(server.requestCount(installerPath), 1);
+  QCOMPARE(server.rangeHeaders(slowMirrorPath).size(), 3);
+  QVERIFY(server.rangeHeaders(slowMirrorPath).at(2).isEmpty());
+}
+
+void Tests::test_hedgedCheck() {
+  // The server answers late, but an alternate endpoint answers immediately.
+  const auto appCast = getAppCast(LATEST_VERSION).toUtf8();
+  TestServer server(SERVER_PORT);
+  FaultProfile lateProfile;
+  lateProfile.latency = std::chrono::milliseconds(3000);
+  server.serve("/", appCast, CONTENT_TYPE_JSON, lateProfile);
+  server.serve("/alternate", appCast, CONTENT_TYPE_JSON);
+  QVERIFY(server.start());
+
+  // Own settings, where the check durations are kept.
+  const auto settingsParameters = QtUpdater::SettingsParameters{ QSettings::NativeFormat, QSettings::UserScope,
+    QCoreApplication::organizationName(), "HedgingApplication" };
+  QSettings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+    settingsParameters.application)
+    .clear();
+
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(server.url(), settingsParameters);
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+  QtUpdater::HedgingOptions hedgingOptions;
+  hedgingOptions.enabled = true;
+  hedgingOptions.initialDelay = 200;
+  hedgingOptions.alternateServerUrls = { server.url() + "/alternate" };
+  updater.setHedgingOptions(hedgingOptions);
+
+  auto done = false;
+  auto onlineFailed = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::checkForUpdateOnlineFailed, this, [&onlineFailed]() {
+    onlineFailed = true;
+  });
+
+  // The second request answers first: the first one is cancelled.
+  QElapsedTimer elapsedTimer;
+  elapsedTimer.start();
+  updater.forceCheckForUpdate();
+  QVERIFY(QTest::qWaitFor(
+    [&done]() {
+      return done;
+    },
+    updater.checkTimeout()));
+  QVERIFY(elapsedTimer.elapsed() < 3000);
+  QVERIFY(!onlineFailed);
+  QCOMPARE(updater.updateAvailability(), QtUpdater::UpdateAvailability::Available);
+  QCOMPARE(server.requestCount("/"), 1);
+  QCOMPARE(server.requestCount("/alternate"), 1);
+}
+
+void Tests::test_adaptiveTimeouts() {
+  // Server that doesn't answer in time.
+  TestServer server(SERVER_PORT);
+  FaultProfile lateProfile;
+  lateProfile.latency = std::chrono::milliseconds(5000);
+  server.serve("/", getAppCast(LATEST_VERSION).toUtf8(), CONTENT_TYPE_JSON, lateProfile);
+  QVERIFY(server.start());
+
+  // Own settings, where the statistics of the hosts are kept.
+  const auto settingsParameters = QtUpdater::SettingsParameters{ QSettings::NativeFormat, QSettings::UserScope,
+    QCoreApplication::organizationName(), "TimeoutsApplication" };
+  QSettings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+    settingsParameters.application)
+    .clear();
+  const auto hostStatistics = [&settingsParameters]() {
+    QSettings settings(settingsParameters.format, settingsParameters.scope, settingsParameters.organization,
+      settingsParameters.application);
+    return settings.value(QString("Update/HostStatistics/") + SERVER_URL).toString().split(',');
+  };
+
+  QTemporaryDir temporaryDir;
+  QtDownloader::TimeoutPolicy timeoutPolicy;
+  timeoutPolicy.enabled = true;
+  timeoutPolicy.minResponseTimeout = 200;
+  timeoutPolicy.maxResponseTimeout = 1000;
+  const auto check = [&server, &temporaryDir, &settingsParameters, &timeoutPolicy]() {
+    QtUpdater updater(server.url(), settingsParameters);
+    updater.setTemporaryDirectoryPath(temporaryDir.path());
+    updater.setTimeoutPolicy(timeoutPolicy);
+    auto done = false;
+    auto onlineFailed = false;
+    QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&done]() {
+      done = true;
+    });
+    QObject::connect(&updater, &QtUpdater::checkForUpdateOnlineFailed, &updater, [&onlineFailed]() {
+      onlineFailed = true;
+    });
+    updater.forceCheckForUpdate();
+    const auto finished = QTest::qWaitFor(
+      [&done]() {
+        return done;
+      },
+      updater.checkTimeout());
+    return finished && !onlineFailed;
+  };
+
+  // The check fails at the response deadline, instead of the transfer timeout.
+  QElapsedTimer elapsedTimer;
+  elapsedTimer.start();
+  QVERIFY(!check());
+  QVERIFY(elapsedTimer.elapsed() < 5000);
+  QCOMPARE(hostStatistics().value(1), QString("1"));
+
+  // The next check fails faster, as the server is probably down.
+  QVERIFY(!check());
+  QCOMPARE(hostStatistics().value(1), QString("2"));
+
+  // The server answers again: the failures are forgotten, and its time to first byte is known.
+  server.setFaultProfile("/", {});
+  QVERIFY(check());
+  const auto statistics = hostStatistics();
+  QCOMPARE(statistics.value(1), QString("0"));
+  QVERIFY(statistics.value(0).toDouble() >= 0.);
+}
+
+void Tests::test_localSource() {
+  // Directory provisioned with the appcast, next to the installer and the changelog.
+  QTemporaryDir shareDir;
+  const auto installerFileName = getInstallerPath(LATEST_VERSION).mid(1);
+  auto appCast = QJsonDocument::fromJson(getAppCast(LATEST_VERSION).toUtf8()).object();
+  appCast.insert("installerUrl", installerFileName);
+  appCast.insert("changelogUrl", "changelog.md");
+  const auto writeFile = [&shareDir](const QString& fileName, const QByteArray& data) {
+    QFile file(QDir(shareDir.path()).absoluteFilePath(fileName));
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+  };
+  QVERIFY(writeFile("appcast.json", QJsonDocument(appCast).toJson()));
+  QVERIFY(writeFile(installerFileName, DUMMY_INSTALLER_DATA));
+  QVERIFY(writeFile("changelog.md", DUMMY_CHANGELOG));
+
+  // No server: the directory is the source.
+  QTemporaryDir temporaryDir;
+  QtUpdater updater(shareDir.path());
+  updater.setTemporaryDirectoryPath(temporaryDir.path());
+
+  auto done = false;
+  auto failed = false;
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, this, [&updater]() {
+    updater.downloadInstaller();
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFinished, this, [&done]() {
+    done = true;
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFailed, this, [&done, &failed]() {
+    failed = true;
+    done = true;
+  });
+  updater.forceCheckForUpdate();
+  QVERIFY(QTest::qWaitFor(
+    [&done]() {
+      return done;
+    },
+    updater.checkTimeout()));
+  QVERIFY(!failed);
+  QCOMPARE(updater.updateAvailability(), QtUpdater::UpdateAvailability::Available);
+  QVERIFY(updater.installerAvailable());
+
+  // The installer is linked (or copied) in the temporary directory, and the original is untouched.
+  QFile installer(QDir(temporaryDir.path()).absoluteFilePath(installerFileName));
+  QVERIFY(installer.open(QIODevice::ReadOnly));
+  QCOMPARE(installer.readAll(), QByteArray(DUMMY_INSTALLER_DATA));
+  installer.close();
+  const auto sourcePath = QDir(shareDir.path()).absoluteFilePath(installerFileName);
+  QVERIFY(QFileInfo::exists(sourcePath));
+
+  // Installing makes the installer executable and moves it: the original keeps its permissions and its inode.
+  const auto sourcePermissions = QFile::permissions(sourcePath);
+  const auto sourceFileId = getFileId(sourcePath);
+  const auto appImagePath = QDir(temporaryDir.path()).absoluteFilePath("MyApp.AppImage");
+  QtAppImageInstallStrategy strategy(appImagePath);
+  QVERIFY(strategy.install({ installer.fileName(), QVersionNumber(2, 0, 0) }, nullptr)
+          == QtInstallStrategy::Result::Success);
+  QVERIFY(QFile::permissions(appImagePath) & QFileDevice::ExeOwner);
+  QCOMPARE(QFile::permissions(sourcePath), sourcePermissions);
+  QCOMPARE(getFileId(sourcePath), sourceFileId);
+  QCOMPARE(fileutils::hardLinkCount(sourcePath).value_or(0), quint64{ 1 });
+  QFile source(sourcePath);
+  QVERIFY(source.open(QIODevice::ReadOnly));
+  QCOMPARE(source.readAll(), QByteArray(DUMMY_INSTALLER_DATA));
+}
+
+int runPeerSharer(const QStringList& arguments) {
+  if (arguments.size() != 3) {
+    return EXIT_FAILURE;
+  }
+
+  QtUpdater::PeerOptions peerOptions;
+  peerOptions.enabled = true;
+  peerOptions.discoveryPort = static_cast<quint16>(arguments.at(2).toUInt());
+  peerOptions.discoveryAddress = "127.0.0.1";
+  peerOptions.discoveryTimeout = 1000;
+
+  // Own settings, so that the tests are not affected.
+  const auto settingsParameters = QtUpdater::SettingsParameters{ QSettings::NativeFormat, QSettings::UserScope,
+    QCoreApplication::organizationName(), "PeerSharerApplication" };
+  QtUpdater updater(arguments.at(0), settingsParameters);
+  updater.setTemporaryDirectoryPath(arguments.at(1));
+  updater.setPeerOptions(peerOptions);
+  QObject::connect(&updater, &QtUpdater::checkForUpdateFinished, &updater, [&updater]() {
+    updater.downloadInstaller();
+  });
+  // The installer is shared as soon as it is available.
+  QObject::connect(&updater, &QtUpdater::installerAvailableChanged, &updater, [&updater]() {
+    if (updater.installerAvailable()) {
+      std::printf("%s\n", PEER_SHARER_READY);
+      std::fflush(stdout);
+    }
+  });
+  QObject::connect(&updater, &QtUpdater::installerDownloadFailed, &updater, []() {
+    QCoreApplication::exit(EXIT_FAILURE);
+  });
+  updater.forceCheckForUpdate();
+  return QCoreApplication::exec();
+}
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <QObject>
+#include <QStringList>
+
+// Makes the test executable run a peer instead of the tests: see runPeerSharer().
+constexpr auto PEER_SHARER_ARGUMENT = "--peer-sharer";
 
 class Tests : public QObject {
   Q_OBJECT
@@ -18,9 +22,52 @@ private slots:
 
   void test_validChangelogUrl();
   void test_invalidChangelogUrl();
+  void test_changelogOptions();
+  void test_changelogDelta();
+  void test_changelogMerge();
 
   void test_validInstallerUrl();
   void test_invalidInstallerUrl();
 
   void test_cancel();
+
+  void test_binaryCache();
+  void test_persistedVerification();
+
+  void test_verifyFileChecksum();
+
+  void test_slowServer();
+  void test_serverError();
+  void test_droppedInstallerDownload();
+  void test_throttledInstallerDownload();
+  void test_progressPolicy();
+  void test_transferMetrics();
+
+  void test_blockManifestRepair();
+  void test_blockManifestMismatch();
+  void test_blockManifestScope();
+
+  void test_durableFiles();
+  void test_moveInstallerToDir();
+  void test_copyMethods();
+  void test_appImageInstallStrategy();
+  void test_archiveInstallStrategy();
+  void test_streamingExtraction();
+  void test_prefetch();
+  void test_prefetchPromotion();
+  void test_prefetchBusyEventLoop();
+  void test_workerThread();
+  void test_asyncApi();
+  void test_multipleApplications();
+  void test_updateAgent();
+  void test_sharedCache();
+  void test_peerDownload();
+  void test_installerMirrors();
+  void test_hedgedCheck();
+  void test_adaptiveTimeouts();
+  void test_localSource();
 };
+
+// Downloads the installer, then shares it with the peers of the machine until killed. Used by test_peerDownload,
+// in child processes, to test peers of several processes. Arguments: appcast URL, temporary directory, discovery port.
+int runPeerSharer(const QStringList& arguments);
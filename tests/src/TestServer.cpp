@@ -0,0 +1,203 @@
+#include "TestServer.hpp"
+
+#include <httplib.h>
+
+#include <algorithm>
+
+namespace {
+constexpr auto SERVER_HOST = "0.0.0.0";
+constexpr auto SERVER_URL = "localhost";
+constexpr auto ANY_PATH_REGEX = R"(.*)";
+constexpr auto HEADER_RANGE = "Range";
+constexpr auto HEADER_RETRY_AFTER = "Retry-After";
+constexpr auto CONTENT_TYPE_TEXT = "text/plain";
+constexpr auto INJECTED_ERROR_CONTENT = "Injected error";
+
+// Maximum size of a written chunk.
+constexpr qint64 CHUNK_SIZE = 64 * 1024;
+// When throttled, chunks are sized so that the server writes this many times per second.
+constexpr qint64 THROTTLE_WRITES_PER_SECOND = 20;
+} // namespace
+
+TestServer::TestServer(int port)
+  : _port(port)
+  , _server(std::make_unique<httplib::Server>()) {
+  _server->Get(ANY_PATH_REGEX, [this](const httplib::Request& request, httplib::Response& response) {
+    std::shared_ptr<Resource> resource;
+    FaultProfile profile;
+    auto fail = false;
+    auto drop = false;
+    auto corrupt = false;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const auto it = _resources.find(QString::fromStdString(request.path));
+      if (it == _resources.end()) {
+        response.status = 404;
+        return;
+      }
+
+      resource = it->second;
+      profile = resource->profile;
+      resource->requestCount++;
+      resource->rangeHeaders.append(QString::fromStdString(request.get_header_value(HEADER_RANGE)));
+      resource->clientPorts.append(request.remote_port);
+
+      if (profile.errorStatus > 0 && (profile.errorCount < 0 || resource->failed < profile.errorCount)) {
+        resource->failed++;
+        fail = true;
+      } else if (profile.dropAtOffset >= 0 && (profile.dropCount < 0 || resource->dropped < profile.dropCount)) {
+        resource->dropped++;
+        drop = true;
+      }
+
+      if (profile.corruptAtOffset >= 0 && (profile.corruptCount < 0 || resource->corrupted < profile.corruptCount)) {
+        resource->corrupted++;
+        corrupt = true;
+      }
+    }
+
+    if (profile.latency.count() > 0) {
+      std::this_thread::sleep_for(profile.latency);
+    }
+
+    if (fail) {
+      response.status = profile.errorStatus;
+      if (profile.retryAfter >= 0) {
+        response.set_header(HEADER_RETRY_AFTER, std::to_string(profile.retryAfter));
+      }
+      response.set_content(INJECTED_ERROR_CONTENT, CONTENT_TYPE_TEXT);
+      return;
+    }
+
+    const auto dropAtOffset = drop ? profile.dropAtOffset : qint64{ -1 };
+    const auto corruptAtOffset = corrupt ? profile.corruptAtOffset : qint64{ -1 };
+    const auto bytesPerSecond = profile.bytesPerSecond;
+    const auto writeChunk = [resource, dropAtOffset, corruptAtOffset, bytesPerSecond](
+                              size_t offset, size_t length, httplib::DataSink& sink) {
+      const auto position = static_cast<qint64>(offset);
+      if (dropAtOffset >= 0 && position >= dropAtOffset) {
+        // Returning false closes the connection.
+        return false;
+      }
+
+      auto chunkLength = std::min(static_cast<qint64>(length), CHUNK_SIZE);
+      if (bytesPerSecond > 0) {
+        chunkLength = std::min(chunkLength, std::max(qint64{ 1 }, bytesPerSecond / THROTTLE_WRITES_PER_SECOND));
+      }
+      if (dropAtOffset >= 0) {
+        chunkLength = std::min(chunkLength, dropAtOffset - position);
+      }
+
+      auto data = resource->reader(position, chunkLength);
+      if (corruptAtOffset >= position && corruptAtOffset < position + data.size()) {
+        const auto index = static_cast<int>(corruptAtOffset - position);
+        data[index] = static_cast<char>(~data.at(index));
+      }
+      if (!sink.write(data.constData(), static_cast<size_t>(data.size()))) {
+        return false;
+      }
+
+      if (bytesPerSecond > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(chunkLength * 1000 / bytesPerSecond));
+      }
+      return true;
+    };
+
+    if (profile.chunked) {
+      const auto size = resource->size;
+      response.set_chunked_content_provider(
+        resource->contentType, [size, writeChunk](size_t offset, httplib::DataSink& sink) {
+          if (static_cast<qint64>(offset) >= size) {
+            sink.done();
+            return true;
+          }
+          return writeChunk(offset, static_cast<size_t>(size) - offset, sink);
+        });
+    } else {
+      response.set_content_provider(static_cast<size_t>(resource->size), resource->contentType, writeChunk);
+    }
+  });
+}
+
+TestServer::~TestServer() {
+  stop();
+}
+
+bool TestServer::start() {
+  if (_server->is_running()) {
+    return true;
+  }
+
+  _thread = std::thread([this]() {
+    _server->listen(SERVER_HOST, _port);
+  });
+  _server->wait_until_ready();
+
+  if (!_server->is_running()) {
+    _thread.join();
+    return false;
+  }
+  return true;
+}
+
+void TestServer::stop() {
+  _server->stop();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+QString TestServer::url() const {
+  return "http://" + QString(SERVER_URL) + ':' + QString::number(_port);
+}
+
+void TestServer::serve(
+  const QString& path, const QByteArray& content, const std::string& contentType, const FaultProfile& profile) {
+  serve(
+    path, content.size(),
+    [content](qint64 offset, qint64 length) {
+      return content.mid(static_cast<int>(offset), static_cast<int>(length));
+    },
+    contentType, profile);
+}
+
+void TestServer::serve(const QString& path, qint64 size, ContentReader&& reader, const std::string& contentType,
+  const FaultProfile& profile) {
+  auto resource = std::make_shared<Resource>();
+  resource->size = size;
+  resource->reader = std::move(reader);
+  resource->contentType = contentType;
+  resource->profile = profile;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _resources[path] = std::move(resource);
+}
+
+void TestServer::setFaultProfile(const QString& path, const FaultProfile& profile) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _resources.find(path);
+  if (it != _resources.end()) {
+    it->second->profile = profile;
+    it->second->dropped = 0;
+    it->second->failed = 0;
+    it->second->corrupted = 0;
+  }
+}
+
+int TestServer::requestCount(const QString& path) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _resources.find(path);
+  return it != _resources.end() ? it->second->requestCount : 0;
+}
+
+QStringList TestServer::rangeHeaders(const QString& path) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _resources.find(path);
+  return it != _resources.end() ? it->second->rangeHeaders : QStringList{};
+}
+
+QList<int> TestServer::clientPorts(const QString& path) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _resources.find(path);
+  return it != _resources.end() ? it->second->clientPorts : QList<int>{};
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace httplib {
+class Server;
+}
+
+/**
+ * @brief Faults to inject when serving a resource.
+ */
+struct FaultProfile {
+  // Delay before sending the response headers.
+  std::chrono::milliseconds latency{ 0 };
+  // Maximum body throughput, in bytes per second (0 means unlimited).
+  qint64 bytesPerSecond{ 0 };
+  // Close the connection once the body reaches this offset (-1 means never).
+  qint64 dropAtOffset{ -1 };
+  // Number of requests to drop before serving normally (-1 means always).
+  int dropCount{ -1 };
+  // Flip the byte at this offset of the body (-1 means never).
+  qint64 corruptAtOffset{ -1 };
+  // Number of requests to corrupt before serving normally (-1 means always).
+  int corruptCount{ -1 };
+  // Error status to answer (e.g. 429, 503), instead of the content (0 means none).
+  int errorStatus{ 0 };
+  // Number of requests to fail with errorStatus before serving normally (-1 means always).
+  int errorCount{ -1 };
+  // Value of the Retry-After header sent with errorStatus, in seconds (-1 means no header).
+  int retryAfter{ -1 };
+  // Send the body with chunked transfer encoding. Range requests are ignored.
+  bool chunked{ false };
+};
+
+/**
+ * @brief Local HTTP server that can inject latency, throttle bandwidth, drop connections and
+ * return errors, to test the network code deterministically.
+ *
+ * Range requests are supported, unless the resource is chunked.
+ */
+class TestServer {
+public:
+  // Reads `length` bytes at `offset` of a resource.
+  using ContentReader = std::function<QByteArray(qint64 offset, qint64 length)>;
+
+  explicit TestServer(int port);
+  ~TestServer();
+
+  bool start();
+  void stop();
+  QString url() const;
+
+  void serve(const QString& path, const QByteArray& content, const std::string& contentType,
+    const FaultProfile& profile = {});
+  void serve(const QString& path, qint64 size, ContentReader&& reader, const std::string& contentType,
+    const FaultProfile& profile = {});
+  void setFaultProfile(const QString& path, const FaultProfile& profile);
+
+  int requestCount(const QString& path) const;
+  // The Range headers received for the resource, in order (empty string if none).
+  QStringList rangeHeaders(const QString& path) const;
+  // The port of the client for each request to the resource, in order: requests sent over the same connection
+  // have the same port.
+  QList<int> clientPorts(const QString& path) const;
+
+private:
+  struct Resource {
+    qint64 size{ 0 };
+    ContentReader reader;
+    std::string contentType;
+    FaultProfile profile;
+    int requestCount{ 0 };
+    int dropped{ 0 };
+    int corrupted{ 0 };
+    int failed{ 0 };
+    QStringList rangeHeaders;
+    QList<int> clientPorts;
+  };
+
+  int _port{ 0 };
+  std::unique_ptr<httplib::Server> _server;
+  std::thread _thread;
+  mutable std::mutex _mutex;
+  std::map<QString, std::shared_ptr<Resource>> _resources;
+};
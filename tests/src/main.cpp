@@ -12,6 +12,12 @@ int main(int argc, char* argv[]) {
   QCoreApplication::setOrganizationName("oclero");
   QCoreApplication app(argc, argv);
 
+  // Child process of the tests.
+  const auto arguments = QCoreApplication::arguments();
+  if (arguments.value(1) == PEER_SHARER_ARGUMENT) {
+    return runPeerSharer(arguments.mid(2));
+  }
+
   Tests tests;
   const auto success = QTest::qExec(&tests) == 0;
   return success ? EXIT_SUCCESS : EXIT_FAILURE;